@@ -20,24 +20,82 @@
   */
 
 /**
+  * CHANGELOG
+  * ---------
+  *
+  * --------------------------------------------------------------------------- 
   * Modified for EECE 344
   * CSU, Chico
   * Spring 2012
   * Prof. Kredo
+  * --------------------------------------------------------------------------- 
+  * Delay() counted loop iterations so it depended on SYSCLK.
+  * With USE_TICK defined it waits for milliseconds using the SysTick
+  * time base (tick.h), the scroll speed is the milliseconds per step.
+  * Projects without tick.c (Lab 1) keep the counted loop.
+  *
+  * Added support for the '+' character (C_plus), the sign of the
+  * Lab 2 result.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 10:12:03 -0700
+  * --------------------------------------------------------------------------- 
+  * Characters are written to a shadow of the LCD RAM (LCD_GLASS_SetChar())
+  * and LCD_GLASS_Commit() writes only the registers which changed with a
+  * single update request.  Digits whose segments are the same are skipped.
+  * LCD_GLASS_ShowString() replaces a clear followed by a display string,
+  * so the unchanged digits do not flicker.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 15:40:21 -0700
+  * --------------------------------------------------------------------------- 
+  * LCD_Conv_Char_Seg() is replaced by tables, CharSegMap[] for the segments
+  * of each ASCII character and digit_bits[] for the COM register bits of a
+  * digit nibble at each position.  A character is now a few table loads.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 19:05:48 -0700
+  * --------------------------------------------------------------------------- 
+  * LCD_GLASS_ScrollString() scrolls a string without blocking.  The string
+  * is kept in a ring and advanced from the LCD start of frame interrupt
+  * (LCD_IRQHandler()), so the processor can do other work or sleep.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 21:14:37 -0700
+  * --------------------------------------------------------------------------- 
+  * LCD_GLASS_Configure_GPIO() configures the pins from a table with
+  * GPIO_InitBatch(), each GPIO register is written once per port rather
+  * than twice for each pin by GPIO_Init() and once more for each of the
+  * 28 pins by GPIO_PinAFConfig().
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 23:09:41 -0700
+  * --------------------------------------------------------------------------- 
   */
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l_discovery_lcd.h"
 #include "discover_board.h"
 #include "stm32l1xx_lcd.h"
+#ifdef USE_TICK
+#include "tick.h"
 
+/* Delay for a period of time (milliseconds) */
+void Delay(uint32_t delay){
+  delay_ms(delay);
+}
+#else
 /* Delay for a period of time */
 void Delay(uint32_t delay){
   for(int i = 0; i < delay; i++);
 }
+#endif
 
 /* LCD BAR status: We don't write directly in LCD RAM for save the bar setting */
 uint8_t t_bar[2]={0x0,0X0};
+
+/* String scrolled by LCD_GLASS_ScrollString(), advanced by LCD_IRQHandler() */
+static uint8_t scroll_ring[SCROLL_RING_LEN];
+static volatile uint8_t scroll_len = 0;     /* 0 if not scrolling */
+static volatile uint8_t scroll_pos;         /* first character shown */
+static volatile uint16_t scroll_count;      /* scrolls left, 0 for ever */
+static uint16_t scroll_frames;              /* frames per step */
+static volatile uint16_t scroll_wait;       /* frames until the next step */
 		
 /*  =========================================================================
                                  LCD MAPPING
@@ -71,25 +129,92 @@ MSB   { 1 , 1 , 0 , 0   }
 
 */
 
-/* Constant table for cap characters 'A' --> 'Z' */
-const uint16_t CapLetterMap[26]=
+/* Shadow of the LCD RAM registers used by the glass (COM0 to COM3),
+   written to the LCD by LCD_GLASS_Commit() */
+static uint32_t fb_ram[4];
+static const uint8_t fb_reg[4] = {LCD_RAMRegister_0, LCD_RAMRegister_2,
+                                  LCD_RAMRegister_4, LCD_RAMRegister_6};
+/* fb_ram registers changed since the last commit, bit 0 for COM0 ... */
+static uint8_t fb_dirty = 0;
+/* Segments shown at each position (1 to 6), to skip those that are the same */
+static uint16_t fb_seg[7];
+
+/* Segment bits of each position (1 to 6) in the COM registers, cleared
+   before the new segments are set */
+static const uint32_t digit_mask[7][4] =
     {
+        {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+        {0xcffffffc, 0xcffffffc, 0xcffffffc, 0xcffffffc},
+        {0xf3ffff03, 0xf3ffff03, 0xf3ffff03, 0xf3ffff03},
+        {0xfcfffcff, 0xfcfffcff, 0xfcfffcff, 0xfcfffcff},
+        {0xffcff3ff, 0xffcff3ff, 0xffcff3ff, 0xffcff3ff},
+        {0xfff3cfff, 0xfff3cfff, 0xfff3efff, 0xfff3efff},
+        {0xfffc3fff, 0xfffc3fff, 0xfffc3fff, 0xfffc3fff}
+    };
+
+/* Segments of each ASCII character, the four nibbles are the digit bits
+   of COM0 to COM3 (see LCD MAPPING above).
+   Lower case letters are the same as upper case except 'm' and 'n',
+   characters which can not be displayed are blank. */
+const uint16_t CharSegMap[128]=
+    {
+        [' '] = 0x0000, ['*'] = star,    ['-'] = C_minus, ['+'] = C_plus,
+        ['/'] = C_slatch, ['%'] = C_percent_2,
+
+        /* 0      1      2      3      4      5      6      7      8      9  */
+        ['0'] =
+        0x5F00,0x4200,0xF500,0x6700,0xEa00,0xAF00,0xBF00,0x04600,0xFF00,0xEF00,
+
+        ['A'] =
         /* A      B      C      D      E      F      G      H      I  */
         0xFE00,0x6714,0x1d00,0x4714,0x9d00,0x9c00,0x3f00,0xfa00,0x0014,
         /* J      K      L      M      N      O      P      Q      R  */
         0x5300,0x9841,0x1900,0x5a48,0x5a09,0x5f00,0xFC00,0x5F01,0xFC01,
         /* S      T      U      V      W      X      Y      Z  */
+        0xAF00,0x0414,0x5b00,0x18c0,0x5a81,0x00c9,0x0058,0x05c0,
+
+        ['a'] =
+        /* a      b      c      d      e      f      g      h      i  */
+        0xFE00,0x6714,0x1d00,0x4714,0x9d00,0x9c00,0x3f00,0xfa00,0x0014,
+        /* j      k      l      m      n      o      p      q      r  */
+        0x5300,0x9841,0x1900,C_mMap,C_nMap,0x5f00,0xFC00,0x5F01,0xFC01,
+        /* s      t      u      v      w      x      y      z  */
         0xAF00,0x0414,0x5b00,0x18c0,0x5a81,0x00c9,0x0058,0x05c0
     };
 
-/* Constant table for number '0' --> '9' */
-const uint16_t NumberMap[10]=
+/* Segment bits set in each COM register for a digit nibble at each
+   position (1 to 6), generated from the bit positions of the glass */
+#define DIGIT_POS1(d, com) ((((d) & 0x0c) << 26 ) | ((d) & 0x03))
+#define DIGIT_POS2(d, com) ((((d) & 0x0c) << 24 ) | (((d) & 0x02) << 6 ) | (((d) & 0x01) << 2 ))
+#define DIGIT_POS3(d, com) ((((d) & 0x0c) << 22 ) | (((d) & 0x03) << 8 ))
+#define DIGIT_POS4(d, com) ((((d) & 0x0c) << 18 ) | (((d) & 0x03) << 10 ))
+/* no Col or DP at positions 5 and 6, those bits are used by the bar */
+#define DIGIT_POS5(d, com) ((((d) & 0x0c) << 16 ) | (((d) & ((com) < 2 ? 0x03 : 0x01)) << 12 ))
+#define DIGIT_POS6(d, com) ((((d) & 0x04) << 15 ) | (((d) & 0x08) << 13 ) | (((d) & ((com) < 2 ? 0x03 : 0x01)) << 14 ))
+
+#define DIGIT_NIBBLES(POS, com) \
+    { POS(0x0, com), POS(0x1, com), POS(0x2, com), POS(0x3, com), \
+      POS(0x4, com), POS(0x5, com), POS(0x6, com), POS(0x7, com), \
+      POS(0x8, com), POS(0x9, com), POS(0xa, com), POS(0xb, com), \
+      POS(0xc, com), POS(0xd, com), POS(0xe, com), POS(0xf, com) }
+
+#define DIGIT_COMS(POS) \
+    { DIGIT_NIBBLES(POS, 0), DIGIT_NIBBLES(POS, 1), \
+      DIGIT_NIBBLES(POS, 2), DIGIT_NIBBLES(POS, 3) }
+
+static const uint32_t digit_bits[7][4][16] =
     {
-        /* 0      1      2      3      4      5      6      7      8      9  */
-        0x5F00,0x4200,0xF500,0x6700,0xEa00,0xAF00,0xBF00,0x04600,0xFF00,0xEF00
+        {{0}},
+        DIGIT_COMS(DIGIT_POS1),
+        DIGIT_COMS(DIGIT_POS2),
+        DIGIT_COMS(DIGIT_POS3),
+        DIGIT_COMS(DIGIT_POS4),
+        DIGIT_COMS(DIGIT_POS5),
+        DIGIT_COMS(DIGIT_POS6)
     };
 
-static void LCD_Conv_Char_Seg(uint8_t* c,bool point,bool column,uint8_t* digit);
+static uint16_t LCD_Char_Seg(uint8_t c, bool point, bool column);
+static void LCD_Scroll_Show(void);
 
 /**
   * @brief  Configures the LCD GLASS relative GPIO port IOs and LCD peripheral.
@@ -99,6 +224,7 @@ static void LCD_Conv_Char_Seg(uint8_t* c,bool point,bool column,uint8_t* digit);
 void LCD_GLASS_Init(void)
 {
   LCD_InitTypeDef LCD_InitStruct;
+  NVIC_InitTypeDef NVIC_InitStructure;
 
   LCD_InitStruct.LCD_Prescaler = LCD_Prescaler_1;
   LCD_InitStruct.LCD_Divider = LCD_Divider_31;
@@ -134,76 +260,43 @@ void LCD_GLASS_Init(void)
 
   LCD_BlinkConfig(LCD_BlinkMode_Off,LCD_BlinkFrequency_Div32);	
   LCD_GLASS_Clear();
+
+  /* The start of frame interrupt for LCD_GLASS_ScrollString(), it is
+     only enabled in the LCD while scrolling */
+  NVIC_InitStructure.NVIC_IRQChannel = LCD_IRQn;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 3;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&NVIC_InitStructure);
 }
 
+/* The LCD pins of each port, all in the LCD alternate function */
+static const GPIO_BatchTypeDef LCD_GPIO[] =
+{
+  {GPIOA, {GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_8 | GPIO_Pin_9 | GPIO_Pin_10 | GPIO_Pin_15,
+           GPIO_Mode_AF, GPIO_Speed_400KHz, GPIO_OType_PP, GPIO_PuPd_NOPULL}, GPIO_AF_LCD},
+  {GPIOB, {GPIO_Pin_3 | GPIO_Pin_4 | GPIO_Pin_5 | GPIO_Pin_8 | GPIO_Pin_9 | GPIO_Pin_10 | GPIO_Pin_11
+           | GPIO_Pin_12 | GPIO_Pin_13 | GPIO_Pin_14 | GPIO_Pin_15,
+           GPIO_Mode_AF, GPIO_Speed_400KHz, GPIO_OType_PP, GPIO_PuPd_NOPULL}, GPIO_AF_LCD},
+  {GPIOC, {GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_6 | GPIO_Pin_7 | GPIO_Pin_8
+           | GPIO_Pin_9 | GPIO_Pin_10 | GPIO_Pin_11,
+           GPIO_Mode_AF, GPIO_Speed_400KHz, GPIO_OType_PP, GPIO_PuPd_NOPULL}, GPIO_AF_LCD},
+};
+
 /**
   * @brief  To initialize the LCD pins
   * @caller main
   * @param None
   * @retval None
   */
-
 void LCD_GLASS_Configure_GPIO(void)
 {
-  GPIO_InitTypeDef GPIO_InitStructure;
-
 /* Enable GPIOs clock */ 	
   RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA | RCC_AHBPeriph_GPIOB | RCC_AHBPeriph_GPIOC |
                         RCC_AHBPeriph_GPIOD | RCC_AHBPeriph_GPIOE | RCC_AHBPeriph_GPIOH, ENABLE);
 
-
-/* Configure Output for LCD */
-/* Port A */
-  GPIO_StructInit(&GPIO_InitStructure);
-  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_8 | GPIO_Pin_9 |GPIO_Pin_10 |GPIO_Pin_15;
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
-  GPIO_Init( GPIOA, &GPIO_InitStructure);
-
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource1,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource2,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource3,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource8,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource9,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource10,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOA, GPIO_PinSource15,GPIO_AF_LCD) ;
-
-/* Configure Output for LCD */
-/* Port B */
-  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_3 | GPIO_Pin_4 | GPIO_Pin_5 | GPIO_Pin_8 | GPIO_Pin_9 \
-                                 | GPIO_Pin_10 | GPIO_Pin_11 | GPIO_Pin_12 | GPIO_Pin_13 | GPIO_Pin_14 | GPIO_Pin_15;
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
-  GPIO_Init( GPIOB, &GPIO_InitStructure);
-
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource3,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource4,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource5,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource8,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource9,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource10,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource11,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource12,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource13,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource14,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOB, GPIO_PinSource15,GPIO_AF_LCD) ;
-
-/* Configure Output for LCD */
-/* Port C*/
-  GPIO_InitStructure.GPIO_Pin = GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_6 \
-                                 | GPIO_Pin_7 | GPIO_Pin_8 | GPIO_Pin_9 | GPIO_Pin_10 |GPIO_Pin_11 ;
-  GPIO_InitStructure.GPIO_Mode = GPIO_Mode_AF;
-  GPIO_Init( GPIOC, &GPIO_InitStructure);
-
-
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource0,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource1,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource2,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource3,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource6,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource7,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource8,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource9,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource10,GPIO_AF_LCD) ;
-  GPIO_PinAFConfig(GPIOC, GPIO_PinSource11,GPIO_AF_LCD) ;
+/* Configure Output for LCD, Port A, B and C, each register written once */
+  GPIO_InitBatch(LCD_GPIO, sizeof(LCD_GPIO) / sizeof(LCD_GPIO[0]));
 
 /* Disable GPIOs clock */ 	
   RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA | RCC_AHBPeriph_GPIOB | RCC_AHBPeriph_GPIOC |
@@ -254,225 +347,135 @@ void LCD_bar()
 }
 
 /**
-  * @brief  Converts an ascii char to the a LCD digit.
+  * @brief  Converts an ascii char to the segments of a LCD digit.
   * @param  c: a char to display.
   * @param  point: a point to add in front of char
   *         This parameter can be: POINT_OFF or POINT_ON
   * @param  column : flag indicating if a column has to be add in front
   *         of displayed character.
   *         This parameter can be: COLUMN_OFF or COLUMN_ON.
-	* @param 	digit array with segment
-  * @retval None
+  * @retval the segments, COM0 in the highest nibble
   */
-static void LCD_Conv_Char_Seg(uint8_t* c,bool point,bool column, uint8_t* digit)
+static uint16_t LCD_Char_Seg(uint8_t c, bool point, bool column)
 {
-  uint16_t ch = 0 ;
-  uint8_t i,j;
-
-  switch (*c)
-    {
-    case ' ' :
-      ch = 0x00;
-      break;
-
-    case '*':
-      ch = star;
-      break;
-
-    case '' :
-      ch = C_UMAP;
-      break;
-
-    case 'm' :
-      ch = C_mMap;
-      break;
-
-    case 'n' :
-      ch = C_nMap;
-      break;					
-
-    case '-' :
-      ch = C_minus;
-      break;
-
-    case '/' :
-      ch = C_slatch;
-      break;
-
-    case '' :
-      ch = C_percent_1;
-      break;
-    case '%' :
-      ch = C_percent_2;
-      break;
-    case 255 :
-      ch = C_full;
-      break ;
-
-    case '0':
-    case '1':
-    case '2':
-    case '3':
-    case '4':
-    case '5':
-    case '6':
-    case '7':
-    case '8':
-    case '9':			
-      ch = NumberMap[*c-0x30];		
-      break;
-
-    default:
-      /* The character c is one letter in upper case*/
-      if ( (*c < 0x5b) && (*c > 0x40) )
-      {
-        ch = CapLetterMap[*c-'A'];
-      }
-      /* The character c is one letter in lower case*/
-      if ( (*c <0x7b) && ( *c> 0x60) )
-      {
-        ch = CapLetterMap[*c-'a'];
-      }
-      break;
-  }
+  uint16_t ch;
+
+  if (c < 128)
+    ch = CharSegMap[c];
+  else if (c == 0xb5)   /* micro */
+    ch = C_UMAP;
+  else if (c == 0xb0)   /* degree */
+    ch = C_percent_1;
+  else if (c == 255)
+    ch = C_full;
+  else
+    ch = 0x00;
 
   /* Set the digital point can be displayed if the point is on */
   if (point)
-  {
     ch |= 0x0002;
-  }
 
   /* Set the "COL" segment in the character that can be displayed if the column is on */
   if (column)
-  {
     ch |= 0x0020;
-  }		
 
-  for (i = 12,j=0 ;j<4; i-=4,j++)
-  {
-    digit[j] = (ch >> i) & 0x0f; //To isolate the less signifiant dibit
-  }
+  return ch;
 }
 
 /**
-  * @brief  This function writes a char in the LCD frame buffer.
+  * @brief  This function writes a char in the shadow of the LCD RAM.
+  *         It is displayed by the next LCD_GLASS_Commit().
   * @param  ch: the character to display.
   * @param  point: a point to add in front of char
   *         This parameter can be: POINT_OFF or POINT_ON
   * @param  column: flag indicating if a column has to be add in front
   *         of displayed character.
   *         This parameter can be: COLUMN_OFF or COLUMN_ON.
-  * @param  position: position in the LCD of the caracter to write [0:7]
+  * @param  position: position in the LCD of the caracter to write [1:6]
   * @retval None
-  * @par    Required preconditions: The LCD should be cleared before to start the
-  *         write operation.
   */
-void LCD_GLASS_WriteChar(uint8_t* ch, bool point, bool column, uint8_t position)
+void LCD_GLASS_SetChar(uint8_t* ch, bool point, bool column, uint8_t position)
+{
+  uint16_t seg;
+  uint32_t ram;
+  uint8_t com;
+
+  if ((position < 1) || (position > 6))
+    return;
+
+  seg = LCD_Char_Seg(*ch, point, column);
+
+/* Nothing to do if the same segments are already there */
+  if (seg == fb_seg[position])
+    return;
+  fb_seg[position] = seg;
+
+  for (com = 0; com < 4; com++)
+  {
+    ram = (fb_ram[com] & digit_mask[position][com])
+            | digit_bits[position][com][(seg >> (12 - 4 * com)) & 0x0f];
+    if (ram != fb_ram[com])
+    {
+      fb_ram[com] = ram;
+      fb_dirty |= 1 << com;
+    }
+  }
+}
+
+/**
+  * @brief  Writes the changed registers of the shadow, and the bar, to the
+  *         LCD RAM and requests a single update of the display.
+  * @param  None
+  * @retval None
+  */
+void LCD_GLASS_Commit(void)
 {
-  uint8_t digit[4];     /* Digit frame buffer */
+  uint32_t ram;
+  uint8_t com;
+
+/* bar1 bar3 in COM2, bar0 bar2 in COM3 (see LCD_bar()) */
+  for (com = 2; com < 4; com++)
+  {
+    ram = (fb_ram[com] & 0xffff5fff) | (uint32_t)(t_bar[com - 2] << 12);
+    if (ram != fb_ram[com])
+    {
+      fb_ram[com] = ram;
+      fb_dirty |= 1 << com;
+    }
+  }
 
-/* To convert displayed character in segment in array digit */
-  LCD_Conv_Char_Seg(ch,point,column,digit);
+  if (fb_dirty == 0)
+    return;
 
 /* TO wait LCD Ready */
   while( LCD_GetFlagStatus (LCD_FLAG_UDR) != RESET) ;
 
-  switch (position)
+  for (com = 0; com < 4; com++)
   {
-    /* Position 1 on LCD (Digit1)*/
-    case 1:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xcffffffc;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xcffffffc;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xcffffffc;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xcffffffc;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x0c) << 26 ) | (digit[0]& 0x03) ; // 1G 1B 1M 1E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x0c) << 26 ) | (digit[1]& 0x03) ; // 1F 1A 1C 1D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x0c) << 26 ) | (digit[2]& 0x03) ; // 1Q 1K 1Col 1P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x0c) << 26 ) | (digit[3]& 0x03) ; // 1H 1J 1DP 1N
-
-      break;
-
-    /* Position 2 on LCD (Digit2)*/
-    case 2:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xf3ffff03;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xf3ffff03;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xf3ffff03;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xf3ffff03;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x0c) << 24 )|((digit[0]& 0x02) << 6 )|((digit[0]& 0x01) << 2 ) ; // 2G 2B 2M 2E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x0c) << 24 )|((digit[1]& 0x02) << 6 )|((digit[1]& 0x01) << 2 ) ; // 2F 2A 2C 2D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x0c) << 24 )|((digit[2]& 0x02) << 6 )|((digit[2]& 0x01) << 2 ) ; // 2Q 2K 2Col 2P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x0c) << 24 )|((digit[3]& 0x02) << 6 )|((digit[3]& 0x01) << 2 ) ; // 2H 2J 2DP 2N
-
-      break;
-
-    /* Position 3 on LCD (Digit3)*/
-    case 3:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xfcfffcff;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xfcfffcff;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xfcfffcff;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xfcfffcff;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x0c) << 22 ) | ((digit[0]& 0x03) << 8 ) ; // 3G 3B 3M 3E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x0c) << 22 ) | ((digit[1]& 0x03) << 8 ) ; // 3F 3A 3C 3D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x0c) << 22 ) | ((digit[2]& 0x03) << 8 ) ; // 3Q 3K 3Col 3P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x0c) << 22 ) | ((digit[3]& 0x03) << 8 ) ; // 3H 3J 3DP 3N
-
-      break;
-
-    /* Position 4 on LCD (Digit4)*/
-    case 4:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xffcff3ff;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xffcff3ff;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xffcff3ff;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xffcff3ff;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x0c) << 18 ) | ((digit[0]& 0x03) << 10 ) ; // 4G 4B 4M 4E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x0c) << 18 ) | ((digit[1]& 0x03) << 10 ) ; // 4F 4A 4C 4D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x0c) << 18 ) | ((digit[2]& 0x03) << 10 ) ; // 4Q 4K 4Col 4P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x0c) << 18 ) | ((digit[3]& 0x03) << 10 ) ; // 4H 4J 4DP 4N
-
-      break;
-
-    /* Position 5 on LCD (Digit5)*/
-    case 5:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xfff3cfff;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xfff3cfff;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xfff3efff;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xfff3efff;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x0c) << 16 ) | ((digit[0]& 0x03) << 12 ) ; // 5G 5B 5M 5E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x0c) << 16 ) | ((digit[1]& 0x03) << 12 ) ; // 5F 5A 5C 5D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x0c) << 16 ) | ((digit[2]& 0x01) << 12 ) ; // 5Q 5K   5P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x0c) << 16 ) | ((digit[3]& 0x01) << 12 ) ; // 5H 5J   5N
-
-      break;
-
-    /* Position 6 on LCD (Digit6)*/
-    case 6:
-      LCD->RAM[LCD_RAMRegister_0] &= 0xfffc3fff;
-      LCD->RAM[LCD_RAMRegister_2] &= 0xfffc3fff;
-      LCD->RAM[LCD_RAMRegister_4] &= 0xfffc3fff;
-      LCD->RAM[LCD_RAMRegister_6] &= 0xfffc3fff;
-
-      LCD->RAM[LCD_RAMRegister_0] |= ((digit[0]& 0x04) << 15 ) | ((digit[0]& 0x08) << 13 ) | ((digit[0]& 0x03) << 14 ) ; // 6B 6G 6M 6E	
-      LCD->RAM[LCD_RAMRegister_2] |= ((digit[1]& 0x04) << 15 ) | ((digit[1]& 0x08) << 13 ) | ((digit[1]& 0x03) << 14 ) ; // 6A 6F 6C 6D
-      LCD->RAM[LCD_RAMRegister_4] |= ((digit[2]& 0x04) << 15 ) | ((digit[2]& 0x08) << 13 ) | ((digit[2]& 0x01) << 14 ) ; // 6K 6Q    6P
-      LCD->RAM[LCD_RAMRegister_6] |= ((digit[3]& 0x04) << 15 ) | ((digit[3]& 0x08) << 13 ) | ((digit[3]& 0x01) << 14 ) ; // 6J 6H   6N
-
-      break;
-
-     default:
-      break;
+    if (fb_dirty & (1 << com))
+      LCD->RAM[fb_reg[com]] = fb_ram[com];
   }
-
-/* Refresh LCD  bar */
-  LCD_bar();
+  fb_dirty = 0;
 
 /* Update the LCD display */
   LCD_UpdateDisplayRequest();
+}
 
+/**
+  * @brief  This function writes a char in the LCD frame buffer.
+  * @param  ch: the character to display.
+  * @param  point: a point to add in front of char
+  *         This parameter can be: POINT_OFF or POINT_ON
+  * @param  column: flag indicating if a column has to be add in front
+  *         of displayed character.
+  *         This parameter can be: COLUMN_OFF or COLUMN_ON.
+  * @param  position: position in the LCD of the caracter to write [1:6]
+  * @retval None
+  */
+void LCD_GLASS_WriteChar(uint8_t* ch, bool point, bool column, uint8_t position)
+{
+  LCD_GLASS_SetChar(ch, point, column, position);
+  LCD_GLASS_Commit();
 }
 
 /**
@@ -488,7 +491,7 @@ void LCD_GLASS_DisplayString(uint8_t* ptr)
   while ((*ptr != 0) & (i < 8))
   {
     /* Display one character on LCD */
-    LCD_GLASS_WriteChar(ptr, FALSE, FALSE, i);
+    LCD_GLASS_SetChar(ptr, FALSE, FALSE, i);
 
     /* Point on the next character */
     ptr++;
@@ -496,6 +499,36 @@ void LCD_GLASS_DisplayString(uint8_t* ptr)
     /* Increment the character counter */
     i++;
   }
+
+  LCD_GLASS_Commit();
+}
+
+/**
+  * @brief  Display a string, the positions after its end are blank.
+  *         Only the digits which change are written, there is no need
+  *         to clear the LCD first.
+  * @param  ptr: Pointer to string to display on the LCD Glass.
+  * @retval None
+  */
+void LCD_GLASS_ShowString(uint8_t* ptr)
+{
+  uint8_t blank = ' ';
+  uint8_t i;
+
+  for (i = 1; i <= 6; i++)
+  {
+    if (*ptr != 0)
+    {
+      LCD_GLASS_SetChar(ptr, FALSE, FALSE, i);
+      ptr++;
+    }
+    else
+    {
+      LCD_GLASS_SetChar(&blank, FALSE, FALSE, i);
+    }
+  }
+
+  LCD_GLASS_Commit();
 }
 
 /**
@@ -519,14 +552,14 @@ void LCD_GLASS_DisplayStrDeci(uint16_t* ptr)
     {
       case DOT:
           /* Display one character on LCD with decimal point */
-          LCD_GLASS_WriteChar(&char_tmp, POINT_ON, COLUMN_OFF, i);
+          LCD_GLASS_SetChar(&char_tmp, POINT_ON, COLUMN_OFF, i);
           break;
       case DOUBLE_DOT:
           /* Display one character on LCD with decimal point */
-          LCD_GLASS_WriteChar(&char_tmp, POINT_OFF, COLUMN_ON, i);
+          LCD_GLASS_SetChar(&char_tmp, POINT_OFF, COLUMN_ON, i);
           break;
       default:
-          LCD_GLASS_WriteChar(&char_tmp, POINT_OFF, COLUMN_OFF, i);		
+          LCD_GLASS_SetChar(&char_tmp, POINT_OFF, COLUMN_OFF, i);		
           break;
     }/* Point on the next character */
     ptr++;
@@ -534,6 +567,8 @@ void LCD_GLASS_DisplayStrDeci(uint16_t* ptr)
     /* Increment the character counter */
     i++;
   }
+
+  LCD_GLASS_Commit();
 }
 
 /**
@@ -553,6 +588,17 @@ void LCD_GLASS_Clear(void)
     LCD->RAM[counter] = 0;
   }
 
+  /* and its shadow */
+  for (counter = 0; counter < 4; counter++)
+  {
+    fb_ram[counter] = 0;
+  }
+  for (counter = 0; counter < 7; counter++)
+  {
+    fb_seg[counter] = 0;
+  }
+  fb_dirty = 0;
+
   /* Update the LCD display */
   LCD_UpdateDisplayRequest();
 
@@ -562,8 +608,8 @@ void LCD_GLASS_Clear(void)
   * @brief  Display a string in scrolling mode
   * @param  ptr: Pointer to string to display on the LCD Glass.
   * @param  nScroll: Specifies how many time the message will be scrolled
-  * @param  ScrollSpeed : Speciifes the speed of the scroll, low value gives
-  *         higher speed
+  * @param  ScrollSpeed : Speciifes the speed of the scroll, milliseconds
+  *         per step, low value gives higher speed
   * @retval None
   * @par    Required preconditions: The LCD should be cleared before to start the
   *         write operation.
@@ -597,8 +643,7 @@ void LCD_GLASS_ScrollSentence(uint8_t* ptr, uint16_t nScroll, uint32_t ScrollSpe
       *(str+3) =* (ptr1+((Char_Nb+4)%Str_size));
       *(str+4) =* (ptr1+((Char_Nb+5)%Str_size));
       *(str+5) =* (ptr1+((Char_Nb+6)%Str_size));
-      LCD_GLASS_Clear();
-      LCD_GLASS_DisplayString(str);
+      LCD_GLASS_ShowString(str);
 
       Delay(ScrollSpeed);
     }	
@@ -606,4 +651,149 @@ void LCD_GLASS_ScrollSentence(uint8_t* ptr, uint16_t nScroll, uint32_t ScrollSpe
 
 }
 
+/**
+  * @brief  Display a string in scrolling mode without waiting, it is
+  *         advanced by the LCD start of frame interrupt (LCD_IRQHandler()).
+  *         If the string is already scrolling nothing changes, another
+  *         string replaces it at the same place.  While scrolling the LCD
+  *         should not be written by any other function, stop it first
+  *         with LCD_GLASS_ScrollStop().
+  * @param  ptr: Pointer to string to display on the LCD Glass, it is copied,
+  *         at most SCROLL_RING_LEN characters.
+  * @param  nScroll: Specifies how many time the message will be scrolled,
+  *         0 to scroll until it is stopped
+  * @param  ScrollSpeed : Speciifes the speed of the scroll, milliseconds
+  *         per step, low value gives higher speed
+  * @retval None
+  */
+void LCD_GLASS_ScrollString(uint8_t* ptr, uint16_t nScroll, uint32_t ScrollSpeed)
+{
+  uint8_t len;
+  uint8_t same;
+
+  if (ptr == 0) return;
+
+/* Stop the steps while the ring changes */
+  LCD_ITConfig(LCD_IT_SOF, DISABLE);
+
+  for (len = 0, same = 1; len < SCROLL_RING_LEN && ptr[len] != 0; len++)
+  {
+    if (scroll_ring[len] != ptr[len])
+    {
+      scroll_ring[len] = ptr[len];
+      same = 0;
+    }
+  }
+
+  scroll_count = nScroll;
+  scroll_frames = (ScrollSpeed * LCD_FRAME_HZ + 999) / 1000;
+  if (scroll_frames == 0)
+    scroll_frames = 1;
+
+  if (len == 0)
+  {
+    LCD_GLASS_ScrollStop();
+    return;
+  }
+
+  if (!same || len != scroll_len)
+  {
+    if (scroll_len == 0)
+    {
+      scroll_pos = 0;
+      scroll_wait = scroll_frames;
+    }
+    else if (scroll_pos >= len)
+    {
+      scroll_pos = 0;
+    }
+    scroll_len = len;
+    LCD_Scroll_Show();
+  }
+
+  LCD_ClearITPendingBit(LCD_IT_SOF);
+  LCD_ITConfig(LCD_IT_SOF, ENABLE);
+}
+
+/**
+  * @brief  Stops the scrolling of LCD_GLASS_ScrollString(), the string
+  *         stays where it is.
+  * @param  None
+  * @retval None
+  */
+void LCD_GLASS_ScrollStop(void)
+{
+  LCD_ITConfig(LCD_IT_SOF, DISABLE);
+  scroll_len = 0;
+}
+
+/**
+  * @brief  Whether a string of LCD_GLASS_ScrollString() is scrolling.
+  * @param  None
+  * @retval TRUE until it has been scrolled nScroll times or is stopped
+  */
+bool LCD_GLASS_Scrolling(void)
+{
+  return scroll_len != 0;
+}
+
+/**
+  * @brief  Shows the part of the scrolling string at scroll_pos.
+  * @param  None
+  * @retval None
+  */
+static void LCD_Scroll_Show(void)
+{
+  uint8_t i;
+  uint8_t n;
+
+  for (i = 1, n = scroll_pos; i <= 6; i++)
+  {
+    LCD_GLASS_SetChar(&scroll_ring[n], FALSE, FALSE, i);
+    if (++n >= scroll_len)
+      n = 0;
+  }
+
+  LCD_GLASS_Commit();
+}
+
+/**
+  * @brief  LCD start of frame interrupt, a step of LCD_GLASS_ScrollString()
+  *         every scroll_frames frames.
+  * @param  None
+  * @retval None
+  */
+void LCD_IRQHandler(void)
+{
+  LCD_ClearITPendingBit(LCD_IT_SOF);
+
+  if (scroll_len == 0)
+    return;
+
+  if (scroll_wait > 1)
+  {
+    scroll_wait--;
+    return;
+  }
+
+/* The last step is still waiting to be displayed, try the next frame */
+  if (LCD_GetFlagStatus(LCD_FLAG_UDR) != RESET)
+    return;
+
+  scroll_wait = scroll_frames;
+
+  if (++scroll_pos >= scroll_len)
+  {
+    scroll_pos = 0;
+    if (scroll_count != 0 && --scroll_count == 0)
+    {
+      LCD_Scroll_Show();
+      LCD_GLASS_ScrollStop();
+      return;
+    }
+  }
+
+  LCD_Scroll_Show();
+}
+
 /******************* (C) COPYRIGHT 2011 STMicroelectronics *****END OF FILE****/
@@ -19,6 +19,19 @@
   * <h2><center>&copy; COPYRIGHT 2011 STMicroelectronics</center></h2>
   */ 
 
+/**
+  * CHANGELOG
+  * ---------
+  *
+  * --------------------------------------------------------------------------- 
+  * Added support for the '+' character (C_plus), the sign of the
+  * Lab 2 result.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 10:12:03 -0700
+  * --------------------------------------------------------------------------- 
+  */
+
+
 /* Define to prevent recursive inclusion -------------------------------------*/
 #ifndef __stm32l_discovery_lcd
 #define __stm32l_discovery_lcd
@@ -32,6 +45,12 @@
 #define SCROLL_SPEED_L  600
 #define SCROLL_NUM    	1
 
+/* Longest string of LCD_GLASS_ScrollString() */
+#define SCROLL_RING_LEN 64
+
+/* LCD frames per second, LSE (32768 Hz) / 31 (LCD_Divider_31) * 1/4 duty */
+#define LCD_FRAME_HZ  264
+
 /* Define for character '.' */
 #define  POINT_OFF FALSE
 #define  POINT_ON TRUE
@@ -100,6 +119,9 @@ MSB   { 1 , 1 , 0 , 0   }
 /* constant code for '-' character */
 #define C_minus 0xA000
 
+/* constant code for '+' character */
+#define C_plus 0xA014
+
 /* constant code for '/' */
 #define C_slatch  0x00c0
 
@@ -115,10 +137,17 @@ void LCD_bar(void);
 void LCD_GLASS_Init(void);
 void LCD_GLASS_WriteChar(uint8_t* ch, bool point, bool column,uint8_t position);
 void LCD_GLASS_DisplayString(uint8_t* ptr);
+void LCD_GLASS_SetChar(uint8_t* ch, bool point, bool column, uint8_t position);
+void LCD_GLASS_Commit(void);
+void LCD_GLASS_ShowString(uint8_t* ptr);
 void LCD_GLASS_DisplayStrDeci(uint16_t* ptr);
 void LCD_GLASS_ClearChar(uint8_t position);
 void LCD_GLASS_Clear(void);
 void LCD_GLASS_ScrollSentence(uint8_t* ptr, uint16_t nScroll, uint32_t ScrollSpeed);
+void LCD_GLASS_ScrollString(uint8_t* ptr, uint16_t nScroll, uint32_t ScrollSpeed);
+void LCD_GLASS_ScrollStop(void);
+bool LCD_GLASS_Scrolling(void);
+void LCD_IRQHandler(void);
 void LCD_GLASS_WriteTime(char a, uint8_t posi, bool column);
 void LCD_GLASS_Configure_GPIO(void);
 
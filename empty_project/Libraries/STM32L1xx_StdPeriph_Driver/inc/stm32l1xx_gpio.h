@@ -146,6 +146,20 @@ typedef struct
                                        This parameter can be a value of @ref GPIOPuPd_TypeDef */
 }GPIO_InitTypeDef;
 
+/** 
+  * @brief  GPIO batch entry definition, a line of the table of GPIO_InitBatch()
+  */ 
+typedef struct
+{
+  GPIO_TypeDef* GPIOx;            /*!< Specifies the port, where x can be (A..H). */
+
+  GPIO_InitTypeDef GPIO_Init;     /*!< Specifies the pins and their configuration, as for GPIO_Init(). */
+
+  uint8_t GPIO_AF;                /*!< Specifies the alternate function of the pins when GPIO_Mode
+                                       is GPIO_Mode_AF, it is not used otherwise.
+                                       This parameter can be a value of @ref GPIO_Alternat_function_selection_define */
+}GPIO_BatchTypeDef;
+
 /* Exported constants --------------------------------------------------------*/
 
 /** @defgroup GPIO_Exported_Constants
@@ -355,6 +369,7 @@ void GPIO_DeInit(GPIO_TypeDef* GPIOx);
 /* Initialization and Configuration functions *********************************/
 void GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_InitStruct);
 void GPIO_StructInit(GPIO_InitTypeDef* GPIO_InitStruct);
+void GPIO_InitBatch(const GPIO_BatchTypeDef* GPIO_Batch, uint32_t Count);
 void GPIO_PinLockConfig(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
 
 /* GPIO Read and Write functions **********************************************/
@@ -370,6 +385,7 @@ void GPIO_ToggleBits(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin);
 
 /* GPIO Alternate functions configuration functions ***************************/
 void GPIO_PinAFConfig(GPIO_TypeDef* GPIOx, uint16_t GPIO_PinSource, uint8_t GPIO_AF);
+void GPIO_PinAFConfigMask(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, uint8_t GPIO_AF);
 
 #ifdef __cplusplus
 }
@@ -69,6 +69,21 @@
   ******************************************************************************
   */
 
+/**
+  * CHANGELOG
+  * ---------
+  *
+  * --------------------------------------------------------------------------- 
+  * GPIO_PinAFConfigMask() sets the alternate function of all the pins of a
+  * mask with one read-modify-write of each AFR register, in place of a
+  * GPIO_PinAFConfig() per pin.  GPIO_InitBatch() configures the pins of a
+  * table, the registers of each port are computed and then each is written
+  * once, where GPIO_Init() writes each register twice for each pin.
+  *
+  * -- Jeremiah Mahler <jmmahler@gmail.com>  Sat, 17 Oct 2026 23:02:16 -0700
+  * --------------------------------------------------------------------------- 
+  */
+
 /* Includes ------------------------------------------------------------------*/
 #include "stm32l1xx_gpio.h"
 #include "stm32l1xx_rcc.h"
@@ -89,6 +104,43 @@
 /* Private function prototypes -----------------------------------------------*/
 /* Private functions ---------------------------------------------------------*/
 
+/**
+  * @brief  Spreads a mask of pins to the 2-bit fields of those pins
+  *         (MODER, OSPEEDR, PUPDR).
+  */
+static uint32_t GPIO_Mask2(uint16_t GPIO_Pin)
+{
+  uint32_t mask = 0x00;
+  uint32_t pinpos;
+
+  for (pinpos = 0x00; pinpos < 0x10; pinpos++)
+  {
+    if (GPIO_Pin & ((uint32_t)0x01 << pinpos))
+    {
+      mask |= (uint32_t)0x03 << (pinpos * 2);
+    }
+  }
+  return mask;
+}
+
+/**
+  * @brief  Spreads a mask of 8 pins to their 4-bit fields of an AFR register.
+  */
+static uint32_t GPIO_Mask4(uint8_t GPIO_Pin)
+{
+  uint32_t mask = 0x00;
+  uint32_t pinpos;
+
+  for (pinpos = 0x00; pinpos < 0x08; pinpos++)
+  {
+    if (GPIO_Pin & ((uint32_t)0x01 << pinpos))
+    {
+      mask |= (uint32_t)0x0F << (pinpos * 4);
+    }
+  }
+  return mask;
+}
+
 /** @defgroup GPIO_Private_Functions
   * @{
   */
@@ -222,6 +274,104 @@ void GPIO_Init(GPIO_TypeDef* GPIOx, GPIO_InitTypeDef* GPIO_InitStruct)
   }
 }
 
+/**
+  * @brief  Initializes the pins of a table of ports, each entry as GPIO_Init()
+  *         followed by GPIO_PinAFConfigMask() for those in GPIO_Mode_AF.
+  * @note   The registers of consecutive entries of the same port are computed
+  *         together and then each register (MODER, OSPEEDR, OTYPER, PUPDR,
+  *         AFR[0], AFR[1]) of the port is read and written once, and only if
+  *         a pin changes it.  A later entry replaces an earlier one for the
+  *         same pins.  The alternate functions are written before MODER so a
+  *         pin is never in AF mode with another function.
+  * @param  GPIO_Batch: pointer to a table of GPIO_BatchTypeDef entries.
+  * @param  Count: number of entries in the table.
+  * @retval None
+  */
+void GPIO_InitBatch(const GPIO_BatchTypeDef* GPIO_Batch, uint32_t Count)
+{
+  GPIO_TypeDef* GPIOx;
+  const GPIO_InitTypeDef* init;
+  uint32_t moder_m, moder_v, ospeedr_m, ospeedr_v, pupdr_m, pupdr_v;
+  uint32_t otyper_m, otyper_v, afr_m[2], afr_v[2];
+  uint32_t mask2, mask4, i;
+
+  while (Count > 0)
+  {
+    GPIOx = GPIO_Batch->GPIOx;
+    moder_m = moder_v = ospeedr_m = ospeedr_v = pupdr_m = pupdr_v = 0x00;
+    otyper_m = otyper_v = afr_m[0] = afr_v[0] = afr_m[1] = afr_v[1] = 0x00;
+
+    /* The register fields of all the consecutive entries of this port */
+    for (; Count > 0 && GPIO_Batch->GPIOx == GPIOx; GPIO_Batch++, Count--)
+    {
+      init = &GPIO_Batch->GPIO_Init;
+
+      /* Check the parameters */
+      assert_param(IS_GPIO_ALL_PERIPH(GPIOx));
+      assert_param(IS_GPIO_PIN(init->GPIO_Pin));
+      assert_param(IS_GPIO_MODE(init->GPIO_Mode));
+      assert_param(IS_GPIO_PUPD(init->GPIO_PuPd));
+
+      mask2 = GPIO_Mask2(init->GPIO_Pin);
+
+      moder_m |= mask2;
+      moder_v = (moder_v & ~mask2) | (mask2 & ((uint32_t)init->GPIO_Mode * 0x55555555));
+
+      if ((init->GPIO_Mode == GPIO_Mode_OUT) || (init->GPIO_Mode == GPIO_Mode_AF))
+      {
+        assert_param(IS_GPIO_SPEED(init->GPIO_Speed));
+        assert_param(IS_GPIO_OTYPE(init->GPIO_OType));
+
+        ospeedr_m |= mask2;
+        ospeedr_v = (ospeedr_v & ~mask2) | (mask2 & ((uint32_t)init->GPIO_Speed * 0x55555555));
+
+        otyper_m |= init->GPIO_Pin;
+        otyper_v = (otyper_v & ~init->GPIO_Pin) | (init->GPIO_Pin & ((uint32_t)init->GPIO_OType * 0xFFFF));
+      }
+
+      pupdr_m |= mask2;
+      pupdr_v = (pupdr_v & ~mask2) | (mask2 & ((uint32_t)init->GPIO_PuPd * 0x55555555));
+
+      if (init->GPIO_Mode == GPIO_Mode_AF)
+      {
+        assert_param(IS_GPIO_AF(GPIO_Batch->GPIO_AF));
+
+        for (i = 0; i < 2; i++)
+        {
+          mask4 = GPIO_Mask4((uint8_t)(init->GPIO_Pin >> (i * 8)));
+          afr_m[i] |= mask4;
+          afr_v[i] = (afr_v[i] & ~mask4) | (mask4 & ((uint32_t)GPIO_Batch->GPIO_AF * 0x11111111));
+        }
+      }
+    }
+
+    /* Each register of the port once */
+    for (i = 0; i < 2; i++)
+    {
+      if (afr_m[i])
+      {
+        GPIOx->AFR[i] = (GPIOx->AFR[i] & ~afr_m[i]) | afr_v[i];
+      }
+    }
+    if (moder_m)
+    {
+      GPIOx->MODER = (GPIOx->MODER & ~moder_m) | moder_v;
+    }
+    if (ospeedr_m)
+    {
+      GPIOx->OSPEEDR = (GPIOx->OSPEEDR & ~ospeedr_m) | ospeedr_v;
+    }
+    if (otyper_m)
+    {
+      GPIOx->OTYPER = (uint16_t)((GPIOx->OTYPER & ~otyper_m) | otyper_v);
+    }
+    if (pupdr_m)
+    {
+      GPIOx->PUPDR = (GPIOx->PUPDR & ~pupdr_m) | pupdr_v;
+    }
+  }
+}
+
 /**
   * @brief  Fills each GPIO_InitStruct member with its default value.
   * @param  GPIO_InitStruct : pointer to a GPIO_InitTypeDef structure which will 
@@ -536,6 +686,36 @@ void GPIO_PinAFConfig(GPIO_TypeDef* GPIOx, uint16_t GPIO_PinSource, uint8_t GPIO
   GPIOx->AFR[GPIO_PinSource >> 0x03] = temp_2;
 }
 
+/**
+  * @brief  Changes the mapping of several pins, as GPIO_PinAFConfig() for
+  *         each, with one read-modify-write of each AFR register used.
+  * @param  GPIOx: where x can be (A..H) to select the GPIO peripheral.
+  * @param  GPIO_Pin: specifies the pins, any combination of GPIO_Pin_x
+  *   where x can be (0..15).
+  * @param  GPIO_AF: selects the Alternate function of the pins, one of the
+  *   values of GPIO_PinAFConfig().
+  * @retval None
+  */
+void GPIO_PinAFConfigMask(GPIO_TypeDef* GPIOx, uint16_t GPIO_Pin, uint8_t GPIO_AF)
+{
+  uint32_t mask;
+  uint32_t i;
+
+  /* Check the parameters */
+  assert_param(IS_GPIO_ALL_PERIPH(GPIOx));
+  assert_param(IS_GPIO_PIN(GPIO_Pin));
+  assert_param(IS_GPIO_AF(GPIO_AF));
+
+  for (i = 0; i < 2; i++)
+  {
+    mask = GPIO_Mask4((uint8_t)(GPIO_Pin >> (i * 8)));
+    if (mask)
+    {
+      GPIOx->AFR[i] = (GPIOx->AFR[i] & ~mask) | (mask & ((uint32_t)GPIO_AF * 0x11111111));
+    }
+  }
+}
+
 /**
   * @}
   */
@@ -0,0 +1,166 @@
+/*
+ * NAME
+ * ----
+ *
+ *  gray_counter-test - test module for 'gray_counter'
+ *
+ * INTRODUCTION
+ * ------------
+ *
+ * It is built for one WIDTH, given to iverilog with
+ * -Ptest.WIDTH=16, and the counter is clocked from reset.
+ * On each clock it checks that
+ *
+ *  - exactly one bit of the count changed
+ *
+ *  - the count decoded back to binary is the number of
+ *    clocks since reset (or the preload, below), modulo 2^WIDTH
+ *
+ * The decode is a different circuit (each binary bit is the XOR
+ * of all gray bits above it) than the encode, and since it gives
+ * 0, 1, 2, .. 2^WIDTH - 1, 0 every value is seen exactly once in
+ * each period.  It displays PASS or FAIL.
+ *
+ * Up to 16 bits two full periods are run.  For wider counters
+ * that would take too long, the first clocks after reset are
+ * run and then the binary count is preloaded near its end so
+ * that the wrap back to zero is also checked.
+ *
+ * It is configured to produce an output file suitable for Gtkwave,
+ * DUMPFILE (output.vcd).
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`timescale 1ns / 1ns
+
+`include "gray_counter.v"
+
+`ifndef DUMPFILE
+`define DUMPFILE "output.vcd"
+`endif
+
+module test;
+
+	// bits in the counter
+	parameter WIDTH = 8;
+	// the whole period can be run
+	localparam FULL = (WIDTH <= 16);
+	// clocks checked, two periods or from reset and around the wrap
+	localparam CYCLES = FULL ? (2 << WIDTH) : 100000;
+
+	reg clk;
+	reg rst_l;
+	wire [WIDTH-1:0] count;
+
+	gray_counter #(.WIDTH(WIDTH)) gc(clk, rst_l, count);
+
+	integer errors;
+	integer checks;
+
+	// {{{ decode()
+	// gray code to binary
+	function [WIDTH-1:0] decode;
+		input [WIDTH-1:0] g;
+		integer k;
+		begin
+			decode = g;
+			for (k = 1; k < WIDTH; k = k + 1)
+				decode = decode ^ (g >> k);
+		end
+	endfunction
+	// }}}
+
+	// {{{ check()
+	task check;
+		input [8*16:1] name;
+		input [WIDTH-1:0] got;
+		input [WIDTH-1:0] expected;
+		begin
+			checks = checks + 1;
+			if (got !== expected) begin
+				errors = errors + 1;
+				if (errors < 10)
+					$display("%0s: expected %h, got %h", name, expected, got);
+			end
+		end
+	endtask
+	// }}}
+
+	// {{{ clock()
+	/*
+	 * clock()
+	 *
+	 * One clock, then check the count against the one
+	 * before it and against the binary count 'n'.
+	 */
+	reg [WIDTH-1:0] n;
+	reg [WIDTH-1:0] last;
+	reg [WIDTH-1:0] diff;
+
+	task clock;
+		begin
+			last = count;
+			#1 clk = 1;
+			#1 clk = 0;
+			n = n + 1'b1;
+
+			diff = count ^ last;
+			// one bit, a power of two
+			check("one bit", (diff != 0 && 0 == (diff & (diff - 1'b1))), 1);
+			check("decode", decode(count), n);
+		end
+	endtask
+	// }}}
+
+	integer i;
+
+	initial begin
+		$dumpfile(`DUMPFILE);
+		$dumpvars(0,test);
+
+		errors = 0;
+		checks = 0;
+
+		clk = 0;
+		rst_l = 1;
+		#1 rst_l = 0;
+		#1 rst_l = 1;
+
+		n = 0;
+		check("reset", count, 0);
+
+		if (FULL) begin
+			for (i = 0; i < CYCLES; i = i + 1)
+				clock;
+		end else begin
+			for (i = 0; i < CYCLES / 2; i = i + 1)
+				clock;
+
+			// preload, half of the clocks before the wrap,
+			// the binary count and its registered gray code
+			n = -(CYCLES / 2);
+			gc.b = n;
+			gc.count = n ^ (n >> 1);
+			#1;
+			check("preload", decode(count), n);
+
+			for (i = 0; i < CYCLES / 2; i = i + 1)
+				clock;
+			check("wrap", count, 0);
+		end
+
+		if (errors)
+			$display("FAIL: %0d of %0d checks", errors, checks);
+		else
+			$display("PASS: %0d bit counter, %0d checks", WIDTH, checks);
+
+		$finish;
+	end
+endmodule
+
+// vim:foldmethod=marker
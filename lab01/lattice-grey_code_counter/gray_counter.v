@@ -0,0 +1,72 @@
+/*
+ * NAME
+ * ----
+ *
+ * gray_counter - WIDTH-bit gray code counter
+ *
+ * DESIGN
+ * ------
+ *
+ * A binary counter (b) is kept and on each clock the count is
+ * the gray code of its next value,
+ *
+ *   count <= (b + 1) ^ ((b + 1) >> 1)
+ *
+ * Bit k of the gray code is the XOR of bits k and k+1 of the
+ * binary count, so each bit is one gate (LUT) in front of its
+ * flip-flop whatever the WIDTH, next to the usual incrementer
+ * (carry chain).  There are no special cases or modulo compares,
+ * it works for any WIDTH (8 to 32 bits) and counts through all
+ * 2^WIDTH values before it starts again at zero.
+ *
+ * The sequence is the same as that of grey_counter.v, and
+ * of grey_code_generator.pl (grey.out), for 8 bits.
+ *
+ * The count is registered, so it changes only on the clock
+ * edge, and exactly one of its bits changes then.  The binary
+ * count, where a carry changes many bits, is not an output.
+ *
+ * SYNTHESIS
+ * ---------
+ *
+ * 'make synth' synthesizes it with Yosys for each width of the
+ * Makefile, and grey_counter.v, to generic 4 input LUTs and
+ * displays the cells of each, to compare their sizes.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  wire [15:0] count;
+ *
+ *  gray_counter #(.WIDTH(16)) gc(clk, rst_l, count);
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+module gray_counter #(
+	parameter WIDTH = 8
+	) (
+	input wire clk,
+	input wire rst_l,
+	output reg [WIDTH-1:0] count
+	);
+
+	reg [WIDTH-1:0] b;	// binary count
+	wire [WIDTH-1:0] b_next;
+
+	assign b_next = b + 1'b1;
+
+	always @(posedge clk or negedge rst_l) begin
+		if (~rst_l) begin
+			b <= {WIDTH{1'b0}};
+			count <= {WIDTH{1'b0}};
+		end else begin
+			b <= b_next;
+			count <= b_next ^ (b_next >> 1);
+		end
+	end
+endmodule
@@ -24,6 +24,9 @@
  * changed.
  * 
  * This design could be easily expanded to any number of bits.
+ *
+ * It has been replaced in main.v by gray_counter.v which works
+ * for any number of bits, this one is kept for comparison.
  */
 
 module grey_counter(input clk, output reg [7:0] count);
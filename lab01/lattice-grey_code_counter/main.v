@@ -1,8 +1,8 @@
 
 /*
- * main - main loop for grey_counter
+ * main - main loop for gray_counter
  *
- * This section includes the grey counter and
+ * This section includes the gray counter and
  * adds all necessary support for clocks and resets.
  * 
  * This code was derived from the Demo program provided
@@ -18,7 +18,7 @@
  *
  */
 
-`include "grey_counter.v"
+`include "gray_counter.v"
 
 // 4 bit oscillating LED pattern
 module main(rstn, osc_clk, led, clk );
@@ -34,7 +34,7 @@ module main(rstn, osc_clk, led, clk );
 
 	OSCC OSCC_1 (.OSC(osc_clk)) ;
 
-	grey_counter gc1(clk, led);
+	gray_counter #(.WIDTH(8)) gc1(clk, rstn, led);
 
 	//  The c_delay counter is used to slow down the internal oscillator (OSC) output
 	//  to a rate of approximately 0.5 Hz
@@ -0,0 +1,96 @@
+/*
+ * NAME
+ * ----
+ *
+ * fmt.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Fixed width number formatting, refer to fmt.h.
+ *
+ * The digits are written from the right end of the field
+ * so no reversing or temporary buffer is needed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "fmt.h"
+
+static const char hex_digits[16] = "0123456789abcdef";
+
+char *fmt_hex(char *p, uint32_t v, uint8_t width) {
+    char *end;
+
+    if (0 == width) {
+        width = 1;
+        while (width < 8 && (v >> (4 * width)))
+            width++;
+    }
+
+    end = p + width;
+    for (p = end; width; width--) {
+        *--p = hex_digits[v & 0x0f];
+        v >>= 4;
+    }
+
+    return end;
+}
+
+char *fmt_udec(char *p, uint32_t v, uint8_t width) {
+    uint32_t n;
+    char *end;
+
+    if (0 == width) {
+        width = 1;
+        for (n = v; n >= 10; n /= 10)
+            width++;
+    }
+
+    end = p + width;
+    p = end;
+    do {
+        *--p = '0' + v % 10;
+        v /= 10;
+    } while (v && p > end - width);
+
+    while (p > end - width)
+        *--p = ' ';
+
+    return end;
+}
+
+char *fmt_sdec(char *p, int32_t v, uint8_t width) {
+    uint32_t mag;
+
+    if (v < 0) {
+        *p++ = '-';
+        mag = -(uint32_t) v;
+    } else {
+        *p++ = (v) ? '+' : ' ';
+        mag = v;
+    }
+
+    // no room for any digits
+    if (1 == width)
+        return p;
+
+    return fmt_udec(p, mag, (width) ? width - 1 : 0);
+}
+
+char *fmt_flag(char *p, uint32_t flag) {
+    *p++ = (flag) ? '1' : '0';
+
+    return p;
+}
+
+char *fmt_str(char *p, const char *s) {
+    while (*s)
+        *p++ = *s++;
+
+    return p;
+}
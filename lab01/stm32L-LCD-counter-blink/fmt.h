@@ -0,0 +1,61 @@
+#ifndef FMT_H
+#define FMT_H
+
+#include <stdint.h>
+
+/*
+ * NAME
+ * ----
+ *
+ * fmt.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Small fixed width number formatting for the LCD, in place
+ * of sprintf().
+ *
+ * Each function writes its field at 'p' and returns the end
+ * of it, so the fields of a line are chained one after the
+ * other.  The string is not terminated, the caller does that
+ * once at the end.  There are no variable arguments and
+ * nothing is allocated.
+ *
+ * A 'width' of 0 uses as many characters as the value needs
+ * (like "%x" and "%u").  Otherwise exactly 'width' characters
+ * are written, the value is padded on the left, hex with
+ * zeros (like "%.2x") and decimal with spaces (like "%2u"),
+ * and a value too big for the field keeps its lowest digits.
+ *
+ *  fmt_hex()   lower case hexadecimal
+ *  fmt_udec()  unsigned decimal
+ *  fmt_sdec()  a sign, '-', '+' or ' ' for zero, followed by
+ *              the decimal magnitude, 'width' includes the sign
+ *              so a 'width' of 1 is the sign alone
+ *  fmt_flag()  '1' or '0'
+ *  fmt_str()   a string, its own length
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  char str[7];
+ *  char *p = str;
+ *
+ *  p = fmt_str(p, "CMD ");
+ *  p = fmt_hex(p, 0x0a, 2);
+ *  *p = 0;
+ *  // "CMD 0a"
+ *
+ */
+
+char *fmt_hex(char *p, uint32_t v, uint8_t width);
+
+char *fmt_udec(char *p, uint32_t v, uint8_t width);
+
+char *fmt_sdec(char *p, int32_t v, uint8_t width);
+
+char *fmt_flag(char *p, uint32_t flag);
+
+char *fmt_str(char *p, const char *s);
+
+#endif
@@ -12,6 +12,8 @@
  * It starts at zero and incriments a counter forever
  * while also displaying the current count on the LCD screen.
  * For each count the blue LED on pin PB6 is blinked.
+ * The count is timed by the SysTick interrupt (1 ms) so it
+ * does not depend on how fast the loop runs.
  *
  * All of the initilization, excluding the LCD, is done
  * by calling functions which are written in pure assembly.
@@ -35,10 +37,11 @@
  */
 
 #include "stm32l1xx.h"
-#include "stdio.h"
 #include "discover_board.h"
 #include "stm32l_discovery_lcd.h"
 
+#include "fmt.h"
+
 void  RCC_Configuration(void);
 void  RTC_Configuration(void);
 
@@ -54,8 +57,18 @@ extern void PB6_set(void);
 extern void PB6_clear(void);
 extern void PB6_toggle(void);
 
+// time between each count (milliseconds)
+#define COUNT_MS 1000
+
+// milliseconds since SysTick was started
+static volatile uint32_t ms_ticks = 0;
+
+void SysTick_Handler(void) {
+	ms_ticks++;
+}
+
 int main() {
-	unsigned int k = 0;  // used for counter
+	uint32_t last = 0;  // ms_ticks of the last count
 	unsigned short count = 0;
 	char strDisp[20] ;
 
@@ -67,6 +80,10 @@ int main() {
 	// Select the HSI for the SYSCLK
 	RCC_SYSCLK_HSI();
 
+	// SysTick interrupt every 1 ms of the (new) SYSCLK
+	SystemCoreClockUpdate();
+	SysTick_Config(SystemCoreClock / 1000);
+
 	// Enable comparator clock LCD and PWR mngt
 	RCC_LCD_enable();
 	RCC_PWR_enable();
@@ -92,20 +109,20 @@ int main() {
 	// ### TOGGLE PB6, increment counter on LCD ###
 
 	while(1) {
-		k++;
+		// sleep until the next tick
+		__WFI();
+
+		// Toggle at 1 Hz
+		if (ms_ticks - last >= COUNT_MS) {
+			last += COUNT_MS;
 
-		// Toggle at approximately 1 Hz
-		if (k >= 10e5) {
 			PB6_toggle();
 
-			//sprintf(strDisp, "%d", ++count);  // decimal
-			sprintf(strDisp, "%x", ++count);  // hex
-			//sprintf(strDisp, "%o", ++count);  // octal
+			//*fmt_udec(strDisp, ++count, 0) = 0;  // decimal
+			*fmt_hex(strDisp, ++count, 0) = 0;  // hex
 
 			LCD_GLASS_Clear();
 			LCD_GLASS_DisplayString((unsigned char *) strDisp);
-
-			k = 0; // reset counter
 		}
 	}
 }
@@ -1,9 +1,8 @@
 #include "button.h"
+#include "tick.h"
 
 void enable_button()
 {
-	int i = 0;
-
 	// [Pg. 144]{STRM0038}
 	// The RI registers can only be accessed when the comparator
 	// interface clock is enabled.
@@ -15,7 +14,8 @@ void enable_button()
 	COMP->CSR |= COMP_CSR_CMP1EN;
 
 	// 2.) wait until comparator is ready
-	while (i++ < 5e5);	 // a cheap timer. TODO: build a better one
+	//     (far more than its startup time)
+	delay_ms(10);
 
 	// 3.) set the SCM bit in the RI_ASCR1 register	
 	RI->ASCR1 |= RI_ASCR1_SCM;
@@ -13,6 +13,9 @@
  * These functions enable it and then allow it
  * to be tested to see if it pressed or not.
  *
+ * enable_button() waits for the comparator with delay_ms()
+ * so the time base (timebase.h) must be configured first.
+ *
  * SYNOPSIS
  * --------
  *
@@ -12,15 +12,29 @@
  * - It acts as an SPI master and sends/receives data.
  *
  * - It assumes the 8-bit data it receives is two 4-bit
- *   unsigned numbers.
+ *   unsigned numbers (SADDSUB_WIDTH, saddsub.h).  Wider
+ *   numbers are sent in 16 and 32 bit frames (FRAME_BITS), the
+ *   CPLD (main.v) must be built with the same WIDTH.
  *
  * - It performs addition of the USER button is released
  *   and subtraction if pressed.
  *
  * - It display the result on the LCD as an unsigned number
  *   and it also includes the negative and overflow flags.
+ *   Wider numbers do not fit in the 6 characters, they are
+ *   scrolled.
  * 
- * - It sends the 8-bit result through the SPI.
+ * - It sends the 8-bit result through the SPI (the frame).
+ *
+ * The SPI exchange, the calculation and the LCD refresh
+ * are tasks of a cooperative scheduler (sched.c) so the
+ * processor sleeps instead of counting while it waits.
+ *
+ * Built with STREAM defined the frames are exchanged back to
+ * back by DMA (spi_stream.c) instead of one every PAUSE_MS,
+ * and calculated in batches (saddsub_batch()).  The result of
+ * each frame is sent STREAM_FRAMES frames later and the LCD
+ * shows the latest every LCD_MS.
  *
  * More detailed descriptions can be found in the documentation
  * included with this project or in the source code.
@@ -33,11 +47,16 @@
  */
 
 #include "stm32l1xx.h"
-#include "stdio.h"
+#include "string.h"
 #include "discover_board.h"
 #include "stm32l_discovery_lcd.h"
 
 #include "button.h"
+#include "fmt.h"
+#include "saddsub.h"
+#include "spi_stream.h"
+#include "sched.h"
+#include "timebase.h"
 
 /* The configure_* functions are used to
  * encapsulate the configuration of a specific
@@ -49,186 +68,275 @@ void configure_SPI();
 void configure_LCD();
 void configure_LEDs();
 
-// The "special" add/sub operation
-extern uint32_t saddsub(uint32_t, uint32_t, uint32_t);
+// time to wait between each exchange (milliseconds)
+#define PAUSE_MS 100
+
+// stream the frames by DMA, see the top of this file
+//#define STREAM
+
+// frames of the stream, each half is calculated at once
+#define STREAM_FRAMES 64
+// time between each refresh of the LCD when streaming (milliseconds)
+#define LCD_MS 100
+
+// characters of the LCD, longer strings are scrolled
+#define LCD_CHARS 6
+// time of each step of a scrolled string (milliseconds)
+#define SCROLL_MS 300
+
+// bits in an SPI frame, the two numbers
+#define FRAME_BITS (2 * SADDSUB_WIDTH)
+
+// words of the SPI in a frame, the SPI does 8 or 16 bits
+#if FRAME_BITS == 8
+#define SPI_DATA_SIZE SPI_DataSize_8b
+#define WORD_BITS 8
+#elif FRAME_BITS == 16 || FRAME_BITS == 32
+#define SPI_DATA_SIZE SPI_DataSize_16b
+#define WORD_BITS 16
+#else
+#error "FRAME_BITS must be 8, 16 or 32"
+#endif
+#define FRAME_WORDS (FRAME_BITS / WORD_BITS)
+
+#if defined(STREAM) && FRAME_BITS != 8
+#error "STREAM only exchanges 8-bit frames"
+#endif
 
-void main() {
+// overflow and sign bitmask (from saddsub)
+#define V_BIT SADDSUB_V(SADDSUB_WIDTH)
+#define N_BIT SADDSUB_N(SADDSUB_WIDTH)
+// bitmask for number portion of result from saddsub
+#define NUM SADDSUB_NUM(SADDSUB_WIDTH)
+
+/*
+ * The work is split in to three tasks (sched.h).
+ *
+ *  spi   - every PAUSE_MS starts an exchange, the SPI
+ *          interrupt finishes it and wakes calc
+ *  calc  - calculates the result of the received byte,
+ *          it is sent back by the next exchange
+ *  lcd   - refreshes the LCD when the string to display changes
+ *
+ *  spi -> (SPI1_IRQHandler) -> calc -> lcd
+ *
+ * When streaming the DMA interrupt calculates the frames
+ * (stream()) and spi wakes calc every LCD_MS to display the
+ * latest.
+ *
+ *  (DMA1_Channel2_IRQHandler) -> stream()
+ *  spi -> calc -> lcd
+ */
+static sched_task spi_task;
+static sched_task calc_task;
+static sched_task lcd_task;
+
+// send and recieve buffers for SPI, a frame
+static volatile uint32_t SPI1_Tx = 0x00;  // initial data to send
+static volatile uint32_t SPI1_Rx = 0x00;  // received data is stored here
+
+// words of the frame being exchanged, the first is sent first
+static uint32_t frame_rx;
+static uint8_t frame_word;
+
+/*
+ * The word of SPI1_Tx to send, MSB first.
+ */
+static uint16_t frame_tx(uint8_t word) {
+	return SPI1_Tx >> (WORD_BITS * (FRAME_WORDS - 1 - word));
+}
+
+// {{{ ### SPI TASK ###
+#ifdef STREAM
+static uint8_t stream_tx[STREAM_FRAMES];
+static uint8_t stream_rx[STREAM_FRAMES];
+
+/*
+ * Half of the frames of the stream were received (DMA
+ * interrupt), their results are sent in the same frames
+ * the next time around.  The latest is kept for the LCD.
+ */
+static void stream(const uint8_t *rx, uint8_t *tx, uint16_t n) {
+	saddsub_batch(button_pressed() ? 1 : 0, rx, tx, n);
+
+	SPI1_Rx = rx[n - 1];
+}
+#endif
+
+static void spi(sched_task *t) {
+	// If there was an SPI error, turn on the blue LED
+	if (SPI_I2S_GetFlagStatus(SPI1, SPI_FLAG_CRCERR | SPI_FLAG_MODF | SPI_I2S_FLAG_FRE)) {
+		GPIO_SetBits(GPIOB, GPIO_Pin_6);  // turn on blue LED
+	}
+
+#ifdef STREAM
+	// the frames are exchanged by DMA, calc the latest again
+	// for the LCD
+	sched_wake(&calc_task);
+	sched_wake_after(t, LCD_MS);
+#else
+	if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY)) {
+		// still busy, try again next time
+	} else {
+		GPIO_ResetBits(GPIOB, GPIO_Pin_5);  // SS_L = 0, enable
+
+		// transmit the first word, RXNE interrupts once it is
+		// exchanged
+		frame_rx = 0;
+		frame_word = 0;
+		SPI_I2S_SendData(SPI1, frame_tx(0));
+	}
+
+	sched_wake_after(t, PAUSE_MS);
+#endif
+}
 
-	unsigned int k;  // for loop counter
-	// to display string on LCD
-	char str[20];
-	// send and recieve buffers for SPI
-	uint8_t SPI1_Tx;
-	uint8_t SPI1_Rx;
-
-    /*
-     * states used in main loop
-     *
-     *  SPI_SEND_RECEIVE -> CALC_DISPLAY -> PAUSE -> SPI_SEND_RECEIVE
-     *      (start)                                       (repeat)
-     */
-    enum states {START, SPI_SEND_RECEIVE, CALC_DISPLAY, PAUSE};
-    char state;
-
-    // variables used for calculations
-    uint32_t numA;
-    uint32_t numB;
+// a transaction was completed
+void SPI1_IRQHandler() {
+	if (SPI_I2S_GetITStatus(SPI1, SPI_I2S_IT_RXNE) != RESET) {
+		// read the received data, also clears RXNE
+		frame_rx = (frame_rx << WORD_BITS) | SPI_I2S_ReceiveData(SPI1);
+
+		if (++frame_word < FRAME_WORDS) {
+			// the next word of the frame, SS_L stays low
+			SPI_I2S_SendData(SPI1, frame_tx(frame_word));
+			return;
+		}
+
+		GPIO_SetBits(GPIOB, GPIO_Pin_5);  // SS_L = 1, disable
+
+		SPI1_Rx = frame_rx;
+
+		sched_wake(&calc_task);
+	}
+}
+// }}}
+
+// {{{ ### LCD TASK ###
+
+// string to display, changed in calc
+static char lcd_str[20];
+
+static void lcd(sched_task *t) {
+	// N<sign>V<overflow> and a number wider than 4 bits do not fit
+	if (strlen(lcd_str) > LCD_CHARS) {
+		// keeps its place when only the number changes
+		LCD_GLASS_ScrollString((unsigned char *) lcd_str, 0, SCROLL_MS);
+	} else {
+		if (LCD_GLASS_Scrolling())
+			LCD_GLASS_ScrollStop();
+		// only the characters which changed are written
+		LCD_GLASS_ShowString((unsigned char *) lcd_str);
+	}
+}
+// }}}
+
+// {{{ ### CALC TASK ###
+static void calc(sched_task *t) {
+	// variables used for calculations
+	uint32_t numA;
+	uint32_t numB;
 	// calculation result
-    uint32_t res;
-	// previous calculation result
-    uint32_t prev_res = 0xFFFF0000;	
-	// 'prev_res' is used to only refesh LCD when
-	// 'res' has changed.
-	// It is initialized at some impossible value
-	// so that it will not be equal to 'res', and
-	// so the LCD will be refreshed on startup/reset.
+	uint32_t res;
 
 	// extracted values for LCD
-    unsigned char sign;
-    unsigned char sign_char;
-    unsigned char oflow;
-    uint8_t num;
+	unsigned char sign;
+	unsigned char sign_char;
+	unsigned char oflow;
+	uint16_t num;
+	// the LCD string
+	char *p;
+
+	// ** CALCULATIONS **
+
+	// split the frame in to two SADDSUB_WIDTH bit numbers,
+	// each in the lower bits, ready for saddsub
+	numA = SADDSUB_A(SADDSUB_WIDTH, SPI1_Rx);
+	numB = SADDSUB_B(SADDSUB_WIDTH, SPI1_Rx);
+
+	// add the numbers together
+	if (button_pressed()) {
+		// subtract
+		res = saddsub(1, numA, numB);
+	} else {
+		// add
+		res = saddsub(0, numA, numB);
+	}
 
-#define LOWER_4_BITS 0x0000000F
-#define UPPER_4_BITS 0x000000F0
-// overflow and sign bitmask (from saddsub)
-#define V_BIT 0x00000010
-#define N_BIT 0x00000020
-// bitmask for number portion of result from saddsub
-#define NUM 0x0000000F
+	// extract the components, needed for LCD
+	sign = (res & N_BIT) ? '1' : '0';
+	oflow = (res & V_BIT) ? '1' : '0';
+
+	// extract only the 'number' part of the result
+	num = res & NUM;
+
+	if (0 == num)
+		sign_char = ' ';
+	else if ('1' == sign)
+		sign_char = '-';
+	else
+		sign_char = '+';
+
+	// If it is negative, we have to convert
+	// it to positive (2s compliment) so the LCD
+	// displays the correct value
+	// (A '-' sign is added using 'sign_char')
+	if ('1' == sign)
+		num = ((~num + 1) & NUM);
+	// Also, 'NUM' is used again to mask off any
+	// extra ones created by +1 which shouldn't be present
+	// in our SADDSUB_WIDTH bit number.
+
+	// ** LCD DISPLAY **
+	// prepare the string, N<sign>V<overflow><sign><number>
+	p = lcd_str;
+	*p++ = 'N';
+	*p++ = sign;
+	*p++ = 'V';
+	*p++ = oflow;
+	*p++ = sign_char;
+	p = fmt_udec(p, num, 0);
+	*p = 0;
+	sched_wake(&lcd_task);
+
+	// store to for SPI to send to CPLD to display on LEDs
+	SPI1_Tx = res;
+}
+// }}}
 
+void main() {
 
 	// {{{ ### INITIALIZATION ###
 
+	// configure_LCD() switches SYSCLK to the HSI, the time base
+	// is set from it so it must come after.
+	configure_LCD();
+
+	configure_timebase();
+
 	enable_button();
 
 	configure_LEDs();
 
-	configure_LCD();
-
 	configure_SPI();
 
+#ifdef STREAM
+	spi_stream_start(stream_tx, stream_rx, STREAM_FRAMES, stream);
+#endif
+
 	// }}}
 
 	// {{{ ### MAIN LOOP ###
 
 	//GPIO_ResetBits(GPIOB, GPIO_Pin_6);  // turn off blue LED
-	k = 0;
-	SPI1_Tx = 0x00;  // initial data to send
-	SPI1_Rx = 0x00;  // received data is stored here
-    state = START;
-
-	while (1) {
-
-        if (SPI_SEND_RECEIVE == state) {
-            // If there was an SPI error, turn on the blue LED
-            if (SPI_I2S_GetFlagStatus(SPI1, SPI_FLAG_CRCERR | SPI_FLAG_MODF | SPI_I2S_FLAG_FRE)) {
-                GPIO_SetBits(GPIOB, GPIO_Pin_6);  // turn on blue LED
-            }
-
-            if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY)) {
-                // kill some time
-                asm("nop");
-            } else if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE)) {
-                // a transaction was completed
-
-                GPIO_SetBits(GPIOB, GPIO_Pin_5);  // SS_L = 1, disable
-
-                // read the received data from the last transaction
-                //SPI_I2S_ClearFlag(SPI1, SPI_I2S_FLAG_RXNE);
-                SPI1_Rx = SPI_I2S_ReceiveData(SPI1);
-                // wait if needed
-                //while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE));
-
-                // next_state
-                state = CALC_DISPLAY;
-            } else if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE)) {
-                // we can transmit more data
-
-                GPIO_ResetBits(GPIOB, GPIO_Pin_5);  // SS_L = 0, enable
-
-                // transmit a byte
-                SPI_I2S_SendData(SPI1, SPI1_Tx);
-                while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE));
-            }
-        } else if (CALC_DISPLAY == state) {
-            // ** CALCULATIONS **
-
-            // split the 8-bit in to two 4-bit numbers
-            // and store them in an appropriate data type.
-            // bits 1-4
-            numA = 0;
-            numA |= SPI1_Rx & LOWER_4_BITS;
-            // bits 5-8
-            numB = 0;
-            numB |= SPI1_Rx & UPPER_4_BITS;
-            // shift so it is in the lower 4 bits
-            numB = numB >> 4;
-			// numA and numB in the lower 4 bits, ready for saddsub
-
-            // add the numbers together
-            if (button_pressed()) {
-                // subtract
-                res = saddsub(1, numA, numB);
-            } else {
-                // add
-                res = saddsub(0, numA, numB);
-            }
-
-			if (res == prev_res) {
-				// leave LCD as is,
-				// This helps reduce flicker since it is not always
-				// being cleared and reset
-			} else {
-				// extract the components, needed for LCD	
-				sign = (res & N_BIT) ? '1' : '0';
-				oflow = (res & V_BIT) ? '1' : '0';
-                
-                // extract only the 'number' part of the result
-				num = res & NUM;
-
-                if (0 == num)
-                    sign_char = ' ';
-                else if ('1' == sign)
-                    sign_char = '-';
-                else
-                    sign_char = '+';
-
-                // If it is negative, we have to convert
-                // it to positive (2s compliment) so the LCD
-                // displays the correct value
-                // (A '-' sign is added using 'sign_char')
-                if ('1' == sign) 
-                    num = ((~num + 1) & NUM);
-                // Also, 'NUM' is used again to mask off any
-                // extra ones created by +1 which shouldn't be present
-                // in our 4-bit number.
-
-				// ** LCD DISPLAY **
-                // prepare the string
-				sprintf(str, "N%cV%c%c%u", sign, oflow, sign_char, num);
-
-				LCD_GLASS_Clear();
-				LCD_GLASS_DisplayString((unsigned char *) str);
-
-				// store to for SPI to send to CPLD to display on LEDs
-				SPI1_Tx = (uint8_t) res;
-
-				prev_res = res;
-			}
-
-            // next state
-            state = PAUSE;
-        } else {
-            // default PAUSE
-            if (++k > 1e5) {
-                k = 0;
-
-                // next state
-                state = SPI_SEND_RECEIVE;
-            }
-        }
-	}
+
+	sched_add(&spi_task, spi);
+	sched_add(&calc_task, calc);
+	sched_add(&lcd_task, lcd);
+
+	sched_wake(&spi_task);
+
+	sched_run();
 	// }}}
 
 }
@@ -245,8 +353,8 @@ void main() {
  *  // refer to stm32lxx_spi.c in the standard peripheral library (ST)
  *  // for the most complete description.
  *
- *  uint8_t SPI1_Tx;
- *  uint8_t SPI1_Rx;
+ *  uint16_t SPI1_Tx;
+ *  uint16_t SPI1_Rx;
  *
  *  SPI1_Rx = SPI_I2S_ReceiveData(SPI1);
  *  SPI_I2S_SendData(SPI1, SPI1_Tx);
@@ -285,13 +393,19 @@ void main() {
  * The slowest baud rate has been chosen since this application
  * emphasizes reliability as opposed to speed.
  * Testing found this to be approximately 60 kb/s
+ * When streaming (STREAM) the fastest, SYSCLK / 2, is used and
+ * the frames are exchanged by DMA (spi_stream.c) instead of the
+ * RXNE interrupt.
  *
- * The data size transferred is 8-bits.
- * This could be easily configured for 16-bits if needed.
+ * The data size transferred is 8-bits, or 16-bits for a
+ * FRAME_BITS of 16 or 32 (two words).
  */
 void configure_SPI() {
 	GPIO_InitTypeDef GPIO_init;
 	SPI_InitTypeDef SPI_init;
+#ifndef STREAM
+	NVIC_InitTypeDef NVIC_init;
+#endif
 
 	// refer to stm32l1xx_spi.c for the steps
 	// that are required to configure SPI
@@ -305,10 +419,8 @@ void configure_SPI() {
 
 	// Peripherals alternate function:
 	// connect pins to peripherals
-	GPIO_PinAFConfig(GPIOA, GPIO_PinSource5, GPIO_AF_SPI1);  // SCK, PA5
-	GPIO_PinAFConfig(GPIOA, GPIO_PinSource12, GPIO_AF_SPI1); // MOSI, PA12
-	GPIO_PinAFConfig(GPIOA, GPIO_PinSource11, GPIO_AF_SPI1); // MISO, PA11
-//	GPIO_PinAFConfig(GPIOA, GPIO_PinSource5 | GPIO_PinSource12 | GPIO_PinSource11, GPIO_AF_SPI1); // MISO, PA11
+	// SCK PA5, MOSI PA12, MISO PA11, one write of AFR[0] and AFR[1]
+	GPIO_PinAFConfigMask(GPIOA, GPIO_Pin_5 | GPIO_Pin_12 | GPIO_Pin_11, GPIO_AF_SPI1);
 	// configure pin alternate function
 	GPIO_init.GPIO_Pin = GPIO_Pin_5 | GPIO_Pin_12 | GPIO_Pin_11;
 	GPIO_init.GPIO_Mode = GPIO_Mode_AF;
@@ -321,18 +433,31 @@ void configure_SPI() {
 	SPI_StructInit(&SPI_init);  // default values
 	SPI_init.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
 	SPI_init.SPI_Mode = SPI_Mode_Master;
-	SPI_init.SPI_DataSize = SPI_DataSize_8b;
-	//SPI_init.SPI_DataSize = SPI_DataSize_16b;
+	SPI_init.SPI_DataSize = SPI_DATA_SIZE;
 	SPI_init.SPI_CPOL = SPI_CPOL_Low;	// CPOL = 0
 	SPI_init.SPI_CPHA = SPI_CPHA_1Edge;	// CPHA = 0
 	SPI_init.SPI_NSS = SPI_NSS_Soft;  // NSS => SPI_CR1
+#ifdef STREAM
+	SPI_init.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_2;  // fast
+#else
 	SPI_init.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_256;  // slow
+#endif
 	SPI_init.SPI_FirstBit = SPI_FirstBit_MSB;
 	//SPI_init.SPI_CRCPolynomial = ?
 	SPI_Init(SPI1, &SPI_init);
 
 	SPI_Cmd(SPI1, ENABLE);
 
+#ifndef STREAM
+	// interrupt when a byte has been received (exchanged)
+	SPI_I2S_ITConfig(SPI1, SPI_I2S_IT_RXNE, ENABLE);
+	NVIC_init.NVIC_IRQChannel = SPI1_IRQn;
+	NVIC_init.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_init.NVIC_IRQChannelSubPriority = 0;
+	NVIC_init.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_init);
+#endif
+
 	// Configure PB5 so it can be bit-banged (NSS, SS_L)
 	RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOB, ENABLE);
 	// (re-use the previous GPIO_Init structure)
@@ -362,10 +487,9 @@ void configure_SPI() {
  *      
  *      // refresh display
  *      //
- *      // If this doesn't display right make sure you aren't
- *      // repeating too quickly.
- *      LCD_Glass_clear();
- *      LCD_GLASS_DisplayString((unsigned char*) str);
+ *      // Only the characters which changed are written
+ *      // so it can be repeated as often as needed.
+ *      LCD_GLASS_ShowString((unsigned char*) str);
  *   }
  *
  */
@@ -0,0 +1,97 @@
+/*
+ * NAME
+ * ----
+ *
+ * saddsub.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The "special" add/subtract in C, refer to saddsub.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <string.h>
+
+#include "saddsub.h"
+
+// a bit of each byte (lane) of a word
+#define LANE_BIT0   0x01010101
+#define LANE_BIT3   0x08080808
+#define LANE_NUM    0x0F0F0F0F
+
+/*
+ * saddsub_ref()
+ *
+ * As saddsub.s, the numbers are shifted in to the upper 4 bits
+ * so the sign and overflow are those of 32-bit numbers, which C
+ * does not give, so they are found from the sign bits.
+ */
+uint32_t saddsub_ref(uint32_t op, uint32_t a, uint32_t b) {
+    uint32_t r;
+    uint32_t v;
+
+    a <<= 28;
+    b <<= 28;
+
+    if (op) {
+        r = b - a;
+        // signs differ, and the result has that of a
+        v = ((b ^ a) & (b ^ r)) >> 31;
+    } else {
+        r = a + b;
+        // signs the same, and the result has the other
+        v = (~(a ^ b) & (a ^ r)) >> 31;
+    }
+
+    return (r >> 28) | (v << 4) | ((r >> 31) << 5);
+}
+
+/*
+ * saddsub_word()
+ *
+ * Four bytes (lanes) at once, 'sub' is all ones in the lower 4
+ * bits of each lane to subtract, or zero to add.
+ *
+ * A subtract, B - A, is B + ~A + 1.  Each sum is at most
+ * 15 + 15 + 1, so it never carries in to the next lane.  The
+ * 4-bit result is the lower 4 bits of each sum, N is its bit 3
+ * and V is set when both numbers added have the same sign and
+ * the result does not.
+ */
+static uint32_t saddsub_word(uint32_t sub, uint32_t w) {
+    uint32_t a = (w & LANE_NUM) ^ sub;
+    uint32_t b = (w >> 4) & LANE_NUM;
+    uint32_t r = (a + b + (sub & LANE_BIT0)) & LANE_NUM;
+    uint32_t n = r & LANE_BIT3;
+    uint32_t v = ~(a ^ b) & (a ^ r) & LANE_BIT3;
+
+    return r | (v << 1) | (n << 2);
+}
+
+void saddsub_batch(uint32_t op, const uint8_t *packed, uint8_t *out,
+                    uint32_t n) {
+    uint32_t sub = op ? LANE_NUM : 0;
+    uint32_t w;
+
+    // the lanes are independent, so the byte order does not matter
+    for (; n >= 4; n -= 4) {
+        memcpy(&w, packed, 4);
+        w = saddsub_word(sub, w);
+        memcpy(out, &w, 4);
+        packed += 4;
+        out += 4;
+    }
+
+    if (n) {
+        w = 0;
+        memcpy(&w, packed, n);
+        w = saddsub_word(sub, w);
+        memcpy(out, &w, n);
+    }
+}
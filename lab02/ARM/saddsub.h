@@ -0,0 +1,135 @@
+#ifndef SADDSUB_H
+#define SADDSUB_H
+
+/*
+ * NAME
+ * ----
+ *
+ * saddsub.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The "special" add/subtract of Lab 2.
+ *
+ * saddsub() (saddsub.s) adds (op 0) or subtracts (op 1) two
+ * 4-bit two's complement numbers and returns the result with
+ * the sign (N) and overflow (V) of the operation,
+ *
+ *   XXXX XXXX XXXX XXXX XXXX XXXX XXNV AAAA (32 bits)
+ *
+ * A subtract is B - A, as saddsub.s does it.
+ *
+ * saddsub_ref() is the same operation in portable C, for the
+ * host, and the reference for the others.
+ *
+ * saddsub_batch() does it for 'n' bytes as they come from the
+ * SPI, A in the lower 4 bits and B in the upper 4 bits, and
+ * writes each result, 00NV AAAA, to 'out'.  Four bytes are
+ * done at once in a 32-bit word, one in each byte (lane), and
+ * N and V are found from the bits of the sums without any
+ * branches or flags.  'out' may be the same as 'packed'.
+ *
+ * saddsub1() to saddsub16() are the same operation for numbers
+ * of 1 to 16 bits, each made for its width by SADDSUB_DEFINE()
+ * so all of its shifts and masks are constants.  The result has
+ * the number in the lower 'bits', V above it and N above that,
+ * the layout of saddsub() for 4 bits.  The numbers come packed
+ * as those of the SPI, A in the lower 'bits' and B above it, so
+ * wider numbers are 2 or more bytes of the stream.
+ *
+ *  SADDSUB_A(bits, x)    A of the packed numbers 'x'
+ *  SADDSUB_B(bits, x)    B of them
+ *  SADDSUB_NUM(bits)     mask of the number of a result
+ *  SADDSUB_V(bits)       overflow bit of a result
+ *  SADDSUB_N(bits)       sign bit of a result
+ *
+ * SADDSUB_WIDTH is the width of Lab 2.  saddsub.s includes this
+ * header for it (WIDTH), only the macros are seen by the
+ * assembler.  The SPI frame of main.c is twice it, 8, 16 or
+ * 32 bits, as is WIDTH of the CPLD (main.v).
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  uint8_t rx[64];
+ *  uint8_t res[64];
+ *
+ *  r = saddsub(1, 0x3, 0x5);     // 5 - 3, r = 0x02
+ *  r = saddsub_ref(0, 0x7, 0x1); // 7 + 1, r = 0x38, N and V
+ *
+ *  saddsub_batch(0, rx, res, 64);
+ *
+ *  x = rx[0] | (rx[1] << 8) | (rx[2] << 16);
+ *  r = saddsub12(1, SADDSUB_A(12, x), SADDSUB_B(12, x));
+ *  if (r & SADDSUB_V(12))
+ *      // overflow
+ *
+ */
+
+#ifndef SADDSUB_WIDTH
+#define SADDSUB_WIDTH   4
+#endif
+
+/* the rest is C, not for saddsub.s */
+#ifndef __IAR_SYSTEMS_ASM__
+
+#include <stdint.h>
+
+#define SADDSUB_NUM(bits)   ((1UL << (bits)) - 1)
+#define SADDSUB_V(bits)     (1UL << (bits))
+#define SADDSUB_N(bits)     (2UL << (bits))
+
+#define SADDSUB_A(bits, x)  ((x) & SADDSUB_NUM(bits))
+#define SADDSUB_B(bits, x)  (((x) >> (bits)) & SADDSUB_NUM(bits))
+
+uint32_t saddsub(uint32_t op, uint32_t a, uint32_t b);
+
+uint32_t saddsub_ref(uint32_t op, uint32_t a, uint32_t b);
+
+void saddsub_batch(uint32_t op, const uint8_t *packed, uint8_t *out,
+                    uint32_t n);
+
+/*
+ * SADDSUB_DEFINE(bits)
+ *
+ * Defines saddsub<bits>().  As saddsub.s, the numbers are
+ * shifted in to the upper bits so the sign and overflow are
+ * those of 32-bit numbers.  A subtract, B - A, is B + ~A + 1,
+ * the ones below A carry the 1 up to it, and V is set when the
+ * numbers added have the same sign and the result does not.
+ * There are no branches.
+ */
+#define SADDSUB_DEFINE(bits) \
+static inline uint32_t saddsub##bits(uint32_t op, uint32_t a, \
+                                        uint32_t b) { \
+    uint32_t sub = 0 - (op != 0); \
+    uint32_t x = (a << (32 - (bits))) ^ sub; \
+    uint32_t y = b << (32 - (bits)); \
+    uint32_t r = x + y + (sub & 1); \
+    uint32_t v = (~(x ^ y) & (x ^ r)) >> 31; \
+ \
+    return (r >> (32 - (bits))) | (v << (bits)) | \
+            ((r >> 31) << ((bits) + 1)); \
+}
+
+SADDSUB_DEFINE(1)
+SADDSUB_DEFINE(2)
+SADDSUB_DEFINE(3)
+SADDSUB_DEFINE(4)
+SADDSUB_DEFINE(5)
+SADDSUB_DEFINE(6)
+SADDSUB_DEFINE(7)
+SADDSUB_DEFINE(8)
+SADDSUB_DEFINE(9)
+SADDSUB_DEFINE(10)
+SADDSUB_DEFINE(11)
+SADDSUB_DEFINE(12)
+SADDSUB_DEFINE(13)
+SADDSUB_DEFINE(14)
+SADDSUB_DEFINE(15)
+SADDSUB_DEFINE(16)
+
+#endif  /* __IAR_SYSTEMS_ASM__ */
+
+#endif
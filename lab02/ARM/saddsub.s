@@ -1,7 +1,15 @@
 
+; width of the numbers (1 to 16 bits), SADDSUB_WIDTH of
+; saddsub.h so there is only the one to change, the C part
+; of it is left out for the assembler
+#include "saddsub.h"
+WIDTH EQU SADDSUB_WIDTH
+; shift of the numbers in to the upper bits
+SHIFT EQU (32 - WIDTH)
+
 ; bit masks for N and V, see below for meaning
-V_BIT EQU 0x00000010
-N_BIT EQU 0x00000020
+V_BIT EQU (1 << WIDTH)
+N_BIT EQU (2 << WIDTH)
 
 	PUBLIC saddsub
 
@@ -19,18 +27,21 @@ N_BIT EQU 0x00000020
 ;        V is 1 if overflow occurred, 0 otherwise
 ;        A is the number with MSB at the left
 ;        X don't care
+;  (for a WIDTH of 4, wider numbers have more A bits and N and V
+;  are above them)
 ;
 ;  saddsub() is a "special" addition/subtraction function.
 ;  It adds the two numbers, A and B, then zeros out the
-;  upper 28 bits by shifting the result in to the lower 4 bits.
-;  And in bits 5 and 6 (0 offset) it stores the overflow (V)
+;  upper SHIFT bits by shifting the result in to the lower WIDTH
+;  bits.  And in the bits above (bits 4 and 5 for a WIDTH of 4,
+;  0 offset) it stores the overflow (V)
 ;  and sign (N) status from the CPSR register.
 ;
 saddsub
 
-	; shift the numbers in to the high 4 bits
-	LSL r1, r1, #28
-	LSL r2, r2, #28
+	; shift the numbers in to the high WIDTH bits
+	LSL r1, r1, #SHIFT
+	LSL r2, r2, #SHIFT
 
 	CMP r0, #0
 	BEQ _ADD
@@ -44,8 +55,8 @@ _SUB:
 _ADD:
 	ADDS r0, r1, r2  ; r0 = r1 + r2
 _DONE:
-	LSR r0, r0, #28
-    ; add/sub done, and upper 28 bits zero
+	LSR r0, r0, #SHIFT
+    ; add/sub done, and upper SHIFT bits zero
 
     ; set the overflow (V) and sign bit (N)
     BVC _V_DONE     ; skip if doesn't need to be set
@@ -0,0 +1,105 @@
+#ifndef SCHED_H
+#define SCHED_H
+
+#include "stm32l1xx.h"
+
+#include "tick.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * sched.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * A cooperative (run to completion) scheduler.
+ *
+ * A task is a function which is run when the task is woken.
+ * It does a small amount of work and returns, it must never
+ * wait for something.  Instead it wakes itself later
+ * (sched_wake_after()) or is woken by whatever it is waiting
+ * for, such as an interrupt or another task.
+ *
+ * Each task has a small queue of events (sending one also
+ * wakes it) which it should empty each time it is run.
+ * sched_wake(), sched_send() and sched_wake_after() may be
+ * called from interrupts.
+ *
+ * sched_run() runs the woken tasks, in the order they were
+ * added, until sched_stop() is called.  When none are woken
+ * it sleeps (tick_wait(), WFI on the board) until the next
+ * interrupt.  The timers are those of tick.h so the time base
+ * must be running (see timebase.h).
+ *
+ * This part does not touch any hardware so it can also be
+ * built on a host (../sim/sched_sim.c).
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  sched_task blink_task;
+ *  sched_task ui_task;
+ *
+ *  void blink(sched_task *t) {
+ *      GPIO_ToggleBits(GPIOB, GPIO_Pin_7);
+ *      sched_wake_after(t, 500);
+ *  }
+ *
+ *  void ui(sched_task *t) {
+ *      int event;
+ *
+ *      while ((event = sched_get(t)) != SCHED_NONE) {
+ *          // handle it
+ *      }
+ *  }
+ *
+ *  sched_add(&blink_task, blink);
+ *  sched_add(&ui_task, ui);
+ *  sched_wake(&blink_task);
+ *
+ *  // from an interrupt
+ *  sched_send(&ui_task, 3);
+ *
+ *  sched_run();  // does not return
+ *
+ */
+
+// events held in each task's queue
+#define SCHED_QUEUE_LEN 8
+
+// sched_get() when the queue is empty
+#define SCHED_NONE (-1)
+
+typedef struct sched_task {
+    void (*run)(struct sched_task *);
+    struct sched_task *next;        // list of all the tasks
+    volatile uint8_t ready;         // woken, run it
+    volatile uint8_t head;          // next event to get
+    volatile uint8_t tail;          // next free place in events
+    uint8_t events[SCHED_QUEUE_LEN];
+    tick_timer timer;               // used by sched_wake_after()
+} sched_task;
+
+void sched_init();
+
+void sched_add(sched_task *, void (*)(sched_task *));
+
+void sched_wake(sched_task *);
+
+void sched_wake_after(sched_task *, uint32_t);
+
+void sched_cancel(sched_task *);
+
+int sched_send(sched_task *, uint8_t);
+
+int sched_get(sched_task *);
+
+unsigned int sched_run_once();
+
+void sched_run();
+
+void sched_stop();
+
+#endif
@@ -0,0 +1,157 @@
+/*
+ * NAME
+ * ----
+ *
+ * spi_stream.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Continuous exchange of frames on SPI1 by DMA, refer to
+ * spi_stream.h for a description of how it is used.
+ *
+ * The SPI1 DMA requests are fixed to the following channels
+ * [Pg. 213]{RM0038}
+ *
+ *  request   channel
+ *  -------   -------
+ *  SPI1_RX   DMA1 Channel 2
+ *  SPI1_TX   DMA1 Channel 3
+ *
+ * Only the receive channel generates interrupts, half transfer
+ * (HT) and transfer complete (TC), one for each half of the
+ * frames.  Both channels are circular so neither has to be
+ * started again and the SPI never stops between frames.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "stm32l1xx.h"
+
+#include "spi_stream.h"
+
+volatile uint32_t spi_stream_halves = 0;
+
+static uint8_t *stream_tx;
+static uint8_t *stream_rx;
+static uint16_t half;
+static spi_stream_fn stream_fn;
+
+// {{{ spi_stream_start()
+/*
+ * spi_stream_start()
+ *
+ * Program both channels, circular over the 'n' frames (even),
+ * and start them.
+ *
+ * The receive channel is enabled first so that no frame
+ * can be received before it is ready.  The transfer begins as
+ * soon as the transmit channel is enabled since TXE is already
+ * set.
+ */
+void spi_stream_start(uint8_t *tx, uint8_t *rx, uint16_t n,
+                        spi_stream_fn fn) {
+    DMA_InitTypeDef DMA_init;
+    NVIC_InitTypeDef NVIC_init;
+
+    stream_tx = tx;
+    stream_rx = rx;
+    half = n / 2;
+    stream_fn = fn;
+    spi_stream_halves = 0;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(DMA1_Channel2);
+    DMA_DeInit(DMA1_Channel3);
+
+    // drain anything left over in the receive register
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE))
+        SPI_I2S_ReceiveData(SPI1);
+
+    DMA_StructInit(&DMA_init);
+    DMA_init.DMA_PeripheralBaseAddr = (uint32_t) &(SPI1->DR);
+    DMA_init.DMA_BufferSize = 2 * half;
+    DMA_init.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_init.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_init.DMA_Mode = DMA_Mode_Circular;
+    DMA_init.DMA_M2M = DMA_M2M_Disable;
+
+    // RX, SPI1->DR -> rx
+    DMA_init.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_init.DMA_Priority = DMA_Priority_VeryHigh;
+    DMA_init.DMA_MemoryBaseAddr = (uint32_t) rx;
+    DMA_Init(DMA1_Channel2, &DMA_init);
+
+    // TX, tx -> SPI1->DR
+    DMA_init.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_init.DMA_Priority = DMA_Priority_High;
+    DMA_init.DMA_MemoryBaseAddr = (uint32_t) tx;
+    DMA_Init(DMA1_Channel3, &DMA_init);
+
+    DMA_ITConfig(DMA1_Channel2, DMA_IT_HT | DMA_IT_TC, ENABLE);
+
+    NVIC_init.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+    NVIC_init.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_init.NVIC_IRQChannelSubPriority = 0;
+    NVIC_init.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_init);
+
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+    GPIO_ResetBits(GPIOB, GPIO_Pin_5);  // NSS = 0, enable
+
+    DMA_Cmd(DMA1_Channel2, ENABLE);
+    DMA_Cmd(DMA1_Channel3, ENABLE);
+}
+// }}}
+
+// {{{ spi_stream_stop()
+/*
+ * spi_stream_stop()
+ *
+ * Stop sending, let the frame on the wire finish and
+ * release NSS.
+ */
+void spi_stream_stop() {
+    DMA_Cmd(DMA1_Channel3, DISABLE);
+
+    while (! SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE));
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY));
+
+    DMA_Cmd(DMA1_Channel2, DISABLE);
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+
+    GPIO_SetBits(GPIOB, GPIO_Pin_5);  // NSS = 1, disable
+}
+// }}}
+
+// {{{ DMA1_Channel2_IRQHandler()
+/*
+ * DMA1_Channel2_IRQHandler()
+ *
+ * Half of the frames have been received, the first (HT) or
+ * the second (TC).
+ */
+void DMA1_Channel2_IRQHandler() {
+    if (DMA_GetITStatus(DMA1_IT_HT2)) {
+        DMA_ClearITPendingBit(DMA1_IT_HT2);
+        stream_fn(stream_rx, stream_tx, half);
+        spi_stream_halves++;
+    }
+
+    if (DMA_GetITStatus(DMA1_IT_TC2)) {
+        DMA_ClearITPendingBit(DMA1_IT_TC2);
+        stream_fn(stream_rx + half, stream_tx + half, half);
+        spi_stream_halves++;
+    }
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,66 @@
+#ifndef SPI_STREAM_H
+#define SPI_STREAM_H
+
+#include <stdint.h>
+
+/*
+ * NAME
+ * ----
+ *
+ * spi_stream.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Continuous exchange of 8-bit frames on SPI1 by DMA.
+ *
+ * The frames of 'tx' are sent and those received are stored in
+ * 'rx', back to back with NSS (PB5) held low, by DMA1 (channel 3
+ * for transmit, channel 2 for receive) in circular mode.  When
+ * the end of 'rx' is reached it starts again at the beginning,
+ * and so does 'tx', until spi_stream_stop().
+ *
+ * Each time half of the 'n' frames have been received 'fn' is
+ * called, from the DMA interrupt, with that half of 'rx' and the
+ * same half of 'tx'.  Those 'tx' frames were just sent and will
+ * be sent again the next time around, so what 'fn' writes there
+ * is sent 'n' frames after the frames it was given.  'fn' must
+ * be done before the DMA comes back to them, within the time of
+ * n / 2 frames.
+ *
+ * The slave must latch each frame after 8 bits without NSS being
+ * set (the CPLD, ../CPLD/main.v, counts them).
+ *
+ * The SPI must already be configured (see configure_SPI() in
+ * main.c) for 8-bit data.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  uint8_t tx[64];
+ *  uint8_t rx[64];
+ *
+ *  void calc(const uint8_t *rx, uint8_t *tx, uint16_t n) {
+ *      saddsub_batch(0, rx, tx, n);
+ *  }
+ *
+ *  configure_SPI();
+ *  spi_stream_start(tx, rx, 64, calc);
+ *
+ *  // spi_stream_halves counts the calls of calc()
+ *
+ *  spi_stream_stop();
+ *
+ */
+
+typedef void (*spi_stream_fn)(const uint8_t *rx, uint8_t *tx, uint16_t n);
+
+// halves of the frames done, the number of calls of 'fn'
+extern volatile uint32_t spi_stream_halves;
+
+void spi_stream_start(uint8_t *tx, uint8_t *rx, uint16_t n,
+                        spi_stream_fn fn);
+
+void spi_stream_stop();
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * NAME
+ * ----
+ *
+ * tick.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Millisecond time keeping and software timers,
+ * refer to tick.h.
+ *
+ * The active timers are kept in a list sorted by when they
+ * expire, so each tick only has to look at the head of it.
+ * The list is changed from both the main loop and the tick
+ * interrupt so interrupts are masked while it is.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "tick.h"
+
+static volatile uint32_t ticks = 0;
+
+// active timers, soonest first
+static tick_timer *timers = 0;
+
+static void list_insert(tick_timer *);
+static void list_remove(tick_timer *);
+
+/*
+ * tick_init()
+ *
+ * Set the current time and stop all the timers.
+ * (Only needed to start at something other than zero.)
+ */
+void tick_init(uint32_t start) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    ticks = start;
+    while (timers) {
+        timers->active = 0;
+        timers = timers->next;
+    }
+    __set_PRIMASK(primask);
+}
+
+/*
+ * tick()
+ *
+ * One millisecond has passed, call the callbacks of any
+ * timers which have expired.
+ */
+void tick() {
+    tick_timer *t;
+
+    ticks++;
+
+    while (timers && (int32_t) (ticks - timers->expires) >= 0) {
+        t = timers;
+        timers = t->next;
+        t->active = 0;
+
+        // it may restart itself
+        if (t->callback)
+            t->callback(t);
+    }
+}
+
+uint32_t now() {
+    return ticks;
+}
+
+/*
+ * delay_ms()
+ *
+ * Wait for at least 'ms' milliseconds (at most one more),
+ * sleeping in between ticks.
+ */
+void delay_ms(uint32_t ms) {
+    uint32_t start = ticks;
+
+    if (0 == ms)
+        return;
+
+    while (ticks - start <= ms)
+        tick_wait();
+}
+
+// {{{ timers
+/*
+ * timer_start()
+ *
+ * (Re)start 't' so that 'callback' is called in 'ms' milliseconds.
+ */
+void timer_start(tick_timer *t, uint32_t ms, void (*callback)(tick_timer *)) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (t->active)
+        list_remove(t);
+
+    t->expires = ticks + ms;
+    t->callback = callback;
+    t->active = 1;
+    list_insert(t);
+    __set_PRIMASK(primask);
+}
+
+/*
+ * timer_stop()
+ *
+ * Stop 't' if it is active, its callback will not be called.
+ */
+void timer_stop(tick_timer *t) {
+    uint32_t primask = __get_PRIMASK();
+
+    __disable_irq();
+    if (t->active) {
+        list_remove(t);
+        t->active = 0;
+    }
+    __set_PRIMASK(primask);
+}
+
+// insert in to the sorted list, after any that expire at the same time
+static void list_insert(tick_timer *t) {
+    tick_timer **p = &timers;
+
+    while (*p && (int32_t) (t->expires - (*p)->expires) >= 0)
+        p = &(*p)->next;
+
+    t->next = *p;
+    *p = t;
+}
+
+static void list_remove(tick_timer *t) {
+    tick_timer **p = &timers;
+
+    while (*p && *p != t)
+        p = &(*p)->next;
+
+    if (*p)
+        *p = t->next;
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,79 @@
+#ifndef TICK_H
+#define TICK_H
+
+#include "stm32l1xx.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * tick.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Millisecond time keeping and one-shot software timers.
+ *
+ * tick() advances the time by one millisecond.  On the board
+ * it is called from the SysTick interrupt (see timebase.h), on
+ * a host it can be called by a test (../sim/timebase_test.c).
+ * This part does not touch any hardware except for masking
+ * interrupts around the timer list.
+ *
+ * now() is the number of milliseconds since the start.
+ * It wraps after about 49 days so times must be compared
+ * by their difference (now() - start >= ms), never directly.
+ *
+ * A timer calls its callback, from the tick interrupt, once
+ * the given number of milliseconds has passed.  A timer can be
+ * restarted from its own callback to make it periodic.
+ * The tick_timer structures are owned by the caller and must
+ * stay in place while they are active.
+ *
+ * tick_wait() is provided by the hardware (timebase.c), it
+ * sleeps until the next interrupt.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  uint32_t start;
+ *  tick_timer t;
+ *
+ *  start = now();
+ *  delay_ms(250);
+ *  // now() - start is 250 (or 251)
+ *
+ *  void blink(tick_timer *t) {
+ *      // toggle an LED
+ *      timer_start(t, 500, blink);  // again in 500 ms
+ *  }
+ *
+ *  timer_start(&t, 500, blink);
+ *  ...
+ *  timer_stop(&t);
+ *
+ */
+
+typedef struct tick_timer {
+    uint32_t expires;                       // now() when it expires
+    void (*callback)(struct tick_timer *);  // called when it expires
+    struct tick_timer *next;                // list of active timers
+    volatile uint8_t active;                // set while waiting
+} tick_timer;
+
+void tick_init(uint32_t);
+
+void tick();
+
+uint32_t now();
+
+void delay_ms(uint32_t);
+
+void timer_start(tick_timer *, uint32_t, void (*)(tick_timer *));
+
+void timer_stop(tick_timer *);
+
+// provided by the hardware (timebase.c), sleep until an interrupt
+void tick_wait();
+
+#endif
@@ -1,8 +1,7 @@
-
 /*
  * NAME
  * ----
- * 
+ *
  *  main-test - test module for 'main'
  *
  * INTRODUCTION
@@ -10,17 +9,29 @@
  *
  * This module acts as an SPI master to test the main.v
  * module which behaves as an SPI slave.
- * 
- * Currently this module just sends data to the slave and
- * discards what is returned.  But this is still useful
- * for making sure that the slave is sending the bits on
- * the correct clock edge.
+ *
+ * It is built for one frame WIDTH (8, 16 or 32 bits), given
+ * to iverilog with -Ptest.WIDTH=16, and the main module is
+ * built with the same WIDTH.  Random frames are exchanged and
+ * for each one the switches received (MISO) and the LEDs
+ * written (MOSI) are checked.  It displays PASS or FAIL.
+ *
+ * The frames are exchanged one at a time, SS_L set after each,
+ * and then streamed, back to back with SS_L held low as the ARM
+ * does with DMA.
+ *
+ * Each is timed at the SCK rate of the ARM (SPI1 at 16 MHz / 256,
+ * SPI_HALF) and the frames and bits per second are displayed.
+ * This is only the time on the SPI, the time the ARM takes
+ * between the frames and between the two words of a 32 bit
+ * frame is not included.
  *
  * This can be useful as a sanity check of the changes which
  * are made to main.v.  But running on a CPLD or FPGA has its
  * own set of problems which may not be shown by this test.
  *
- * It is configured to produce an output file suitable for Gtkwave.
+ * It is configured to produce an output file suitable for Gtkwave,
+ * DUMPFILE (output.vcd).
  *
  * If things aren't working properly here are some things to look for.
  *
@@ -38,80 +49,165 @@
  *
  */
 
+`timescale 1ns / 1ns
+
 `include "main.v"
 
+`ifndef DUMPFILE
+`define DUMPFILE "output.vcd"
+`endif
+
 // Reset used in Lattice MachXO CPLD
-// Defined the module here to never reset.
-module GSR(output wire GSR);
-	assign GSR = 1;
-	//GSR GSR_INST(.GSR(reset));
+// Here we create a pseudo one that does nothing,
+// rst_l is driven by the test bench.
+module GSR(input GSR);
 endmodule
 
 module test;
 
+	// bits in a frame
+	parameter WIDTH = 8;
+	// frames checked
+	parameter FRAMES = 1000;
+	// half of an SCK period, 16 MHz / 256 (ns)
+	parameter SPI_HALF = 8000;
+
 	reg sclk;
 
 	reg reset;
 	reg SS_L;
 	reg MOSI;
 	wire MISO;
-	wire [7:0] led_ext;
-	wire [7:0] in_sw;
-
-	main m1(reset, SS_L, sclk, MOSI, MISO, led_ext, in_sw);
-
-	wire [7:0] mosi_val;
-	assign mosi_val = 8'h4f;
-
-	assign in_sw = 8'hb7;
+	wire [WIDTH-1:0] led_ext;
+	reg [WIDTH-1:0] in_sw;
+
+	main #(.WIDTH(WIDTH)) m1(reset, SS_L, sclk, MOSI, MISO, led_ext, in_sw);
+
+	integer errors;
+	integer checks;
+
+	// {{{ frame()
+	/*
+	 * frame(stream, tx, rx)
+	 *
+	 * Exchange one frame, 'tx' is sent MSB first with CPOL = 0
+	 * and CPHA = 0 and what is received is returned in 'rx'.
+	 *
+	 * As the ARM does, SS_L is set before the last falling
+	 * edge of SCK, the slave latches the frame on that edge.
+	 * When streaming it is left low and the next frame follows.
+	 */
+	task frame;
+		input stream;
+		input [WIDTH-1:0] tx;
+		output [WIDTH-1:0] rx;
+		integer i;
+		begin
+			SS_L = 0; // enabled
+			for (i = WIDTH - 1; i >= 0; i = i - 1) begin
+				MOSI = tx[i];
+				#SPI_HALF;
+				// sample
+				sclk = 1;
+				rx[i] = MISO;
+				#SPI_HALF;
+				// propagate, the last after SS_L is set
+				if (0 == i && ! stream)
+					SS_L = 1; // disable
+				sclk = 0;
+			end
+			// the latch is seen after this edge
+			if (stream)
+				#1;
+			else
+				#SPI_HALF;
+		end
+	endtask
+	// }}}
+
+	// {{{ check()
+	task check;
+		input [8*16:1] name;
+		input [WIDTH-1:0] got;
+		input [WIDTH-1:0] expected;
+		begin
+			checks = checks + 1;
+			if (got !== expected) begin
+				errors = errors + 1;
+				$display("%0s: expected %h, got %h", name, expected, got);
+			end
+		end
+	endtask
+	// }}}
 
-	reg [4:0] i;
+	integer n;
+	integer stream;
+	integer seed;
+	reg [WIDTH-1:0] tx;
+	reg [WIDTH-1:0] rx;
+	reg [WIDTH-1:0] sw;
+	time t;
 
 	initial begin
-		$dumpfile("output.vcd");
+		$dumpfile(`DUMPFILE);
 		$dumpvars(0,test);
 
-		/*
-		 * This section generates a sequence of an SPI master.
-		 * The value to be output is stored in 'mosi_val'.
-		 *
-		 * It outputs the MSB first and is defined with CPOL = 0 and CPHA = 0.
-		 */
+		errors = 0;
+		checks = 0;
+		seed = 344;
 
-		reset = 0;  // not reset
 		sclk = 0;  // CPOL = 0 -> start clock at 0
 		MOSI = 0;
-
-		// This is needed for the slave since it loads its
-		// write register when the sclk goes low while it is
-		// disabled.
 		SS_L = 1; // disabled;
+		in_sw = 0;
+
+		reset = 1;
+		#10 reset = 0;
+		#10 reset = 1;
+
+		// This is needed for the slave since it loads the
+		// switches when the sclk goes low while it is disabled.
 		#1 sclk = 1;
 		#1 sclk = 0;
-		#1 SS_L = 0; // enabled;
-
-		MOSI = mosi_val[7];
-
-		i = 7;
-		repeat (7) begin
-			i = i - 1;
-			#1;
-			// sample
-			sclk = 1;
-			#1;
-			// propagate
-			sclk = 0;
-			MOSI = mosi_val[i];
+		#SPI_HALF;
+
+		for (stream = 0; stream < 2; stream = stream + 1) begin
+			t = $time;
+			for (n = 0; n < FRAMES; n = n + 1) begin
+				// random of any width, $random is 32 bits
+				tx = {$random(seed), $random(seed)};
+
+				// loaded by the last latch, sent by this frame
+				sw = in_sw;
+				// loaded by the latch of this frame
+				in_sw = {$random(seed), $random(seed)};
+
+				frame(stream, tx, rx);
+
+				// switch closed -> 1
+				check("switches", rx, ~sw);
+				// LED on -> 1
+				check("leds", ~led_ext, tx);
+			end
+			t = $time - t;
+
+			$display("%0d bit frames%0s: %0d ns/frame, %0d frames/s, %0d bits/s",
+						WIDTH, stream ? " streamed" : "", t / FRAMES,
+						1000000000 * FRAMES / t,
+						WIDTH * (1000000000 * FRAMES / t));
+
+			// end the stream
+			#SPI_HALF SS_L = 1;
+			#SPI_HALF;
 		end
 
-		#1 sclk = 1;
-
-		#1;
-		SS_L = 1; // disable
-		sclk = 0;
-		#1;
+		if (errors)
+			$display("FAIL: %0d of %0d checks", errors, checks);
+		else
+			$display("PASS: %0d checks", checks);
 
 		$finish;
 	end
 endmodule
 
+// vim:foldmethod=marker
@@ -25,6 +25,21 @@
  *  This was done because in the other orientation it was impossible
  *  to determine when to initialize the data because ss_l was
  *  the same value when it is sampling/propagating.
+ *
+ *  A frame (SS_L low) is WIDTH bits, 8 (default), 16 or 32, the
+ *  switches (in_sw) are sent and the LEDs (led_ext) are written
+ *  with all of them at once.  The master must use the same
+ *  frame, the ARM sends 8 or 16 bit words, two 16 bit words for
+ *  32 bits with SS_L held low between them.  Wider frames need
+ *  pins for the extra switches and LEDs in main.lpf.
+ *
+ *  The last (falling) SCLK edge of a frame comes after SS_L is
+ *  set, so there are WIDTH - 1 propagates with SS_L low.
+ *
+ *  The propagates are counted and the last edge of a frame is
+ *  also the latch when SS_L is still low.  So frames may be sent
+ *  back to back with SS_L held low (streaming, the ARM with DMA),
+ *  each one is latched after WIDTH bits.
  *  
  * AUTHOR
  * ------
@@ -33,23 +48,23 @@
  *
  */
 
-module main(
+module main #(
+	// bits in a frame
+	parameter WIDTH = 8
+	) (
 	input wire rst_l,
 	input wire ss_l,
 	input wire sclk,
 	input wire mosi,
 	output wire miso,
-	output wire [7:0] led_ext,
-	input wire [7:0] in_sw
+	output wire [WIDTH-1:0] led_ext,
+	input wire [WIDTH-1:0] in_sw
 	);
 
 	GSR GSR_INST(.GSR(rst_l));
 
 	// N is the last offset of data that is transferred.
-	// Currently there are 8-bits (0 - 7).
-	// This could be changed to support 16 bits
-	// needed.
-	parameter N=7;
+	localparam N = WIDTH - 1;
 
 	// provide user feedback for switch actuation
 	wire [N:0] n_in_sw;  // negated version of in_sw, sw closed -> set
@@ -60,6 +75,8 @@ module main(
 	wire [N:0] r_next;
 	// write register, for storing received data
 	reg [N:0] w_reg;
+	// propagates in this frame, up to 31
+	reg [5:0] count;
 
 	// store the received data on the external led's
 	assign led_ext = ~(w_reg);  // invert so 0 -> off, 1 -> on
@@ -77,17 +94,21 @@ module main(
 
 	always @(negedge sclk or negedge rst_l) begin
 		if (~rst_l) begin
-			r_reg <= 8'b0;
-			w_reg <= 8'b0;
+			r_reg <= {WIDTH{1'b0}};
+			w_reg <= {WIDTH{1'b0}};
+			count <= 6'd0;
 		end else begin
-			if (ss_l) begin
+			if (ss_l || count == N) begin
 				// RESET
 				// reset when sclk falls while ss_l is high (disabled)
+				// or at the end of a frame while it is low (streaming)
+				count <= 6'd0;
 				r_reg <= n_in_sw;  // switch input
 				w_reg <= r_next; // update the write register with the last read
 				// use r_next (not r_reg) so we don't miss the last mosi (SAMPLE)
 			end else begin
 				// PROPAGATE
+				count <= count + 6'd1;
 				r_reg <= r_next;
 				//w_reg <= w_reg;
 			end
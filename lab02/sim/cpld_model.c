@@ -0,0 +1,94 @@
+/*
+ * NAME
+ * ----
+ *
+ * cpld_model.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Model of the Lab 2 CPLD, refer to cpld_model.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "cpld_model.h"
+
+/*
+ * cpld_model_init()
+ *
+ * Reset, with frames of 'width' bits (8, 16 or 32).
+ */
+void cpld_model_init(cpld_model *m, unsigned int width) {
+    m->width = width;
+    m->mask = (width < 32) ? (1UL << width) - 1 : 0xffffffff;
+
+    m->ss_l = 1;
+    m->in_sw = m->mask;     // all open
+    m->r_reg = 0;
+    m->w_reg = 0;
+    m->led_ext = ~m->w_reg & m->mask;
+    m->mosi_sample = 0;
+    m->count = 0;
+
+    m->frames = 0;
+}
+
+void cpld_model_ss(cpld_model *m, int ss_l) {
+    m->ss_l = ss_l ? 1 : 0;
+}
+
+/*
+ * cpld_model_rise()
+ *
+ * The rising (sample) edge of SCK, returns MISO.
+ */
+int cpld_model_rise(cpld_model *m, int mosi) {
+    m->mosi_sample = mosi ? 1 : 0;
+
+    return (m->r_reg >> (m->width - 1)) & ~m->ss_l & 1;
+}
+
+/*
+ * cpld_model_fall()
+ *
+ * The falling (propagate) edge of SCK.
+ */
+void cpld_model_fall(cpld_model *m) {
+    uint32_t r_next = ((m->r_reg << 1) | m->mosi_sample) & m->mask;
+
+    if (m->ss_l || m->count == m->width - 1) {
+        // latch
+        m->count = 0;
+        m->r_reg = ~m->in_sw & m->mask;
+        m->w_reg = r_next;
+        m->led_ext = ~m->w_reg & m->mask;
+        m->frames++;
+    } else {
+        // propagate
+        m->count++;
+        m->r_reg = r_next;
+    }
+}
+
+/*
+ * cpld_model_frame()
+ *
+ * Exchange a frame of 'width' bits with SS_L as it is,
+ * 'tx' is sent MSB first and what is received returned.
+ */
+uint32_t cpld_model_frame(cpld_model *m, uint32_t tx) {
+    uint32_t rx = 0;
+    int i;
+
+    for (i = m->width - 1; i >= 0; i--) {
+        rx = (rx << 1) | cpld_model_rise(m, (tx >> i) & 1);
+        cpld_model_fall(m);
+    }
+
+    return rx;
+}
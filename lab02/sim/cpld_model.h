@@ -0,0 +1,71 @@
+#ifndef CPLD_MODEL_H
+#define CPLD_MODEL_H
+
+#include <stdint.h>
+
+/*
+ * NAME
+ * ----
+ *
+ * cpld_model.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Model of the Lab 2 CPLD (../CPLD/main.v) as seen from its
+ * pins, for use on a host (Linux) computer.
+ *
+ * It works an SCK edge at a time as main.v does.  On the rising
+ * edge MOSI is sampled and MISO is the MSB of the read register.
+ * On the falling edge the read register shifts, or the frame is
+ * latched, the LEDs get the bits received and the read register
+ * the switches, when SS_L is high or after 'width' bits with it
+ * low (streaming).
+ *
+ * The LED and switch values are kept at the pin level, so they
+ * are inverted just like on the board.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  cpld_model m;
+ *
+ *  cpld_model_init(&m, 8);
+ *  m.in_sw = ~0x35;                // pins, inverted
+ *
+ *  cpld_model_ss(&m, 0);           // enable
+ *  rx = cpld_model_frame(&m, 0x4f);
+ *  // ~m.led_ext is 0x4f, rx the switches of the last latch
+ *
+ */
+
+typedef struct {
+    unsigned int width;     // bits in a frame, WIDTH
+    uint32_t mask;
+
+    // pins
+    uint8_t ss_l;
+    uint32_t in_sw;
+    uint32_t led_ext;
+
+    // registers
+    uint32_t r_reg;
+    uint32_t w_reg;
+    uint8_t mosi_sample;
+    unsigned int count;     // propagates in this frame
+
+    // frames latched
+    unsigned long frames;
+} cpld_model;
+
+void cpld_model_init(cpld_model *, unsigned int);
+
+void cpld_model_ss(cpld_model *, int);
+
+int cpld_model_rise(cpld_model *, int);
+
+void cpld_model_fall(cpld_model *);
+
+uint32_t cpld_model_frame(cpld_model *, uint32_t);
+
+#endif
@@ -0,0 +1,318 @@
+/*
+ * NAME
+ * ----
+ *
+ * saddsub_test.c - test and benchmark of the add/subtract
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./saddsub_test [-q]
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * saddsub_ref() (../ARM/saddsub.c) is checked for every
+ * operation and pair of 4-bit numbers (512) against the sum
+ * or difference of the signed numbers.  Then saddsub_batch()
+ * is checked against saddsub_ref() for all of them, in place,
+ * and for each length and alignment of the last word, without
+ * writing past the end.
+ *
+ * saddsub1() to saddsub16() are each checked for every
+ * operation and pair of numbers of their width, from 512 for
+ * 1 bit to 2^33 for 16 bits, against the signed sum or
+ * difference.  'saddsub_test -q' only checks up to 12 bits.
+ *
+ * Then the time per byte of saddsub_ref() and saddsub_batch(),
+ * and the time and cycles of the host time stamp counter (x86)
+ * per operation of each width are measured and displayed.  They
+ * are host timings, only to compare the widths with each other,
+ * not the cycles of the Cortex-M3.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#ifdef __x86_64__
+#include <x86intrin.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "saddsub.h"
+
+#define BENCH_BYTES 4096
+#define BENCH_LOOPS 20000
+#define BENCH_OPS   50000000
+
+static unsigned long errors;
+static unsigned long checks;
+
+static void check(const char *name, uint32_t op, uint8_t byte,
+                    uint32_t got, uint32_t expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: op %u byte %.2x expected %.2x, got %.2x\n",
+                    name, op, byte, expected, got);
+        errors++;
+    }
+}
+
+// {{{ checks
+/*
+ * The result as it should be, from the signed numbers.
+ */
+static uint32_t expected(int bits, uint32_t op, uint32_t a, uint32_t b) {
+    int32_t sign = 1L << (bits - 1);
+    int32_t sa;
+    int32_t sb;
+    int32_t r;
+    uint32_t res;
+
+    // sign extend
+    sa = (int32_t) (a ^ sign) - sign;
+    sb = (int32_t) (b ^ sign) - sign;
+
+    r = op ? sb - sa : sa + sb;
+
+    res = r & SADDSUB_NUM(bits);
+    if (r < -sign || r >= sign)
+        res |= SADDSUB_V(bits);
+    if (res & sign)
+        res |= SADDSUB_N(bits);
+
+    return res;
+}
+
+static void check_ref() {
+    uint32_t op;
+    int i;
+
+    for (op = 0; op < 2; op++) {
+        for (i = 0; i < 0x100; i++) {
+            check("saddsub_ref", op, i, saddsub_ref(op, i & 0x0f, i >> 4),
+                    expected(4, op, i & 0x0f, i >> 4));
+        }
+    }
+}
+
+static void check_batch() {
+    uint8_t in[0x100 + 8];
+    uint8_t out[0x100 + 8];
+    uint32_t op;
+    uint32_t n;
+    int off;
+    int i;
+
+    for (op = 0; op < 2; op++) {
+        for (i = 0; i < 0x100; i++)
+            in[i] = i;
+
+        // every pair
+        saddsub_batch(op, in, out, 0x100);
+        for (i = 0; i < 0x100; i++)
+            check("saddsub_batch", op, i, out[i],
+                    saddsub_ref(op, i & 0x0f, i >> 4));
+
+        // in place
+        memcpy(out, in, 0x100);
+        saddsub_batch(op, out, out, 0x100);
+        for (i = 0; i < 0x100; i++)
+            check("saddsub_batch in place", op, i, out[i],
+                    saddsub_ref(op, i & 0x0f, i >> 4));
+
+        // each length and alignment, nothing after it written
+        for (off = 0; off < 4; off++) {
+            for (n = 0; n < 12; n++) {
+                for (i = 0; i < 16; i++)
+                    in[off + i] = rand();
+                memset(out, 0xee, sizeof(out));
+
+                saddsub_batch(op, in + off, out + off, n);
+
+                for (i = 0; i < (int) n; i++)
+                    check("saddsub_batch length", op, in[off + i],
+                            out[off + i], saddsub_ref(op,
+                                in[off + i] & 0x0f, in[off + i] >> 4));
+                for (i = off + n; i < off + 16; i++)
+                    check("saddsub_batch end", op, 0, out[i], 0xee);
+            }
+        }
+    }
+}
+
+/*
+ * Every pair of numbers of a width.  Each width has its own
+ * check, so saddsub<bits>() is inlined as it would be in use.
+ */
+#define CHECK_WIDTH(bits) \
+static unsigned long check_width##bits() { \
+    uint32_t op; \
+    uint32_t a; \
+    uint32_t b; \
+    unsigned long bad = 0; \
+ \
+    for (op = 0; op < 2; op++) \
+        for (a = 0; a <= SADDSUB_NUM(bits); a++) \
+            for (b = 0; b <= SADDSUB_NUM(bits); b++) \
+                bad += saddsub##bits(op, a, b) != \
+                        expected(bits, op, a, b); \
+ \
+    return bad; \
+}
+
+CHECK_WIDTH(1)  CHECK_WIDTH(2)  CHECK_WIDTH(3)  CHECK_WIDTH(4)
+CHECK_WIDTH(5)  CHECK_WIDTH(6)  CHECK_WIDTH(7)  CHECK_WIDTH(8)
+CHECK_WIDTH(9)  CHECK_WIDTH(10) CHECK_WIDTH(11) CHECK_WIDTH(12)
+CHECK_WIDTH(13) CHECK_WIDTH(14) CHECK_WIDTH(15) CHECK_WIDTH(16)
+
+static unsigned long (*const check_width[])() = {
+    0,
+    check_width1,  check_width2,  check_width3,  check_width4,
+    check_width5,  check_width6,  check_width7,  check_width8,
+    check_width9,  check_width10, check_width11, check_width12,
+    check_width13, check_width14, check_width15, check_width16,
+};
+
+#define MAX_WIDTH   16
+#define QUICK_WIDTH 12
+
+static void check_widths(int max) {
+    int bits;
+    unsigned long bad;
+
+    for (bits = 1; bits <= max; bits++) {
+        bad = check_width[bits]();
+
+        checks++;
+        if (bad) {
+            if (errors < 10)
+                fprintf(stderr, "saddsub%d: %lu of %lu wrong\n", bits,
+                        bad, 2UL << (2 * bits));
+            errors++;
+        }
+    }
+}
+// }}}
+
+// {{{ benchmark
+static double seconds() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t cycles() {
+#ifdef __x86_64__
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+// keeps the compiler from dropping the results
+static volatile uint32_t sink;
+
+/*
+ * Each result is the next A, so the operations are one after
+ * the other, as they would be on the board, and not done at
+ * once or moved out of the loop.
+ */
+#define BENCH_WIDTH(bits) \
+static void bench_width##bits() { \
+    uint32_t r = 0; \
+    uint32_t i; \
+    double t = seconds(); \
+    uint64_t c = cycles(); \
+ \
+    for (i = 0; i < BENCH_OPS; i++) \
+        r = saddsub##bits(i & 1, r, i); \
+    c = cycles() - c; \
+    t = seconds() - t; \
+    sink = r; \
+ \
+    printf("%5d %8.2f %9.2f\n", bits, t * 1e9 / BENCH_OPS, \
+            (double) c / BENCH_OPS); \
+}
+
+BENCH_WIDTH(1)  BENCH_WIDTH(2)  BENCH_WIDTH(3)  BENCH_WIDTH(4)
+BENCH_WIDTH(5)  BENCH_WIDTH(6)  BENCH_WIDTH(7)  BENCH_WIDTH(8)
+BENCH_WIDTH(9)  BENCH_WIDTH(10) BENCH_WIDTH(11) BENCH_WIDTH(12)
+BENCH_WIDTH(13) BENCH_WIDTH(14) BENCH_WIDTH(15) BENCH_WIDTH(16)
+
+static void bench_widths() {
+    printf("host timing (x86 TSC cycles, not Cortex-M3)\n");
+    printf("width    ns/op    tsc/op\n");
+    bench_width1();  bench_width2();  bench_width3();  bench_width4();
+    bench_width5();  bench_width6();  bench_width7();  bench_width8();
+    bench_width9();  bench_width10(); bench_width11(); bench_width12();
+    bench_width13(); bench_width14(); bench_width15(); bench_width16();
+}
+
+static void bench() {
+    static uint8_t in[BENCH_BYTES];
+    static uint8_t out[BENCH_BYTES];
+    double t_ref;
+    double t_batch;
+    double t;
+    int i;
+    int j;
+
+    for (i = 0; i < BENCH_BYTES; i++)
+        in[i] = rand();
+
+    t = seconds();
+    for (j = 0; j < BENCH_LOOPS; j++) {
+        for (i = 0; i < BENCH_BYTES; i++)
+            out[i] = saddsub_ref(j & 1, in[i] & 0x0f, in[i] >> 4);
+        sink = out[j % BENCH_BYTES];
+    }
+    t_ref = seconds() - t;
+
+    t = seconds();
+    for (j = 0; j < BENCH_LOOPS; j++) {
+        saddsub_batch(j & 1, in, out, BENCH_BYTES);
+        sink = out[j % BENCH_BYTES];
+    }
+    t_batch = seconds() - t;
+
+    t = 1e9 / ((double) BENCH_BYTES * BENCH_LOOPS);
+    printf("saddsub_ref   %6.2f ns/byte\n", t_ref * t);
+    printf("saddsub_batch %6.2f ns/byte (%.1fx)\n", t_batch * t,
+            t_ref / t_batch);
+}
+// }}}
+
+int main(int argc, char *argv[]) {
+    int quick = (argc > 1 && 0 == strcmp(argv[1], "-q"));
+
+    srand(344);
+
+    check_ref();
+    check_batch();
+    check_widths(quick ? QUICK_WIDTH : MAX_WIDTH);
+    bench();
+    bench_widths();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,118 @@
+/*
+ * NAME
+ * ----
+ *
+ * spi_stream_model.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Host replacement for ../ARM/spi_stream.c, refer to
+ * spi_stream_model.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <string.h>
+
+#include "spi_stream_model.h"
+
+// largest number of frames
+#define MAX_FRAMES 1024
+
+cpld_model *spi_stream_model;
+unsigned int spi_stream_prescaler = 256;
+unsigned long (*spi_stream_cycles)(uint16_t);
+
+uint64_t spi_stream_time;
+unsigned long spi_stream_frames;
+unsigned long spi_stream_late;
+
+volatile uint32_t spi_stream_halves;
+
+static uint8_t *stream_tx;
+static uint8_t *stream_rx;
+static uint16_t half;
+static spi_stream_fn stream_fn;
+
+// 'tx' before the last call of 'fn' for each half, and
+// when that call was done
+static uint8_t old_tx[MAX_FRAMES];
+static uint64_t ready[2];
+
+// when the processor is done with the calls of 'fn'
+static uint64_t cpu_free;
+
+void spi_stream_start(uint8_t *tx, uint8_t *rx, uint16_t n,
+                        spi_stream_fn fn) {
+    stream_tx = tx;
+    stream_rx = rx;
+    half = n / 2;
+    stream_fn = fn;
+
+    spi_stream_halves = 0;
+    spi_stream_time = 0;
+    spi_stream_frames = 0;
+    spi_stream_late = 0;
+
+    memcpy(old_tx, tx, 2 * half);
+    ready[0] = 0;
+    ready[1] = 0;
+    cpu_free = 0;
+
+    cpld_model_ss(spi_stream_model, 0);  // enable
+}
+
+void spi_stream_stop() {
+    cpld_model_ss(spi_stream_model, 1);  // disable
+}
+
+/*
+ * The interrupt of half 'h', 'fn' is called when the
+ * processor is free.
+ */
+static void interrupt(int h) {
+    uint64_t start = (spi_stream_time > cpu_free) ? spi_stream_time : cpu_free;
+
+    memcpy(old_tx + h * half, stream_tx + h * half, half);
+
+    stream_fn(stream_rx + h * half, stream_tx + h * half, half);
+    spi_stream_halves++;
+
+    cpu_free = start + spi_stream_cycles(half);
+    ready[h] = cpu_free;
+}
+
+void spi_stream_run(unsigned long frames) {
+    uint64_t frame_cycles = 8 * spi_stream_prescaler;
+    uint64_t taken;
+    unsigned int slot;
+    int h;
+    uint8_t tx;
+
+    while (frames--) {
+        slot = spi_stream_frames % (2 * half);
+        h = (slot >= half);
+
+        // taken as the frame before started
+        taken = spi_stream_time ? spi_stream_time - frame_cycles : 0;
+        if (taken < ready[h]) {
+            tx = old_tx[slot];
+            spi_stream_late++;
+        } else {
+            tx = stream_tx[slot];
+        }
+
+        stream_rx[slot] = cpld_model_frame(spi_stream_model, tx);
+
+        spi_stream_time += frame_cycles;
+        spi_stream_frames++;
+
+        if (slot == half - 1 || slot == 2 * half - 1)
+            interrupt(h);
+    }
+}
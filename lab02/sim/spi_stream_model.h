@@ -0,0 +1,70 @@
+#ifndef SPI_STREAM_MODEL_H
+#define SPI_STREAM_MODEL_H
+
+#include <stdint.h>
+
+#include "cpld_model.h"
+#include "spi_stream.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * spi_stream_model.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Host replacement for ../ARM/spi_stream.c.
+ *
+ * It implements the same interface (../ARM/spi_stream.h) but
+ * instead of programming the DMA the frames are exchanged with
+ * a CPLD model (cpld_model.h) by spi_stream_run(), on a virtual
+ * clock of SYSCLK cycles.
+ *
+ * The frames are back to back, SYSCLK / 'spi_stream_prescaler'
+ * bits per second.  Each frame is taken from 'tx' by the DMA as
+ * the one before it starts, when the transmit register is empty.
+ * When half of the frames have been received 'fn' is called, it
+ * takes 'spi_stream_cycles' of the processor, after the calls
+ * before it are done, and what it writes to 'tx' is not there
+ * until then.  A frame taken before is sent as it was and
+ * counted in 'spi_stream_late'.
+ *
+ * The model to use must be assigned to 'spi_stream_model' first.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  cpld_model m;
+ *
+ *  cpld_model_init(&m, 8);
+ *  spi_stream_model = &m;
+ *  spi_stream_prescaler = 2;
+ *  spi_stream_cycles = calc_cycles;
+ *
+ *  spi_stream_start(tx, rx, 64, calc);
+ *  spi_stream_run(1000);
+ *  // spi_stream_time cycles later
+ *  spi_stream_stop();
+ *
+ */
+
+extern cpld_model *spi_stream_model;
+
+// SCK = SYSCLK / spi_stream_prescaler
+extern unsigned int spi_stream_prescaler;
+
+// processor cycles of a call of 'fn' for 'n' frames
+extern unsigned long (*spi_stream_cycles)(uint16_t n);
+
+// time (SYSCLK cycles) and frames since spi_stream_start()
+extern uint64_t spi_stream_time;
+extern unsigned long spi_stream_frames;
+
+// frames sent before their result was written
+extern unsigned long spi_stream_late;
+
+void spi_stream_run(unsigned long frames);
+
+#endif
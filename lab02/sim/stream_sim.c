@@ -0,0 +1,241 @@
+/*
+ * NAME
+ * ----
+ *
+ * stream_sim.c - co-simulation of the streamed add/subtract
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./stream_sim
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The add/subtract of Lab 2 built with STREAM (../ARM/main.c)
+ * is run against a model of the CPLD (cpld_model.c).  The
+ * frames are exchanged back to back by a model of the DMA
+ * (spi_stream_model.c) on a virtual clock, and each half of them
+ * is calculated by saddsub_batch() (../ARM/saddsub.c) as
+ * stream() of main.c does.
+ *
+ * The switches are changed for every frame and the LEDs after
+ * each frame are checked, they must be the result of the frame
+ * received the number of frames in the stream before.
+ *
+ * The processor time of each half is that of the interrupt and
+ * of saddsub_batch() on the Cortex-M3 (IRQ_CYCLES, WORD_CYCLES)
+ * which are estimated from their instructions.  For each SPI
+ * prescaler and number of frames in the stream the samples
+ * (frames) per second are displayed, and the frames which were
+ * sent before their result was calculated (late).  The fastest
+ * without any for the STREAM_FRAMES of main.c is the rate that
+ * can be reached.
+ *
+ * The frames one at a time, as main.c does without STREAM, are
+ * also checked against the model, and back to back with SS_L
+ * held low, for each WIDTH of main.v (8, 16 and 32 bits).
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpld_model.h"
+#include "saddsub.h"
+#include "spi_stream_model.h"
+
+// as main.c, SYSCLK is the HSI
+#define SYSCLK 16000000
+#define STREAM_FRAMES 64
+#define PAUSE_MS 100
+
+// Cortex-M3 cycles, estimated, of the interrupt, its entry and
+// exit, the handler and stream(), and of each word (4 frames)
+// of saddsub_batch()
+#define IRQ_CYCLES 64
+#define WORD_CYCLES 20
+
+#define SIM_FRAMES 100000
+
+static unsigned long errors;
+static unsigned long checks;
+
+static void check(const char *name, unsigned long frame, uint32_t got,
+                    uint32_t expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: frame %lu expected %.2x, got %.2x\n",
+                    name, frame, expected, got);
+        errors++;
+    }
+}
+
+// {{{ frames
+static uint32_t random_bits(uint32_t mask) {
+    return (((uint32_t) rand() << 16) ^ rand()) & mask;
+}
+
+/*
+ * Frames of 'width' bits (8, 16 or 32, WIDTH of main.v).  One
+ * at a time SS_L is set before the last falling edge of SCK, as
+ * the SPI interrupt of main.c does (a 32 bit frame is two 16 bit
+ * words with SS_L low between them, the same edges).  Held low
+ * ('held') the frames are back to back and each is latched by
+ * the count of propagates.
+ */
+static void check_frames(unsigned int width, int held) {
+    cpld_model m;
+    uint32_t sw = 0;
+    uint32_t tx;
+    uint32_t rx;
+    unsigned long n;
+    int i;
+
+    cpld_model_init(&m, width);
+    // a latch, so the switches are loaded
+    cpld_model_rise(&m, 0);
+    cpld_model_fall(&m);
+
+    if (held)
+        cpld_model_ss(&m, 0);
+
+    for (n = 0; n < 1000; n++) {
+        tx = random_bits(m.mask);
+        sw = ~m.in_sw & m.mask;
+        m.in_sw = random_bits(m.mask);
+
+        cpld_model_ss(&m, 0);
+        rx = 0;
+        for (i = width - 1; i >= 0; i--) {
+            rx = (rx << 1) | cpld_model_rise(&m, (tx >> i) & 1);
+            if (0 == i && ! held)
+                cpld_model_ss(&m, 1);
+            cpld_model_fall(&m);
+        }
+
+        check("switches", n, rx, sw);
+        check("leds", n, ~m.led_ext & m.mask, tx);
+    }
+    check("latches", n, m.frames, n + 1);
+}
+// }}}
+
+// {{{ stream
+static uint8_t stream_tx[1024];
+static uint8_t stream_rx[1024];
+
+static uint32_t op;
+
+// as stream() of main.c
+static void stream(const uint8_t *rx, uint8_t *tx, uint16_t n) {
+    saddsub_batch(op, rx, tx, n);
+}
+
+static unsigned long stream_cycles(uint16_t n) {
+    return IRQ_CYCLES + (n + 3) / 4 * WORD_CYCLES;
+}
+
+/*
+ * Stream SIM_FRAMES and check the LEDs, returns the samples
+ * per second.
+ */
+static double run(unsigned int prescaler, uint16_t frames) {
+    static uint8_t sample[SIM_FRAMES];
+    cpld_model m;
+    unsigned long n;
+    uint32_t leds;
+
+    cpld_model_init(&m, 8);
+    spi_stream_model = &m;
+    spi_stream_prescaler = prescaler;
+    spi_stream_cycles = stream_cycles;
+
+    // a latch, so the switches are loaded
+    cpld_model_rise(&m, 0);
+    cpld_model_fall(&m);
+
+    memset(stream_tx, 0, frames);
+    spi_stream_start(stream_tx, stream_rx, frames, stream);
+
+    for (n = 0; n < SIM_FRAMES; n++) {
+        // sent by this frame, the last latch
+        sample[n] = ~m.in_sw;
+        m.in_sw = rand() & 0xff;
+
+        spi_stream_run(1);
+
+        // results are late, they are displayed not checked
+        if (spi_stream_late || n < frames)
+            continue;
+
+        leds = ~m.led_ext & 0xff;
+        check("stream", n, leds,
+                saddsub_ref(op, sample[n - frames] & 0x0f,
+                                sample[n - frames] >> 4));
+    }
+
+    spi_stream_stop();
+
+    return (double) spi_stream_frames * SYSCLK / spi_stream_time;
+}
+
+static void check_stream() {
+    static const uint16_t frames[] = {8, 16, STREAM_FRAMES, 256};
+    unsigned int prescaler;
+    unsigned int i;
+    double rate;
+    double best = 0;
+
+    printf("frames  prescaler  samples/s   late\n");
+    for (i = 0; i < sizeof(frames) / sizeof(frames[0]); i++) {
+        for (prescaler = 256; prescaler >= 2; prescaler /= 2) {
+            // both, in turn
+            op = ! op;
+            rate = run(prescaler, frames[i]);
+
+            printf("%6u  %9u  %9.0f  %5lu\n", frames[i], prescaler,
+                    rate, spi_stream_late);
+
+            if (frames[i] == STREAM_FRAMES && 0 == spi_stream_late &&
+                    rate > best)
+                best = rate;
+        }
+    }
+
+    printf("%.0f samples/s streamed (%d frames), %d samples/s "
+            "one every PAUSE_MS\n", best, STREAM_FRAMES, 1000 / PAUSE_MS);
+}
+// }}}
+
+int main() {
+    srand(344);
+
+    check_frames(8, 0);
+    check_frames(16, 0);
+    check_frames(32, 0);
+    check_frames(8, 1);
+    check_frames(16, 1);
+    check_frames(32, 1);
+    check_stream();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
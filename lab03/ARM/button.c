@@ -1,21 +1,32 @@
 #include "button.h"
 
+static void configure_button_timer();
+
+// task woken after each debounce, see button_set_task()
+static sched_task *button_task = 0;
+
 void enable_button()
 {
-	int i = 0;
+	EXTI_InitTypeDef EXTI_init;
+	NVIC_InitTypeDef NVIC_init;
 
 	// [Pg. 144]{STRM0038}
 	// The RI registers can only be accessed when the comparator
 	// interface clock is enabled.
 	RCC->APB1ENR |= RCC_APB1ENR_COMPEN;
 
+	configure_button_timer();
+
 	// [Pg. 274]{STRM0038}
 
 	// 1.) enable comparator 1
 	COMP->CSR |= COMP_CSR_CMP1EN;
 
 	// 2.) wait until comparator is ready
-	while (i++ < 5e5);	 // a cheap timer. TODO: build a better one
+	//     (one debounce period, far more than its startup time)
+	button_timer_start(BUTTON_DEBOUNCE_MS);
+	while (TIM_GetFlagStatus(TIM6, TIM_FLAG_Update) == RESET);
+	TIM_ClearFlag(TIM6, TIM_FLAG_Update);
 
 	// 3.) set the SCM bit in the RI_ASCR1 register	
 	RI->ASCR1 |= RI_ASCR1_SCM;
@@ -27,6 +38,92 @@ void enable_button()
 	RI->ASCR1 |= RI_ASCR1_CH_0;
 
 	// Then the value can be read in COMP_CSR COMP1_OUT
+
+	button_event_init(button_pressed() ? 1 : 0);
+
+	// The comparator 1 output is connected to EXTI line 21
+	EXTI_ClearITPendingBit(EXTI_Line21);
+	EXTI_init.EXTI_Line = EXTI_Line21;
+	EXTI_init.EXTI_Mode = EXTI_Mode_Interrupt;
+	EXTI_init.EXTI_Trigger = EXTI_Trigger_Rising_Falling;
+	EXTI_init.EXTI_LineCmd = ENABLE;
+	EXTI_Init(&EXTI_init);
+
+	NVIC_init.NVIC_IRQChannel = COMP_IRQn;
+	NVIC_init.NVIC_IRQChannelPreemptionPriority = 1;
+	NVIC_init.NVIC_IRQChannelSubPriority = 0;
+	NVIC_init.NVIC_IRQChannelCmd = ENABLE;
+	NVIC_Init(&NVIC_init);
+
+	TIM_ITConfig(TIM6, TIM_IT_Update, ENABLE);
+
+	NVIC_init.NVIC_IRQChannel = TIM6_IRQn;
+	NVIC_Init(&NVIC_init);
+}
+
+/*
+ * configure_button_timer()
+ *
+ * TIM6 counts milliseconds and stops itself when it reaches
+ * the reload value (one pulse mode).  It counts 0 to the reload
+ * value, so the reload is one less than the milliseconds.
+ */
+static void configure_button_timer()
+{
+	TIM_TimeBaseInitTypeDef TIM_init;
+	RCC_ClocksTypeDef clocks;
+	uint32_t tim_clk;
+
+	RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM6, ENABLE);
+
+	// the timer clock is twice PCLK1 if APB1 is divided
+	RCC_GetClocksFreq(&clocks);
+	tim_clk = clocks.PCLK1_Frequency;
+	if (clocks.PCLK1_Frequency != clocks.HCLK_Frequency)
+		tim_clk *= 2;
+
+	TIM_TimeBaseStructInit(&TIM_init);
+	TIM_init.TIM_Prescaler = tim_clk / 1000 - 1;  // 1 ms
+	TIM_init.TIM_Period = BUTTON_DEBOUNCE_MS - 1;
+	TIM_TimeBaseInit(TIM6, &TIM_init);
+
+	// only an overflow sets the update flag, not a restart
+	TIM_UpdateRequestConfig(TIM6, TIM_UpdateSource_Regular);
+	TIM_SelectOnePulseMode(TIM6, TIM_OPMode_Single);
+	TIM_ClearFlag(TIM6, TIM_FLAG_Update);
+}
+
+/*
+ * button_timer_start()
+ *
+ * (Re)start the debounce timer, see button_event.h.
+ */
+void button_timer_start(unsigned int ms)
+{
+	TIM_Cmd(TIM6, DISABLE);
+	TIM_SetAutoreload(TIM6, ms - 1);
+	TIM_SetCounter(TIM6, 0);
+	TIM_Cmd(TIM6, ENABLE);
+}
+
+// edge of the comparator output
+void COMP_IRQHandler()
+{
+	if (EXTI_GetITStatus(EXTI_Line21) != RESET) {
+		EXTI_ClearITPendingBit(EXTI_Line21);
+		button_event_edge();
+	}
+}
+
+// debounce timer expired
+void TIM6_IRQHandler()
+{
+	if (TIM_GetITStatus(TIM6, TIM_IT_Update) != RESET) {
+		TIM_ClearITPendingBit(TIM6, TIM_IT_Update);
+		button_event_timeout(button_pressed() ? 1 : 0);
+		if (button_task)
+			sched_wake(button_task);
+	}
 }
 
 inline
@@ -39,12 +136,45 @@ unsigned int button_released() {
 	return (! button_pressed());
 }
 
+/*
+ * button_wait_event()
+ *
+ * Sleep until there is a button event and return it.
+ *
+ * Interrupts are disabled while the queue is checked so an
+ * event can not arrive between the check and the WFI, a pending
+ * interrupt still wakes the core.
+ */
+int button_wait_event() {
+    int event;
+
+    do {
+        __disable_irq();
+        event = button_get_event();
+        if (BUTTON_NONE == event)
+            __WFI();
+        __enable_irq();
+    } while (BUTTON_NONE == event);
+
+    return event;
+}
+
+/*
+ * button_set_task()
+ *
+ * Wake 't' whenever the debounce timer expires, which is
+ * when an event may have been queued.  0 to stop.
+ */
+void button_set_task(sched_task *t) {
+    button_task = t;
+}
+
 inline
 void wait_button_press() {
 
-    while (button_released());
+    while (button_wait_event() != BUTTON_DOWN);
 
-    while (button_pressed());
+    while (button_wait_event() != BUTTON_UP);
 
     return;
 }
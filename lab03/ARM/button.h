@@ -1,5 +1,8 @@
 #include "stm32l1xx.h"
 
+#include "button_event.h"
+#include "sched.h"
+
 /* 
  * NAME
  * ----
@@ -13,6 +16,15 @@
  * These functions enable it and then allow it
  * to be tested to see if it pressed or not.
  *
+ * The button is read through comparator 1 whose output
+ * generates an interrupt on each edge (EXTI line 21).
+ * The edges are debounced with TIM6 and turned in to
+ * events (button_event.h) so nothing has to poll it.
+ * button_wait_event() and wait_button_press() sleep (WFI)
+ * until an event arrives.  Or, with the scheduler (sched.h),
+ * button_set_task() wakes a task whenever there may be a new
+ * event for it to get.
+ *
  * SYNOPSIS
  * --------
  *
@@ -30,6 +42,17 @@
  *  // and released.
  *  wait_button_press();
  *
+ *  // or handle the events
+ *  switch (button_wait_event()) {
+ *      case BUTTON_DOWN: ...
+ *      case BUTTON_UP: ...
+ *  }
+ *
+ *  // or wake a task
+ *  button_set_task(&ui_task);
+ *  ...
+ *  while ((event = button_get_event()) != BUTTON_NONE) ...
+ *
  */
 
 void enable_button();
@@ -38,4 +61,8 @@ unsigned int button_pressed();
 
 unsigned int button_released();
 
+int button_wait_event();
+
 void wait_button_press();
+
+void button_set_task(sched_task *);
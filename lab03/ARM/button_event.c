@@ -0,0 +1,107 @@
+/*
+ * NAME
+ * ----
+ *
+ * button_event.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * USER button debouncing and event queue,
+ * refer to button_event.h.
+ *
+ * The queue has a single producer (the timer interrupt)
+ * and a single consumer (the main loop).  Only the producer
+ * changes 'tail' and only the consumer changes 'head' so
+ * no locking is needed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "button_event.h"
+
+// last debounced level, 1 pressed
+static volatile int stable;
+
+static volatile uint8_t queue[BUTTON_QUEUE_LEN];
+static volatile unsigned int head = 0;
+static volatile unsigned int tail = 0;
+static volatile unsigned int dropped = 0;
+
+/*
+ * button_event_init()
+ *
+ * Empty the queue and set the initial level (1 pressed).
+ */
+void button_event_init(int level) {
+    stable = level ? 1 : 0;
+    head = 0;
+    tail = 0;
+    dropped = 0;
+}
+
+/*
+ * button_event_edge()
+ *
+ * The comparator output changed, wait for it to settle.
+ */
+void button_event_edge() {
+    button_timer_start(BUTTON_DEBOUNCE_MS);
+}
+
+/*
+ * button_event_timeout()
+ *
+ * The level has been quiet for the debounce time, queue an
+ * event if it changed.
+ */
+void button_event_timeout(int level) {
+    unsigned int next;
+
+    level = level ? 1 : 0;
+    if (level == stable)
+        return;
+
+    // full, 'stable' is left as it was so the events still alternate
+    next = (tail + 1) % BUTTON_QUEUE_LEN;
+    if (next == head) {
+        dropped++;
+        return;
+    }
+
+    stable = level;
+
+    queue[tail] = level ? BUTTON_DOWN : BUTTON_UP;
+    tail = next;
+}
+
+/*
+ * button_get_event()
+ *
+ * Remove the oldest event from the queue and return it,
+ * or BUTTON_NONE if it is empty.
+ */
+int button_get_event() {
+    int event;
+
+    if (head == tail)
+        return BUTTON_NONE;
+
+    event = queue[head];
+    head = (head + 1) % BUTTON_QUEUE_LEN;
+
+    return event;
+}
+
+/*
+ * button_event_dropped()
+ *
+ * Number of events lost because the queue was full.
+ */
+unsigned int button_event_dropped() {
+    return dropped;
+}
@@ -0,0 +1,78 @@
+#ifndef BUTTON_EVENT_H
+#define BUTTON_EVENT_H
+
+#include "stm32l1xx.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * button_event.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Debouncing of the USER button and a queue of the
+ * resulting events.
+ *
+ * This part does not touch any hardware so it can also be
+ * built on a host (../sim/button_test.c).  The hardware
+ * side (button.c) calls it from its interrupts:
+ *
+ *  - button_event_edge() on every edge of the comparator
+ *    output (COMP1 through EXTI)
+ *  - button_event_timeout() when the debounce timer,
+ *    started through button_timer_start(), expires
+ *
+ * Every edge restarts the debounce timer, so the level is only
+ * looked at once it has been quiet for BUTTON_DEBOUNCE_MS.
+ * If it then differs from the last stable level a BUTTON_DOWN or
+ * BUTTON_UP event is queued.  Glitches shorter than the debounce
+ * time which return to the same level produce no event.
+ *
+ * The queue holds BUTTON_QUEUE_LEN - 1 events, when it is full
+ * new events are dropped (and counted).  The stable level is
+ * then not changed, so the events taken out still alternate,
+ * a change which was dropped is queued at a later timeout.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  button_event_init(0);  // released
+ *
+ *  // from the interrupts
+ *  button_event_edge();
+ *  button_event_timeout(level);
+ *
+ *  // from the main loop
+ *  if (BUTTON_DOWN == button_get_event()) {
+ *      // do something
+ *  }
+ *
+ */
+
+// quiet time before the level is accepted
+#define BUTTON_DEBOUNCE_MS 20
+
+// events held in the queue
+#define BUTTON_QUEUE_LEN 8
+
+// events
+#define BUTTON_NONE 0
+#define BUTTON_DOWN 1
+#define BUTTON_UP   2
+
+void button_event_init(int);
+
+void button_event_edge();
+
+void button_event_timeout(int);
+
+int button_get_event();
+
+unsigned int button_event_dropped();
+
+// provided by the hardware (button.c), (re)start the debounce timer
+void button_timer_start(unsigned int);
+
+#endif
@@ -0,0 +1,251 @@
+/*
+ * NAME
+ * ----
+ *
+ * cpld_bus.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Bus operations over the SPI, refer to cpld_bus.h.
+ *
+ * cpld_batch() splits the operations in to "frames", each of
+ * which is one NSS assertion (one DMA transaction).
+ *
+ *  frame                   bytes
+ *  -----                   -----
+ *  n reads (any address)   read A0, read A1, ..., read An-1, 0x00
+ *  n writes (A, A+1, ...)  write A, D0, D1, ..., Dn-1
+ *
+ * The bytes of all the frames are placed in one buffer and
+ * each frame is submitted to the DMA engine.  Then once they
+ * are all done the values read are copied back to the operations.
+ *
+ * The block copies (cpld_mem_read(), cpld_mem_write()) are done
+ * one page at a time as a batch of 2 + 16 operations, the page
+ * register write (one burst) followed by the accesses of the
+ * window (one burst write or pipelined reads).
+ * This is about 1.25 SPI bytes per byte copied.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "cpld_bus.h"
+#include "spi_dma.h"
+
+// Worst case, alternating reads and writes, is two bytes per operation.
+static uint8_t tx[2 * CPLD_BATCH_MAX];
+static uint8_t rx[2 * CPLD_BATCH_MAX];
+static SPI_DMA_xfer frames[CPLD_BATCH_MAX];
+
+// offset in 'rx' of the value for each read operation
+static uint8_t rx_pos[CPLD_BATCH_MAX];
+
+static void batch(cpld_op *, unsigned int);
+static unsigned int mem_ops(uint8_t, uint32_t, unsigned int, uint8_t);
+
+uint8_t cpld_read(uint8_t addr) {
+    cpld_op op;
+
+    op.addr = addr;
+    op.rw = CPLD_READ;
+    op.data = 0x00;
+
+    batch(&op, 1);
+
+    return op.data;
+}
+
+void cpld_write(uint8_t addr, uint8_t data) {
+    cpld_op op;
+
+    op.addr = addr;
+    op.rw = CPLD_WRITE;
+    op.data = data;
+
+    batch(&op, 1);
+}
+
+/*
+ * cpld_op_bytes()
+ *
+ * The two bytes on the SPI of the single operation 'op', the
+ * same as those of a frame of one operation in batch().
+ */
+void cpld_op_bytes(const cpld_op *op, uint8_t *bytes) {
+    if (CPLD_READ == op->rw) {
+        bytes[0] = (op->addr & CPLD_ADDR_BITS) | CPLD_RW_BIT;
+        bytes[1] = 0x00;  // form feed, rw bit clear
+    } else {
+        bytes[0] = op->addr & CPLD_ADDR_BITS;
+        bytes[1] = op->data;
+    }
+}
+
+void cpld_batch(cpld_op *ops, unsigned int n) {
+    unsigned int m;
+
+    while (n > 0) {
+        m = (n > CPLD_BATCH_MAX) ? CPLD_BATCH_MAX : n;
+
+        batch(ops, m);
+
+        ops += m;
+        n   -= m;
+    }
+}
+
+// {{{ cpld_mem_read(), cpld_mem_write()
+// operations for one page, page register and window
+static cpld_op page_ops[2 + CPLD_PAGE_SIZE];
+
+/*
+ * cpld_mem_read()
+ *
+ * Read 'n' bytes starting at RAM address 'offset' of 'mem'
+ * (CPLD_MEM1 or CPLD_MEM2) in to 'buf'.
+ */
+void cpld_mem_read(uint8_t mem, uint32_t offset, uint8_t *buf,
+                    unsigned int n) {
+    unsigned int m;
+    unsigned int i;
+
+    while (n > 0) {
+        m = mem_ops(mem, offset, n, CPLD_READ);
+
+        batch(page_ops, 2 + m);
+
+        for (i = 0; i < m; i++)
+            *buf++ = page_ops[2 + i].data;
+
+        offset += m;
+        n      -= m;
+    }
+}
+
+/*
+ * cpld_mem_write()
+ *
+ * Write 'n' bytes from 'buf' starting at RAM address 'offset'
+ * of 'mem' (CPLD_MEM1 or CPLD_MEM2).
+ */
+void cpld_mem_write(uint8_t mem, uint32_t offset, const uint8_t *buf,
+                    unsigned int n) {
+    unsigned int m;
+    unsigned int i;
+
+    while (n > 0) {
+        m = mem_ops(mem, offset, n, CPLD_WRITE);
+
+        for (i = 0; i < m; i++)
+            page_ops[2 + i].data = *buf++;
+
+        batch(page_ops, 2 + m);
+
+        offset += m;
+        n      -= m;
+    }
+}
+
+/*
+ * mem_ops()
+ *
+ * Fill in page_ops for up to 'n' bytes at 'offset' which lie
+ * in the same page and return how many bytes were used.
+ */
+static unsigned int mem_ops(uint8_t mem, uint32_t offset, unsigned int n,
+                            uint8_t rw) {
+    uint32_t page = (offset / CPLD_PAGE_SIZE) % CPLD_PAGES;
+    unsigned int first = offset % CPLD_PAGE_SIZE;
+    unsigned int m;
+    unsigned int i;
+
+    m = CPLD_PAGE_SIZE - first;
+    if (m > n)
+        m = n;
+
+    page_ops[0].addr = CPLD_PAGE_LO;
+    page_ops[0].rw = CPLD_WRITE;
+    page_ops[0].data = page & 0xFF;
+
+    page_ops[1].addr = CPLD_PAGE_HI;
+    page_ops[1].rw = CPLD_WRITE;
+    page_ops[1].data = page >> 8;
+
+    for (i = 0; i < m; i++) {
+        page_ops[2 + i].addr = mem + first + i;
+        page_ops[2 + i].rw = rw;
+        page_ops[2 + i].data = 0x00;
+    }
+
+    return m;
+}
+// }}}
+
+// {{{ batch()
+/*
+ * batch()
+ *
+ * Perform up to CPLD_BATCH_MAX operations.
+ */
+static void batch(cpld_op *ops, unsigned int n) {
+    unsigned int i;
+    unsigned int len;       // bytes used in tx
+    unsigned int start;     // first byte of the current frame
+    unsigned int nframes;   // frames submitted
+    unsigned int waited;    // frames known to be done
+
+    len = 0;
+    nframes = 0;
+    waited = 0;
+
+    i = 0;
+    while (i < n) {
+        start = len;
+
+        if (CPLD_READ == ops[i].rw) {
+            // pipelined reads
+            while (i < n && CPLD_READ == ops[i].rw) {
+                tx[len++] = (ops[i].addr & CPLD_ADDR_BITS) | CPLD_RW_BIT;
+                // value arrives during the next byte
+                rx_pos[i] = len;
+                i++;
+            }
+            // form feed, rw bit clear
+            tx[len++] = 0x00;
+        } else {
+            // burst write
+            tx[len++] = ops[i].addr & CPLD_ADDR_BITS;
+            tx[len++] = ops[i].data;
+            i++;
+            while (i < n && CPLD_WRITE == ops[i].rw
+                    && ops[i].addr == ((ops[i - 1].addr + 1) & CPLD_ADDR_BITS)) {
+                tx[len++] = ops[i].data;
+                i++;
+            }
+        }
+
+        // if the queue is full wait for the oldest frame to finish
+        while (! SPI_DMA_submit(&frames[nframes], &tx[start], &rx[start],
+                                len - start, 0)) {
+            if (waited < nframes)
+                SPI_DMA_wait(&frames[waited++]);
+        }
+        nframes++;
+    }
+
+    while (waited < nframes)
+        SPI_DMA_wait(&frames[waited++]);
+
+    for (i = 0; i < n; i++) {
+        if (CPLD_READ == ops[i].rw)
+            ops[i].data = rx[rx_pos[i]];
+    }
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,116 @@
+#ifndef CPLD_BUS_H
+#define CPLD_BUS_H
+
+#include "stm32l1xx.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * cpld_bus.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Access to the bus defined by the CPLD (../CPLD/main.v).
+ *
+ * cpld_read() and cpld_write() perform a single bus operation.
+ * cpld_batch() performs many of them with as few bytes on the
+ * SPI as the protocol allows (refer to ../CPLD/spi_ctl.v):
+ *
+ *  - consecutive reads are pipelined in to one NSS assertion
+ *  - consecutive writes to consecutive addresses are sent
+ *    as one burst
+ *
+ * All of the resulting transactions are handed to the DMA
+ * engine (spi_dma.h) at once.
+ *
+ * cpld_op_bytes() gives the two bytes of a single operation for
+ * code which submits it to the DMA engine itself (main.c).
+ * A read is followed by a form feed (0x00), not by the stale
+ * data, whose rw bit would start another read.
+ *
+ * cpld_mem_read() and cpld_mem_write() copy blocks of any size
+ * to and from anywhere in the 128K of a RAM chip.  The page
+ * register is set for each 16 byte page and the window is then
+ * accessed with bursts.  The page register is left at the last
+ * page used.
+ *
+ * Writing 1 to CPLD_MEM_SWAP exchanges the chips behind the
+ * CPLD_MEM1 and CPLD_MEM2 windows (see ../CPLD/mem_arb.v).
+ * This gives a ping-pong buffer, one window is filled while the
+ * other is read, then they are swapped.
+ *
+ * The DMA engine must already be configured
+ * (see configure_SPI_DMA()).
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  uint8_t sw;
+ *  cpld_op ops[3];
+ *
+ *  sw = cpld_read(CPLD_SWITCHES);
+ *  cpld_write(CPLD_BAR_LEDS, sw);
+ *
+ *  ops[0].addr = CPLD_SWITCHES;   ops[0].rw = CPLD_READ;
+ *  ops[1].addr = CPLD_BAR_LEDS;   ops[1].rw = CPLD_WRITE;  ops[1].data = 0x0F;
+ *  ops[2].addr = CPLD_MEM1 + 3;   ops[2].rw = CPLD_READ;
+ *
+ *  cpld_batch(ops, 3);
+ *  // ops[0].data and ops[2].data now hold the values read
+ *
+ *  uint8_t buf[512];
+ *
+ *  cpld_mem_write(CPLD_MEM2, 0x1F000, buf, sizeof(buf));
+ *  cpld_mem_read(CPLD_MEM2, 0x1F000, buf, sizeof(buf));
+ *
+ *  cpld_write(CPLD_MEM_SWAP, 1);  // MEM2 is now the front buffer
+ *
+ */
+
+// bus address map, see ../CPLD/decoder.v
+#define CPLD_SWITCHES   0x74
+#define CPLD_BAR_LEDS   0x6C
+#define CPLD_MEM2       0x50  // 0x50 - 0x5F
+#define CPLD_MEM_SWAP   0x32  // exchange MEM1 and MEM2 (bit 0)
+#define CPLD_PAGE_HI    0x31  // page[12:8]
+#define CPLD_PAGE_LO    0x30  // page[7:0]
+#define CPLD_BOARD_LEDS 0x2F
+#define CPLD_MEM1       0x00  // 0x00 - 0x0F
+
+// bitmasks to select the address and rw bit
+#define CPLD_ADDR_BITS  0x7F
+#define CPLD_RW_BIT     0x80
+
+// values of cpld_op.rw
+#define CPLD_WRITE      0x00
+#define CPLD_READ       CPLD_RW_BIT
+
+// RAM pages, see ../CPLD/page_ctl.v
+#define CPLD_PAGE_SIZE  16
+#define CPLD_PAGES      8192
+#define CPLD_MEM_SIZE   (CPLD_PAGE_SIZE * CPLD_PAGES)
+
+// maximum operations handled per set of transactions by cpld_batch()
+#define CPLD_BATCH_MAX  32
+
+typedef struct {
+    uint8_t addr;   // 7-bit bus address
+    uint8_t rw;     // CPLD_READ or CPLD_WRITE
+    uint8_t data;   // value to write, or the value read
+} cpld_op;
+
+uint8_t cpld_read(uint8_t);
+
+void cpld_write(uint8_t, uint8_t);
+
+void cpld_batch(cpld_op *, unsigned int);
+
+void cpld_op_bytes(const cpld_op *, uint8_t *);
+
+void cpld_mem_read(uint8_t, uint32_t, uint8_t *, unsigned int);
+
+void cpld_mem_write(uint8_t, uint32_t, const uint8_t *, unsigned int);
+
+#endif
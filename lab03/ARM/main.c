@@ -18,6 +18,16 @@
  * 1 bit read/write bit.  Depending on if this byte
  * is a read or a write data will be sent or received.
  *
+ * The bus operations are sent using DMA (spi_dma.c) by a
+ * task of a cooperative scheduler (sched.c).  Handling the
+ * button and refreshing the LCD are separate tasks so none
+ * of them waits for another, and when there is nothing to do
+ * the processor sleeps.
+ *
+ * Built with PROF defined, the init functions and the driver
+ * calls of the tasks are profiled in cycles (prof.h), the
+ * counts are in the list prof_sites.
+ *
  * For more details refer to the documentation (doc/)
  * included with this project.
  * 
@@ -29,11 +39,27 @@
  */
 
 #include "stm32l1xx.h"
-#include "stdio.h"
+#include "string.h"
 #include "discover_board.h"
 #include "stm32l_discovery_lcd.h"
 
 #include "button.h"
+#include "cpld_bus.h"
+#include "fmt.h"
+#include "prof.h"
+#include "sched.h"
+#include "spi_dma.h"
+#include "timebase.h"
+
+// Define if the CPLD is built with CLOCKED_BUS (../CPLD/main.v)
+// so that the SPI can run much faster.
+//#define CPLD_CLOCKED_BUS
+
+// time between reads of the switches (milliseconds)
+#define SWITCHES_MS 100
+
+// milliseconds per step of a string scrolled on the LCD
+#define SCROLL_MS   300
 
 /* The configure_* functions are used to
  * encapsulate the configuration of a specific
@@ -44,161 +70,287 @@
 void configure_SPI();
 void configure_LCD();
 void configure_LEDs();
-uint8_t SPI_once(uint8_t);
-void NSS_enable();
-void NSS_disable();
 
-// bitmasks to select the address and rw bit
-#define ADDR_BITS 0x7F
-#define RW_BIT    0x80
+/*
+ * The work is split in to three tasks (sched.h) so that
+ * none of them waits on another.
+ *
+ *  ui   - the state machine, run by button events and
+ *         completed bus operations
+ *  bus  - runs one bus operation at a time through the DMA
+ *         and reads the switches every SWITCHES_MS
+ *  lcd  - refreshes the LCD when the string to display changes,
+ *         strings longer than the LCD are scrolled by its
+ *         interrupt (LCD_GLASS_ScrollString())
+ */
+static sched_task ui_task;
+static sched_task bus_task;
+static sched_task lcd_task;
 
-void main() {
+static void ui(sched_task *);
+static void bus(sched_task *);
+static void lcd(sched_task *);
 
-    // to display string on LCD
-    char str[10];
-    // send and recieve buffers for SPI
-    uint8_t SPI1_Tx;
-    uint8_t SPI1_Rx;
-    // 7-bit addr, 1 bit rw
-    uint8_t addr;
-    uint8_t rw;
-
-    uint8_t to_write;
-
-    enum state {START,
-                ENTER_CMD,
-                READ_CMD_1,
-                READ_CMD_2,
-                ENTER_DATA,
-                READ_DATA_1,
-                READ_DATA_2,
-                EXECUTE_1,
-                EXECUTE_2,
-                DISPLAY_RESULTS};
-    char state;
+// events sent to the ui task
+#define EV_BUS_DONE  1  // ui_op has been performed
+#define EV_SWITCHES  2  // 'switches' has a new value
 
-    // {{{ ### INITIALIZATION ###
+// {{{ ### BUS TASK ###
 
-    enable_button();
+// operation requested by the ui, performed when ui_op_pending
+static cpld_op ui_op;
+static uint8_t ui_op_pending = 0;
 
-    configure_LEDs();
+// last value read from the switches
+static uint8_t switches = 0x00;
 
-    configure_LCD();
+// the operation on the SPI
+static SPI_DMA_xfer xfer;
+static uint8_t xfer_tx[2];
+static uint8_t xfer_rx[2];
+static cpld_op *xfer_op = 0;
+static cpld_op poll_op;
 
-    configure_SPI();
+static void xfer_done(SPI_DMA_xfer *x) {
+    sched_wake(&bus_task);
+}
 
-    // }}}
+/*
+ * bus()
+ *
+ * A single operation is two bytes on the SPI, the address
+ * and rw bit followed by the data, or a form feed for a read
+ * (see ../CPLD/spi_ctl.v and cpld_op_bytes()).
+ * It is submitted to the DMA and the task returns, the DMA
+ * interrupt wakes it again once the operation is done.
+ */
+static void bus(sched_task *t) {
+    if (xfer_op) {
+        if (! xfer.done)
+            return;  // woken by the timer, still busy
+
+        if (CPLD_READ == xfer_op->rw)
+            xfer_op->data = xfer_rx[1];
+
+        if (&ui_op == xfer_op) {
+            ui_op_pending = 0;
+            sched_send(&ui_task, EV_BUS_DONE);
+        } else if (poll_op.data != switches) {
+            switches = poll_op.data;
+            sched_send(&ui_task, EV_SWITCHES);
+        }
+        xfer_op = 0;
+    }
 
-    // {{{ ### MAIN LOOP ###
+    // the ui first, the switches when it is time
+    if (ui_op_pending) {
+        xfer_op = &ui_op;
+    } else if (! bus_task.timer.active) {
+        poll_op.addr = CPLD_SWITCHES;
+        poll_op.rw = CPLD_READ;
+        xfer_op = &poll_op;
+        sched_wake_after(t, SWITCHES_MS);
+    } else {
+        return;  // idle
+    }
 
-    SPI1_Tx = 0x00;  // initial data to send
-    SPI1_Rx = 0x00;  // received data is stored here
-    state = START;
+    cpld_op_bytes(xfer_op, xfer_tx);
+    PROF_CALL(SPI_DMA_submit(&xfer, xfer_tx, xfer_rx, 2, xfer_done));
+}
 
-    // This state machine is easier to understand along
-    // with the "State diagram of ARM operation" diagram
-    // included in this projects documentation (doc/).
+/*
+ * bus_request()
+ *
+ * Ask the bus task to perform an operation for the ui,
+ * EV_BUS_DONE is sent to the ui when it is done.
+ */
+static void bus_request(uint8_t addr, uint8_t rw, uint8_t data) {
+    ui_op.addr = addr;
+    ui_op.rw = rw;
+    ui_op.data = data;
+    ui_op_pending = 1;
+    sched_wake(&bus_task);
+}
+// }}}
 
-    while (1) {
-        if (ENTER_CMD == state) {
-            // prepare the string
-            sprintf(str, "CMD");
+// {{{ ### LCD TASK ###
 
-            LCD_GLASS_Clear();
-            LCD_GLASS_DisplayString((unsigned char *) str);
+// string to display, changed by show()
+static char lcd_str[24];
 
-            wait_button_press();
+/*
+ * show()
+ *
+ * Display 'str' on the LCD (soon), only if it changed.
+ */
+static void show(const char *str) {
+    if (strcmp(str, lcd_str)) {
+        strncpy(lcd_str, str, sizeof(lcd_str) - 1);
+        sched_wake(&lcd_task);
+    }
+}
 
-            // next state
-            state = READ_CMD_1;
-        } else if (READ_CMD_1 == state) {
-            NSS_enable();
+static void lcd(sched_task *t) {
+    if (strlen(lcd_str) > 6) {
+        PROF_CALL(LCD_GLASS_ScrollString((unsigned char *) lcd_str, 0,
+                    SCROLL_MS));
+    } else {
+        PROF_CALL(LCD_GLASS_ScrollStop());
+        PROF_CALL(LCD_GLASS_ShowString((unsigned char *) lcd_str));
+    }
+}
+// }}}
 
-            SPI1_Tx = 0x74 | 0x80;  // read switches
+// {{{ ### UI TASK ###
 
-            // perform one SPI transaction (8-bits)
-            // ignore the return value
-            SPI_once(SPI1_Tx);
+enum state {START,
+            ENTER_CMD,
+            READ_CMD,
+            ENTER_DATA,
+            READ_DATA,
+            EXECUTE,
+            DISPLAY_RESULTS};
 
-            state = READ_CMD_2;
-        } else if (READ_CMD_2 == state) {
-            SPI1_Tx = 0x00;  // form feed, can be any value
+/*
+ * ui()
+ *
+ * This state machine is easier to understand along
+ * with the "State diagram of ARM operation" diagram
+ * included in this projects documentation (doc/).
+ *
+ * A button press (its release) moves on from the ENTER_*
+ * and DISPLAY_RESULTS states.  The READ_* and EXECUTE states
+ * wait for their bus operation to be done.  While a value is
+ * being entered the switches are shown live.
+ */
+static void ui(sched_task *t) {
+    static char state = START;
+    // command (from the switches) and value read
+    static uint8_t read_val = 0x00;
+    // 7-bit addr, 1 bit rw
+    static uint8_t addr;
+    static uint8_t rw;
+    static uint8_t to_write;
+    // to display string on LCD
+    char str[24];
+    char *p = str;
+    int pressed = 0;
+    int bus_done = 0;
+    int event;
+
+    while ((event = button_get_event()) != BUTTON_NONE) {
+        if (BUTTON_UP == event)
+            pressed = 1;
+    }
 
-            SPI1_Rx = SPI_once(SPI1_Tx);
+    while ((event = sched_get(t)) != SCHED_NONE) {
+        if (EV_BUS_DONE == event)
+            bus_done = 1;
+    }
 
-            addr = SPI1_Rx & ADDR_BITS;
-            rw   = SPI1_Rx & RW_BIT;
+    if (ENTER_CMD == state) {
+        if (pressed) {
+            bus_request(CPLD_SWITCHES, CPLD_READ, 0x00);
+            state = READ_CMD;
+        }
+    } else if (READ_CMD == state) {
+        if (bus_done) {
+            addr = ui_op.data & CPLD_ADDR_BITS;
+            rw   = ui_op.data & CPLD_RW_BIT;
             // NOTE, the rw bit is left in its highest bit
 
-            NSS_disable();
-
-            if (rw)
-                state = EXECUTE_1;
-            else
+            if (rw) {
+                bus_request(addr, CPLD_READ, 0x00);
+                state = EXECUTE;
+            } else {
                 state = ENTER_DATA;
-        } else if (ENTER_DATA == state) {
-            sprintf(str, "DATA");
-
-            LCD_GLASS_Clear();
-            LCD_GLASS_DisplayString((unsigned char *) str);
+            }
+        }
+    } else if (ENTER_DATA == state) {
+        if (pressed) {
+            bus_request(CPLD_SWITCHES, CPLD_READ, 0x00);
+            state = READ_DATA;
+        }
+    } else if (READ_DATA == state) {
+        if (bus_done) {
+            to_write = ui_op.data;
+            bus_request(addr, CPLD_WRITE, to_write);
+            state = EXECUTE;
+        }
+    } else if (EXECUTE == state) {
+        if (bus_done) {
+            if (rw)
+                read_val = ui_op.data;
+            state = DISPLAY_RESULTS;
+        }
+    } else if (DISPLAY_RESULTS == state) {
+        if (pressed)
+            state = ENTER_CMD;
+    } else {
+        state = ENTER_CMD;
+    }
 
-            wait_button_press();
+    // The LCD can only display 6 characters, longer strings scroll
+    if (ENTER_CMD == state) {
+        p = fmt_str(p, "CMD ");
+        p = fmt_hex(p, switches, 2);
+    } else if (ENTER_DATA == state) {
+        p = fmt_str(p, "DAT ");
+        p = fmt_hex(p, switches, 2);
+    } else if (DISPLAY_RESULTS == state) {
+        p = fmt_str(p, "ADDR ");
+        p = fmt_hex(p, addr, 2);
+        if (rw) {
+            p = fmt_str(p, " READ ");
+            p = fmt_hex(p, read_val, 2);
+        } else {
+            p = fmt_str(p, " WRITE ");
+            p = fmt_hex(p, to_write, 2);
+        }
+        p = fmt_str(p, "   ");
+    }
 
-            state = READ_DATA_1;
-        } else if (READ_DATA_1 == state) {
-            NSS_enable();
+    if (p != str) {
+        *p = 0;
+        show(str);
+    }
+}
+// }}}
 
-            SPI1_Tx = 0x74 | 0x80;  // read switches
+void main() {
 
-            // perform one SPI transaction (8-bits)
-            // ignore the return value
-            SPI_once(SPI1_Tx);
+    // {{{ ### INITIALIZATION ###
 
-            state = READ_DATA_2;
-        } else if (READ_DATA_2 == state) {
+    prof_init();
 
-            to_write = SPI_once(SPI1_Tx);
+    // configure_LCD() switches SYSCLK to the HSI, the timers
+    // below are set from it so they must come after.
+    PROF_CALL(configure_LCD());
 
-            NSS_disable();
+    PROF_CALL(configure_timebase());
 
-            state = EXECUTE_1;
-        } else if (EXECUTE_1 == state) {
-            NSS_enable();
+    PROF_CALL(enable_button());
 
-            SPI1_Tx = addr | rw;
+    PROF_CALL(configure_LEDs());
 
-            SPI_once(SPI1_Tx);
+    PROF_CALL(configure_SPI());
 
-            state = EXECUTE_2;
-        } else if (EXECUTE_2 == state) {
-            if (rw)
-                SPI1_Tx = 0x00;  // form feed, can be any value
-            else
-                SPI1_Tx = to_write;
+    PROF_CALL(configure_SPI_DMA());
 
-            SPI1_Rx = SPI_once(SPI1_Tx);
+    // }}}
 
-            NSS_disable();
+    // {{{ ### MAIN LOOP ###
 
-            state = DISPLAY_RESULTS;
-        } else if (DISPLAY_RESULTS == state) {
+    sched_add(&ui_task, ui);
+    sched_add(&bus_task, bus);
+    sched_add(&lcd_task, lcd);
 
-            // *The LCD can only display 6 characters
-            if (rw) 
-                sprintf(str, "%.2x%c %.2x", addr, 'R', SPI1_Rx);
-            else
-                sprintf(str, "%.2x%c %.2x", addr, 'W', to_write);
+    button_set_task(&ui_task);
 
-            LCD_GLASS_Clear();
-            LCD_GLASS_DisplayString((unsigned char *) str);
+    sched_wake(&ui_task);
+    sched_wake(&bus_task);
 
-            wait_button_press();
-            
-            state = ENTER_CMD; // next state
-        } else {
-            state = ENTER_CMD;
-        }
-    }
+    sched_run();
     // }}}
 }
 
@@ -239,7 +391,7 @@ void main() {
  *  * Pin PB5 for slave select (NSS) is not a result of
  *    the SPI configuration.  But here it is configured as an
  *    output so it can be "bit banged" by the code controlling
- *    the SPI transactions.
+ *    the SPI transactions (spi_dma.c).
  *
  * The following SPI configuration options were set.
  * These should be set identically on the slave which is being
@@ -274,10 +426,8 @@ void configure_SPI() {
 
     // Peripherals alternate function:
     // connect pins to peripherals
-    GPIO_PinAFConfig(GPIOA, GPIO_PinSource5, GPIO_AF_SPI1);  // SCK, PA5
-    GPIO_PinAFConfig(GPIOA, GPIO_PinSource12, GPIO_AF_SPI1); // MOSI, PA12
-    GPIO_PinAFConfig(GPIOA, GPIO_PinSource11, GPIO_AF_SPI1); // MISO, PA11
-//    GPIO_PinAFConfig(GPIOA, GPIO_PinSource5 | GPIO_PinSource12 | GPIO_PinSource11, GPIO_AF_SPI1); // MISO, PA11
+    // SCK PA5, MOSI PA12, MISO PA11, one write of AFR[0] and AFR[1]
+    GPIO_PinAFConfigMask(GPIOA, GPIO_Pin_5 | GPIO_Pin_12 | GPIO_Pin_11, GPIO_AF_SPI1);
     // configure pin alternate function
     GPIO_init.GPIO_Pin = GPIO_Pin_5 | GPIO_Pin_12 | GPIO_Pin_11;
     GPIO_init.GPIO_Mode = GPIO_Mode_AF;
@@ -295,7 +445,14 @@ void configure_SPI() {
     SPI_init.SPI_CPOL = SPI_CPOL_Low;    // CPOL = 0
     SPI_init.SPI_CPHA = SPI_CPHA_1Edge;    // CPHA = 0
     SPI_init.SPI_NSS = SPI_NSS_Soft;  // NSS => SPI_CR1
+#ifdef CPLD_CLOCKED_BUS
+    // The clocked bus (../CPLD/spi_ctl_sync.v) allows SCK up to
+    // OSC / 8, at least 2.25 MHz for the slowest OSCC (18 MHz).
+    // HSI (16 MHz) / 8 = 2 MHz
+    SPI_init.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_8;
+#else
     SPI_init.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_256;  // slow
+#endif
     SPI_init.SPI_FirstBit = SPI_FirstBit_MSB;
     //SPI_init.SPI_CRCPolynomial = ?
     SPI_Init(SPI1, &SPI_init);
@@ -331,10 +488,12 @@ void configure_SPI() {
  *      
  *      // refresh display
  *      //
- *      // If this doesn't display right make sure you aren't
- *      // repeating too quickly.
- *      LCD_Glass_clear();
- *      LCD_GLASS_DisplayString((unsigned char*) str);
+ *      // Only the characters which changed are written
+ *      // so it can be repeated as often as needed.
+ *      LCD_GLASS_ShowString((unsigned char*) str);
+ *
+ *      // or scroll a longer one, without waiting
+ *      LCD_GLASS_ScrollString((unsigned char*) str, 0, 300);
  *   }
  *
  */
@@ -410,58 +569,4 @@ void configure_LEDs() {
 }
 // }}}
 
-void NSS_disable() {
-    GPIO_SetBits(GPIOB, GPIO_Pin_5);  // NSS = 1, disable
-}
-
-void NSS_enable() {
-    GPIO_ResetBits(GPIOB, GPIO_Pin_5);  // NSS = 0, enable
-}
-
-// {{{ SPI_once()
-/*
- * SPI_once();
- *
- * SPI_once() is used to perform one SPI send/receive
- * operation.  The value to be sent is given as an
- * argument and the value received is the return value.
- *
- * It does not control the NSS pin, this is left to
- * the controlling block.
- *
- */
-
-uint8_t SPI_once(const uint8_t SPI1_Tx) {
-    uint8_t SPI1_Rx;
-    unsigned int i;
-
-    while (1) {
-        if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY)) {
-            // kill some time
-            asm("nop");
-        } else if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE)) {
-            // a transaction was completed
-
-            // read the received data from the last transaction
-            //SPI_I2S_ClearFlag(SPI1, SPI_I2S_FLAG_RXNE);
-
-            SPI1_Rx = SPI_I2S_ReceiveData(SPI1);
-
-            break;
-        } else if (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE)) {
-            // we can transmit more data
-
-            // transmit a byte
-            SPI_I2S_SendData(SPI1, SPI1_Tx);
-            while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE));
-        }
-    }
-
-    for (i = 0; i < 1e5; i++)
-        asm("nop");
-
-    return SPI1_Rx;
-}
-// }}}
-
 // vim:foldmethod=marker
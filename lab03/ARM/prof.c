@@ -0,0 +1,115 @@
+/*
+ * NAME
+ * ----
+ *
+ * prof.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Profiling of calls, refer to prof.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "prof.h"
+
+#ifdef PROF
+
+#ifdef PROF_CLOCK
+uint32_t PROF_CLOCK(void);
+#define prof_clock() PROF_CLOCK()
+#else
+#include "stm32l1xx.h"
+
+// the DWT is not in this version of core_cm3.h
+#define DWT_CTRL        (*(volatile uint32_t *) 0xE0001000)
+#define DWT_CYCCNT      (*(volatile uint32_t *) 0xE0001004)
+#define DWT_CTRL_CYCCNTENA  0x00000001
+
+#define prof_clock() DWT_CYCCNT
+#endif
+
+prof_site *prof_sites = 0;
+
+// the sites open now, and when each was begun
+static prof_site *open[PROF_DEPTH];
+static uint32_t start[PROF_DEPTH];
+static int depth = 0;
+
+void prof_init(void) {
+#ifndef PROF_CLOCK
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT_CYCCNT = 0;
+    DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+#endif
+    depth = 0;
+}
+
+/*
+ * prof_reset()
+ *
+ * Clear the counts of all the sites and forget them.
+ */
+void prof_reset(void) {
+    prof_site *s = prof_sites;
+    prof_site *next;
+
+    while (s) {
+        next = s->next;
+        s->calls = 0;
+        s->time = 0;
+        s->reads = 0;
+        s->writes = 0;
+        s->next = 0;
+        s = next;
+    }
+    prof_sites = 0;
+    depth = 0;
+}
+
+void prof_begin(prof_site *site) {
+    // first call, add it to the list
+    if (0 == site->calls && site != prof_sites && 0 == site->next) {
+        site->next = prof_sites;
+        prof_sites = site;
+    }
+    site->calls++;
+
+    if (depth < PROF_DEPTH) {
+        open[depth] = site;
+        start[depth] = prof_clock();
+    }
+    depth++;
+}
+
+void prof_end(prof_site *site) {
+    depth--;
+    if (depth < PROF_DEPTH)
+        // the clock may wrap once within a call, not in the total
+        site->time += (uint32_t) (prof_clock() - start[depth]);
+}
+
+/*
+ * prof_access()
+ *
+ * A register was read (0) or written (1), it is counted
+ * for each open site.
+ */
+void prof_access(int write) {
+    int i;
+    int n = depth < PROF_DEPTH ? depth : PROF_DEPTH;
+
+    for (i = 0; i < n; i++) {
+        if (write)
+            open[i]->writes++;
+        else
+            open[i]->reads++;
+    }
+}
+
+#endif
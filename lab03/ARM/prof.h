@@ -0,0 +1,98 @@
+#ifndef PROF_H
+#define PROF_H
+
+#include <stdint.h>
+
+/*
+ * NAME
+ * ----
+ *
+ * prof.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Profiling of the calls to the drivers, the init functions
+ * and the hot paths of the tasks.
+ *
+ * A call wrapped in PROF_CALL() is a profiled site.  Each site
+ * counts its calls and the time spent in them, and on a host
+ * (../sim/drv_prof.c) also the peripheral register reads and
+ * writes they made.  Sites may be nested, the counts of a site
+ * include those of the sites within it.
+ *
+ * Profiling is only built in when PROF is defined, otherwise
+ * PROF_CALL(call) is just 'call' and nothing is added.
+ *
+ * On the board the time is in cycles of the DWT cycle counter
+ * (CYCCNT), enabled by prof_init(), up to 2^32 cycles per
+ * call (4 minutes at 16 MHz).  The total of each site is
+ * 64 bits so it does not wrap over many calls.  The sites are
+ * a list, from prof_sites, to be looked at in the debugger.
+ * On a host PROF_CLOCK names the function which gives the time
+ * (nanoseconds, up to 4 seconds per call) and the register
+ * accesses are given to prof_access() by the register model
+ * (../sim/regmodel.h).
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  // built with PROF defined
+ *
+ *  prof_init();
+ *
+ *  PROF_CALL(configure_LCD());
+ *  PROF_CALL(GPIO_SetBits(GPIOB, GPIO_Pin_6));
+ *
+ *  prof_site *s;
+ *  for (s = prof_sites; s; s = s->next)
+ *      // s->name "configure_LCD()", s->file, s->line,
+ *      // s->calls, s->time, s->reads, s->writes
+ *
+ */
+
+// sites open at once, deeper ones are not counted
+#define PROF_DEPTH  8
+
+typedef struct prof_site {
+    const char *name;       // the call, as written
+    const char *file;
+    int line;
+    unsigned long calls;
+    uint64_t time;          // total, cycles or nanoseconds
+    unsigned long reads;    // register accesses, host only
+    unsigned long writes;
+    struct prof_site *next;
+} prof_site;
+
+#ifdef PROF
+
+#define PROF_CALL(call) do { \
+        static prof_site prof_site_ = {#call, __FILE__, __LINE__}; \
+        prof_begin(&prof_site_); \
+        call; \
+        prof_end(&prof_site_); \
+    } while (0)
+
+// all the sites which have been called, the last first
+extern prof_site *prof_sites;
+
+void prof_init(void);
+
+void prof_reset(void);
+
+void prof_begin(prof_site *site);
+
+void prof_end(prof_site *site);
+
+void prof_access(int write);
+
+#else
+
+#define PROF_CALL(call) call
+
+#define prof_init()
+
+#endif
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * NAME
+ * ----
+ *
+ * sched.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Cooperative scheduler, refer to sched.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stddef.h>
+
+#include "sched.h"
+
+// all the tasks, in the order they were added
+static sched_task *tasks = 0;
+static sched_task **tasks_end = &tasks;
+
+static volatile uint8_t stop;
+
+static unsigned int pending();
+static void timer_wake(tick_timer *);
+
+/*
+ * sched_init()
+ *
+ * Remove all the tasks.
+ * (Only needed to start over, as the host tests do.)
+ */
+void sched_init() {
+    tasks = 0;
+    tasks_end = &tasks;
+    stop = 0;
+}
+
+/*
+ * sched_add()
+ *
+ * Add a task which runs 'run' when woken.
+ * It starts asleep.
+ */
+void sched_add(sched_task *t, void (*run)(sched_task *)) {
+    t->run = run;
+    t->next = 0;
+    t->ready = 0;
+    t->head = 0;
+    t->tail = 0;
+    t->timer.active = 0;
+
+    *tasks_end = t;
+    tasks_end = &t->next;
+}
+
+/*
+ * sched_wake()
+ *
+ * Run the task (once) the next time the scheduler gets to it.
+ */
+void sched_wake(sched_task *t) {
+    t->ready = 1;
+}
+
+/*
+ * sched_wake_after()
+ *
+ * Wake the task in 'ms' milliseconds, replacing any earlier
+ * sched_wake_after() that has not happened yet.
+ */
+void sched_wake_after(sched_task *t, uint32_t ms) {
+    timer_start(&t->timer, ms, timer_wake);
+}
+
+/*
+ * sched_cancel()
+ *
+ * Stop a sched_wake_after() that has not happened yet.
+ */
+void sched_cancel(sched_task *t) {
+    timer_stop(&t->timer);
+}
+
+static void timer_wake(tick_timer *timer) {
+    sched_task *t;
+
+    t = (sched_task *) ((char *) timer - offsetof(sched_task, timer));
+    t->ready = 1;
+}
+
+// {{{ events
+/*
+ * sched_send()
+ *
+ * Add an event to the task's queue and wake it.
+ * Returns 0 if the queue was full and the event was dropped
+ * (the task is woken anyway).
+ */
+int sched_send(sched_task *t, uint8_t event) {
+    uint32_t primask = __get_PRIMASK();
+    uint8_t next;
+    int sent = 0;
+
+    __disable_irq();
+    next = (t->tail + 1) % SCHED_QUEUE_LEN;
+    if (next != t->head) {
+        t->events[t->tail] = event;
+        t->tail = next;
+        sent = 1;
+    }
+    t->ready = 1;
+    __set_PRIMASK(primask);
+
+    return sent;
+}
+
+/*
+ * sched_get()
+ *
+ * Remove the oldest event from the task's queue,
+ * SCHED_NONE if it is empty.
+ * Only the task itself should get its events.
+ */
+int sched_get(sched_task *t) {
+    int event;
+
+    if (t->head == t->tail)
+        return SCHED_NONE;
+
+    event = t->events[t->head];
+    t->head = (t->head + 1) % SCHED_QUEUE_LEN;
+
+    return event;
+}
+// }}}
+
+// {{{ running
+/*
+ * sched_run_once()
+ *
+ * Run each task that is woken once, returns how many ran.
+ *
+ * The ready flag is cleared before the task runs so anything
+ * that wakes it while it runs will run it again.
+ */
+unsigned int sched_run_once() {
+    sched_task *t;
+    unsigned int n = 0;
+
+    for (t = tasks; t; t = t->next) {
+        if (t->ready) {
+            t->ready = 0;
+            t->run(t);
+            n++;
+        }
+    }
+
+    return n;
+}
+
+/*
+ * sched_run()
+ *
+ * Run the tasks until sched_stop() is called.
+ *
+ * Interrupts are disabled while checking for woken tasks so
+ * a wake can not happen between the check and the sleep, a
+ * pending interrupt still ends the sleep.
+ */
+void sched_run() {
+    stop = 0;
+
+    while (! stop) {
+        if (sched_run_once())
+            continue;
+
+        __disable_irq();
+        if (! pending() && ! stop)
+            tick_wait();
+        __enable_irq();
+    }
+}
+
+/*
+ * sched_stop()
+ *
+ * Return from sched_run() after the current task.
+ */
+void sched_stop() {
+    stop = 1;
+}
+
+static unsigned int pending() {
+    sched_task *t;
+
+    for (t = tasks; t; t = t->next) {
+        if (t->ready)
+            return 1;
+    }
+
+    return 0;
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,237 @@
+/*
+ * NAME
+ * ----
+ *
+ * spi_dma.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * SPI1 transfer engine driven by DMA, refer to spi_dma.h
+ * for a description of how it is used.
+ *
+ * The SPI1 DMA requests are fixed to the following channels
+ * [Pg. 213]{RM0038}
+ *
+ *  request   channel
+ *  -------   -------
+ *  SPI1_RX   DMA1 Channel 2
+ *  SPI1_TX   DMA1 Channel 3
+ *
+ * Only the receive channel generates an interrupt.
+ * The last byte has been completely shifted in when
+ * it completes so it marks the end of the transaction.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "spi_dma.h"
+
+// queue of transactions, [head] is the one in progress
+static SPI_DMA_xfer *queue[SPI_DMA_QUEUE_LEN];
+static volatile unsigned int head = 0;
+static volatile unsigned int tail = 0;
+
+// destination of received bytes when they are not wanted
+static uint8_t rx_discard;
+
+static void start(SPI_DMA_xfer *);
+
+// {{{ configure_SPI_DMA()
+/*
+ * configure_SPI_DMA()
+ *
+ * Enable the DMA clock, the SPI1 DMA requests and
+ * the receive complete interrupt.
+ */
+void configure_SPI_DMA() {
+    NVIC_InitTypeDef NVIC_init;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_DMA1, ENABLE);
+
+    DMA_DeInit(DMA1_Channel2);
+    DMA_DeInit(DMA1_Channel3);
+
+    DMA_ITConfig(DMA1_Channel2, DMA_IT_TC, ENABLE);
+
+    NVIC_init.NVIC_IRQChannel = DMA1_Channel2_IRQn;
+    NVIC_init.NVIC_IRQChannelPreemptionPriority = 0;
+    NVIC_init.NVIC_IRQChannelSubPriority = 0;
+    NVIC_init.NVIC_IRQChannelCmd = ENABLE;
+    NVIC_Init(&NVIC_init);
+
+    SPI_I2S_DMACmd(SPI1, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+
+    GPIO_SetBits(GPIOB, GPIO_Pin_5);  // NSS = 1, disable
+}
+// }}}
+
+// {{{ start()
+/*
+ * start()
+ *
+ * Program both channels for a transaction and start it.
+ *
+ * The receive channel is enabled first so that no
+ * byte can be received before it is ready.
+ * The transfer begins as soon as the transmit channel is
+ * enabled since TXE is already set.
+ */
+static void start(SPI_DMA_xfer *xfer) {
+    DMA_InitTypeDef DMA_init;
+
+    // drain anything left over in the receive register
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE))
+        SPI_I2S_ReceiveData(SPI1);
+
+    DMA_StructInit(&DMA_init);
+    DMA_init.DMA_PeripheralBaseAddr = (uint32_t) &(SPI1->DR);
+    DMA_init.DMA_BufferSize = xfer->n;
+    DMA_init.DMA_PeripheralInc = DMA_PeripheralInc_Disable;
+    DMA_init.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+    DMA_init.DMA_MemoryDataSize = DMA_MemoryDataSize_Byte;
+    DMA_init.DMA_Mode = DMA_Mode_Normal;
+    DMA_init.DMA_M2M = DMA_M2M_Disable;
+
+    // RX, SPI1->DR -> xfer->rx
+    DMA_init.DMA_DIR = DMA_DIR_PeripheralSRC;
+    DMA_init.DMA_Priority = DMA_Priority_VeryHigh;
+    if (xfer->rx) {
+        DMA_init.DMA_MemoryBaseAddr = (uint32_t) xfer->rx;
+        DMA_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    } else {
+        DMA_init.DMA_MemoryBaseAddr = (uint32_t) &rx_discard;
+        DMA_init.DMA_MemoryInc = DMA_MemoryInc_Disable;
+    }
+    DMA_Init(DMA1_Channel2, &DMA_init);
+
+    // TX, xfer->tx -> SPI1->DR
+    DMA_init.DMA_DIR = DMA_DIR_PeripheralDST;
+    DMA_init.DMA_Priority = DMA_Priority_High;
+    DMA_init.DMA_MemoryBaseAddr = (uint32_t) xfer->tx;
+    DMA_init.DMA_MemoryInc = DMA_MemoryInc_Enable;
+    DMA_Init(DMA1_Channel3, &DMA_init);
+
+    GPIO_ResetBits(GPIOB, GPIO_Pin_5);  // NSS = 0, enable
+
+    DMA_Cmd(DMA1_Channel2, ENABLE);
+    DMA_Cmd(DMA1_Channel3, ENABLE);
+}
+// }}}
+
+// {{{ SPI_DMA_submit()
+/*
+ * SPI_DMA_submit()
+ *
+ * Queue a transaction of 'n' bytes.  The bytes in 'tx' are
+ * sent and the bytes received are stored in 'rx'.
+ * Both buffers must remain valid until the transaction is done.
+ *
+ * Returns 1 if the transaction was queued, 0 if the
+ * queue is full or 'n' is zero, 'xfer' is not changed then.
+ */
+int SPI_DMA_submit(SPI_DMA_xfer *xfer, const uint8_t *tx, uint8_t *rx,
+                    uint16_t n, void (*callback)(SPI_DMA_xfer *)) {
+    uint32_t primask;
+    unsigned int next;
+    unsigned int was_empty;
+
+    if (0 == n)
+        return 0;
+
+    // it may be called from a callback (the interrupt)
+    primask = __get_PRIMASK();
+    __disable_irq();
+
+    next = (tail + 1) % SPI_DMA_QUEUE_LEN;
+    if (next == head) {
+        // full, 'xfer' is left as it was
+        __set_PRIMASK(primask);
+        return 0;
+    }
+
+    xfer->tx = tx;
+    xfer->rx = rx;
+    xfer->n = n;
+    xfer->callback = callback;
+    xfer->done = 0;
+
+    was_empty = (head == tail);
+
+    queue[tail] = xfer;
+    tail = next;
+
+    // If the queue was empty nothing is running, start it now.
+    // Otherwise the interrupt will start it when its turn comes.
+    if (was_empty)
+        start(xfer);
+
+    __set_PRIMASK(primask);
+
+    return 1;
+}
+// }}}
+
+/*
+ * SPI_DMA_wait()
+ *
+ * Block until the transaction is done.
+ */
+void SPI_DMA_wait(SPI_DMA_xfer *xfer) {
+    while (! xfer->done);
+}
+
+/*
+ * SPI_DMA_busy()
+ *
+ * Returns non-zero if any transactions are queued or running.
+ */
+unsigned int SPI_DMA_busy() {
+    return (head != tail);
+}
+
+// {{{ DMA1_Channel2_IRQHandler()
+/*
+ * DMA1_Channel2_IRQHandler()
+ *
+ * The last byte of the current transaction has been received.
+ * Finish it, release NSS and start the next one, if any.
+ */
+void DMA1_Channel2_IRQHandler() {
+    SPI_DMA_xfer *xfer;
+    SPI_DMA_xfer *next;
+
+    if (! DMA_GetITStatus(DMA1_IT_TC2))
+        return;
+
+    DMA_ClearITPendingBit(DMA1_IT_GL2);
+
+    DMA_Cmd(DMA1_Channel2, DISABLE);
+    DMA_Cmd(DMA1_Channel3, DISABLE);
+
+    // the last byte is in, wait for SCK to stop before NSS goes high
+    while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_BSY));
+
+    GPIO_SetBits(GPIOB, GPIO_Pin_5);  // NSS = 1, disable
+
+    xfer = queue[head];
+    head = (head + 1) % SPI_DMA_QUEUE_LEN;
+
+    // The next one is found before the callback, one it submits
+    // to an empty queue has already been started by SPI_DMA_submit().
+    next = (head != tail) ? queue[head] : 0;
+
+    xfer->done = 1;
+    if (xfer->callback)
+        xfer->callback(xfer);
+
+    if (next)
+        start(next);
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,69 @@
+#ifndef SPI_DMA_H
+#define SPI_DMA_H
+
+#include "stm32l1xx.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * spi_dma.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * SPI1 transfer engine driven by DMA.
+ *
+ * A transaction is a number of bytes sent and received
+ * (full duplex) with a single NSS assertion.
+ * Transactions are queued and each one is run by DMA1
+ * (channel 3 for transmit, channel 2 for receive).
+ * The NSS pin (PB5) is enabled at the start of each transaction
+ * and disabled from the DMA interrupt at its end, so the
+ * CPU is free while bytes are on the wire.
+ *
+ * When a transaction is complete its 'done' flag is set
+ * and its callback (if any) is called from the interrupt.
+ *
+ * The SPI must already be configured (see configure_SPI() in main.c).
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  configure_SPI();
+ *  configure_SPI_DMA();
+ *
+ *  uint8_t tx[2] = {0x74 | 0x80, 0x00};  // read switches
+ *  uint8_t rx[2];
+ *  SPI_DMA_xfer xfer;
+ *
+ *  SPI_DMA_submit(&xfer, tx, rx, 2, 0);
+ *
+ *  // do something else
+ *
+ *  SPI_DMA_wait(&xfer);
+ *  // rx[1] is the value of the switches
+ *
+ */
+
+// maximum number of transactions waiting in the queue
+#define SPI_DMA_QUEUE_LEN 8
+
+typedef struct SPI_DMA_xfer {
+    const uint8_t *tx;      // bytes to send
+    uint8_t *rx;            // received bytes, may be 0 to discard
+    uint16_t n;             // number of bytes
+    void (*callback)(struct SPI_DMA_xfer *);  // called when done, may be 0
+    volatile uint8_t done;  // set when complete
+} SPI_DMA_xfer;
+
+void configure_SPI_DMA();
+
+int SPI_DMA_submit(SPI_DMA_xfer *, const uint8_t *, uint8_t *, uint16_t,
+                    void (*)(SPI_DMA_xfer *));
+
+void SPI_DMA_wait(SPI_DMA_xfer *);
+
+unsigned int SPI_DMA_busy();
+
+#endif
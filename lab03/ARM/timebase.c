@@ -0,0 +1,86 @@
+/*
+ * NAME
+ * ----
+ *
+ * timebase.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * SysTick and TIM7 configuration for the time keeping
+ * functions, refer to timebase.h and tick.h.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "timebase.h"
+
+/*
+ * configure_timebase()
+ *
+ * SysTick reloads every 1 ms of HCLK.
+ *
+ * TIM7 free runs at 1 MHz (as near as the timer clock allows,
+ * MSI at 2.097 MHz gives 1.049 MHz).
+ */
+void configure_timebase() {
+    TIM_TimeBaseInitTypeDef TIM_init;
+    RCC_ClocksTypeDef clocks;
+    uint32_t tim_clk;
+
+    RCC_GetClocksFreq(&clocks);
+
+    // also enables the SysTick interrupt at the lowest priority
+    SysTick_Config(clocks.HCLK_Frequency / 1000);
+
+    RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM7, ENABLE);
+
+    // the timer clock is twice PCLK1 if APB1 is divided
+    tim_clk = clocks.PCLK1_Frequency;
+    if (clocks.PCLK1_Frequency != clocks.HCLK_Frequency)
+        tim_clk *= 2;
+
+    TIM_Cmd(TIM7, DISABLE);
+    TIM_TimeBaseStructInit(&TIM_init);
+    TIM_init.TIM_Prescaler = (tim_clk + 500000) / 1000000 - 1;  // 1 us
+    TIM_init.TIM_Period = 0xFFFF;
+    TIM_TimeBaseInit(TIM7, &TIM_init);
+    TIM_Cmd(TIM7, ENABLE);
+}
+
+/*
+ * delay_us()
+ *
+ * Wait for at least 'us' microseconds by polling TIM7.
+ * Long delays are split so the 16-bit counter never wraps
+ * twice between reads, delay_ms() is better for those.
+ */
+void delay_us(uint32_t us) {
+    uint16_t start;
+    uint32_t n;
+
+    while (us) {
+        n = (us > 50000) ? 50000 : us;
+        us -= n;
+
+        start = TIM7->CNT;
+        while ((uint16_t) (TIM7->CNT - start) <= n);
+    }
+}
+
+void SysTick_Handler() {
+    tick();
+}
+
+/*
+ * tick_wait()
+ *
+ * Sleep until the next interrupt, at worst the next tick.
+ */
+void tick_wait() {
+    __WFI();
+}
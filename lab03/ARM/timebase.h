@@ -0,0 +1,49 @@
+#ifndef TIMEBASE_H
+#define TIMEBASE_H
+
+#include "stm32l1xx.h"
+
+#include "tick.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * timebase.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Hardware timers to replace counted delay loops.
+ *
+ * SysTick interrupts every millisecond and calls tick()
+ * which drives now(), delay_ms() and the software timers
+ * (tick.h).
+ *
+ * TIM7 counts microseconds for the short delays of delay_us().
+ *
+ * Both are set up from the current clock frequencies (RCC) so
+ * configure_timebase() must be called again after SYSCLK is
+ * changed.  Doing so does not reset now() or stop the timers.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  configure_timebase();
+ *
+ *  delay_us(10);
+ *  delay_ms(250);
+ *
+ *  start = now();
+ *  ...
+ *  if (now() - start >= 1000) {
+ *      // one second has passed
+ *  }
+ *
+ */
+
+void configure_timebase();
+
+void delay_us(uint32_t);
+
+#endif
@@ -19,6 +19,9 @@
  *   0x74           | switch_ce_n
  *   0x6C           | bar_led_ce_n
  *   0x50 - 0x5F    | mem2_ce_n
+ *   0x32           | swap_ce_n
+ *   0x31           | page_hi_ce_n
+ *   0x30           | page_lo_ce_n
  *   0x2F           | board_led_ce_n
  *   0x00 - 0x0F    | mem1_ce_n
  *
@@ -35,7 +38,10 @@ module decoder(
                 board_led_ce_n,
                 switch_ce_n,
                 mem1_ce_n,
-                mem2_ce_n);
+                mem2_ce_n,
+                page_lo_ce_n,
+                page_hi_ce_n,
+                swap_ce_n);
 
     always @(address) begin
         // default, disabled
@@ -44,11 +50,17 @@ module decoder(
         mem2_ce_n      = 1'b1;
         board_led_ce_n = 1'b1;
         mem1_ce_n      = 1'b1;
+        page_lo_ce_n   = 1'b1;
+        page_hi_ce_n   = 1'b1;
+        swap_ce_n      = 1'b1;
 
         casex (address)
             7'h74: switch_ce_n    = 1'b0;
             7'h6C: bar_led_ce_n   = 1'b0;
             7'h5?: mem2_ce_n      = 1'b0;
+            7'h32: swap_ce_n      = 1'b0;
+            7'h31: page_hi_ce_n   = 1'b0;
+            7'h30: page_lo_ce_n   = 1'b0;
             7'h2F: board_led_ce_n = 1'b0;
             7'h0?: mem1_ce_n      = 1'b0;
         endcase
@@ -11,6 +11,16 @@
  * to to wire all the different modules together and
  * establish a bus.
  *
+ * CLOCKED BUS
+ *
+ * By default the bus is driven by spi_ctl.v which works
+ * directly on the SCK and NSS edges.  If CLOCKED_BUS is defined
+ * spi_ctl_sync.v is used instead, which runs the bus from
+ * the internal oscillator (OSCC) so that SCK can be much faster
+ * (refer to spi_ctl_sync.v for the limit).
+ *
+ *   `define CLOCKED_BUS
+ *
  * AUTHOR
  * ------
  *
@@ -20,8 +30,11 @@
 
 `include "decoder.v"
 `include "led_ctl.v"
+`include "mem_arb.v"
 `include "mem_ctl.v"
+`include "page_ctl.v"
 `include "spi_ctl.v"
+`include "spi_ctl_sync.v"
 `include "switch_ctl.v"
 
 module main(
@@ -46,6 +59,7 @@ module main(
 
 	wire [6:0] address;
 	wire [7:0] data;
+	wire [12:0] page;
 
 	GSR GSR_INST(.GSR(reset_n));
 
@@ -53,10 +67,14 @@ module main(
          board_led_ce_n,
          switch_ce_n,
          mem1_ce_n,
-         mem2_ce_n;
+         mem2_ce_n,
+         page_lo_ce_n,
+         page_hi_ce_n,
+         swap_ce_n;
 
 	decoder decoder1(address, bar_led_ce_n, board_led_ce_n, switch_ce_n,
-                    mem1_ce_n, mem2_ce_n);
+                    mem1_ce_n, mem2_ce_n, page_lo_ce_n, page_hi_ce_n,
+                    swap_ce_n);
 
 	led_ctl board_leds1(read_n, write_n, reset_n, board_led_ce_n,
                         data, board_leds);
@@ -64,17 +82,30 @@ module main(
 	led_ctl bar_leds1(read_n, write_n, reset_n, bar_led_ce_n,
                         data, bar_leds);
 
+`ifdef CLOCKED_BUS
+	wire osc_clk;
+
+	OSCC OSCC_1(.OSC(osc_clk));
+
+    // all of the bus devices are ready in one clock
+    wire ready;
+    assign ready = 1'b1;
+
+    spi_ctl_sync spi1(osc_clk, reset_n, nss, mosi, sck, ready, miso,
+                        address, data, read_n, write_n);
+`else
     spi_ctl spi1(nss, mosi, sck, miso, address, data, read_n, write_n);
+`endif
 
 	switch_ctl sw1(read_n, switch_ce_n, data, switches);
 
-	mem_ctl mem1(read_n, write_n, mem1_ce_n, address, data,
-                mem_data, mem_address, mem1_ceh_n, mem1_ce2, mem1_we_n,
-                mem1_oe_n);
+	page_ctl page1(read_n, write_n, reset_n, page_lo_ce_n, page_hi_ce_n,
+                        data, page);
 
-	mem_ctl mem2(read_n, write_n, mem2_ce_n, address, data,
-                mem_data, mem_address, mem2_ceh_n, mem2_ce2, mem2_we_n,
-                mem2_oe_n);
+	mem_arb arb1(read_n, write_n, reset_n, mem1_ce_n, mem2_ce_n, swap_ce_n,
+                address, page, data, mem_data, mem_address,
+                mem1_ceh_n, mem1_ce2, mem1_we_n, mem1_oe_n,
+                mem2_ceh_n, mem2_ce2, mem2_we_n, mem2_oe_n);
 
 endmodule
 
@@ -0,0 +1,155 @@
+/*
+ * NAME
+ * ----
+ *
+ * mem_arb - arbiter for the two RAM chips
+ *
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Both AS6C1008 RAM chips share the same data (mem_data) and
+ * address (mem_address) pins.  This module drives those pins
+ * from a single mem_ctl and grants the control lines (we_n, oe_n)
+ * to only one chip at a time, so the pins can never be fought
+ * over, even if both windows were enabled at once.
+ * If that happens the chip behind window 1 wins.
+ *
+ * PING-PONG
+ * ---------
+ *
+ * The swap register selects which chip is behind each window.
+ *
+ *    swap | window 1 (0x00 - 0x0F)  window 2 (0x50 - 0x5F)
+ *   ------+-----------------------------------------------
+ *     0   | mem1                    mem2
+ *     1   | mem2                    mem1
+ *
+ * So one window can always be used to fill the "back" buffer
+ * while the other window is used to read the "front" buffer.
+ * Writing the swap register exchanges them without any copying.
+ *
+ *    address (hex) | register
+ *  ----------------+---------------------
+ *   0x32           | swap (bit 0)  (swap_ce_n)
+ *
+ * Accesses of the two chips can also be interleaved at full speed
+ * in a single pipelined read (see spi_ctl.v) since there is no
+ * turn around time between them.
+ *
+ * CONTENTION MONITOR
+ * ------------------
+ *
+ * For simulation only there is a monitor which displays a message
+ * and counts (in 'contentions') any time both windows are enabled
+ * during an access or the pins could be driven by more than one
+ * device (both chips, or a chip and the CPLD).
+ * Test benches can check 'contentions' (e.g. 'test.m1.arb1.contentions').
+ * It is left out of the Verilator build since it relies on #0.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+module mem_arb(
+    input             read_n,
+                      write_n,
+                      reset_n,
+                      mem1_ce_n,
+                      mem2_ce_n,
+                      swap_ce_n,
+    input      [6:0]  address_bus,
+    input      [12:0] page,
+    inout      [7:0]  data_bus,
+
+    inout      [7:0]  mem_data,
+    output     [16:0] mem_address,
+    output wire       mem1_ceh_n,
+                      mem1_ce2,
+                      mem1_we_n,
+                      mem1_oe_n,
+                      mem2_ceh_n,
+                      mem2_ce2,
+                      mem2_we_n,
+                      mem2_oe_n);
+
+    reg swap;
+
+    // chip enables, after the swap
+    wire chip1_ce_n, chip2_ce_n;
+    assign chip1_ce_n = swap ? mem2_ce_n : mem1_ce_n;
+    assign chip2_ce_n = swap ? mem1_ce_n : mem2_ce_n;
+
+    // grants, chip 1 has priority
+    wire grant1, grant2;
+    assign grant1 = ~chip1_ce_n;
+    assign grant2 = ~chip2_ce_n & chip1_ce_n;
+
+    wire ce_n;
+    assign ce_n = ~(grant1 | grant2);
+
+    wire ceh_n, ce2, we_n, oe_n;
+
+    mem_ctl mem(read_n, write_n, ce_n, address_bus, page, data_bus,
+                mem_data, mem_address, ceh_n, ce2, we_n, oe_n);
+
+    assign mem1_ceh_n = ceh_n;
+    assign mem1_ce2   = ce2;
+    assign mem1_we_n  = grant1 ? we_n : 1'b1;
+    assign mem1_oe_n  = grant1 ? oe_n : 1'b1;
+
+    assign mem2_ceh_n = ceh_n;
+    assign mem2_ce2   = ce2;
+    assign mem2_we_n  = grant2 ? we_n : 1'b1;
+    assign mem2_oe_n  = grant2 ? oe_n : 1'b1;
+
+    // {{{ swap register
+    // READ
+    assign data_bus = (~(swap_ce_n | read_n | ~write_n)) ? {7'b0, swap} : 8'bz;
+
+    // WRITE, same as led_ctl.v
+    wire write_ce_n;
+    assign write_ce_n = write_n | swap_ce_n;
+
+    always @(negedge reset_n, posedge write_ce_n) begin
+        if (~reset_n)
+            swap <= 1'b0;
+        else
+            swap <= data_bus[0];
+    end
+    // }}}
+
+    // {{{ contention monitor
+    // synthesis translate_off
+`ifndef VERILATOR
+    integer contentions;
+
+    initial
+        contentions = 0;
+
+    // #0 lets all the combinational logic settle first
+    always @(mem1_ce_n, mem2_ce_n, read_n, write_n,
+                mem1_oe_n, mem1_we_n, mem2_oe_n, mem2_we_n) begin
+        #0;
+        if (~mem1_ce_n & ~mem2_ce_n & ~(read_n & write_n)) begin
+            contentions = contentions + 1;
+            $display("%t: mem_arb: both RAM windows enabled", $time);
+        end
+
+        // a chip driving mem_data while the other chip,
+        // or the CPLD (we_n), does too
+        if ((~mem1_oe_n & mem1_we_n) & (~mem2_oe_n | ~mem2_we_n)
+                | (~mem2_oe_n & mem2_we_n) & (~mem1_oe_n | ~mem1_we_n)) begin
+            contentions = contentions + 1;
+            $display("%t: mem_arb: mem_data contention", $time);
+        end
+    end
+`endif
+    // synthesis translate_on
+    // }}}
+endmodule
+
+// vim:foldmethod=marker
@@ -8,9 +8,14 @@
  * DESCRIPTION
  * -----------
  * 
- * Module for interfacing an Alliance AS6C1008 128x8 RAM chip
+ * Module for interfacing an Alliance AS6C1008 128Kx8 RAM chip
  * on to an 8-bit data bus and a 7-bit address bus.
  *
+ * Only the lower 4 bits of the address bus select a byte
+ * within the 16 byte window given by the decoder.  The
+ * upper 13 bits of the RAM address come from 'page'
+ * (see page_ctl.v).
+ *
  * AUTHOR
  * ------
  *
@@ -23,6 +28,7 @@ module mem_ctl(
                       write_n,
                       ce_n,
     input      [6:0]  address_bus,
+    input      [12:0] page,
     inout      [7:0]  data_bus,
 
 	inout      [7:0]  mem_data,
@@ -32,10 +38,9 @@ module mem_ctl(
                       we_n,
                       oe_n);
 
-	// tie unused address bits low
-	assign mem_address[16:7] = 0;
+	assign mem_address[16:4] = page;
 
-	assign mem_address[6:0] = address_bus;
+	assign mem_address[3:0] = address_bus[3:0];
 
 	// if read enabled, drive current data, otherwise go hi Z
 
@@ -0,0 +1,78 @@
+/*
+ * NAME
+ * ----
+ *
+ * page_ctl - bussed RAM page register
+ *
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The RAM windows in the address map (see decoder.v) are only
+ * 16 bytes wide, far less than the 128K of an AS6C1008.
+ * This register supplies the upper 13 bits of the RAM address
+ * (mem_address[16:4]) so that all 8192 16-byte pages of each
+ * chip can be reached.
+ *
+ * The page is split across two bus addresses.
+ *
+ *    address (hex) | register
+ *  ----------------+---------------------
+ *   0x30           | page[7:0]   (lo_ce_n)
+ *   0x31           | page[12:8]  (hi_ce_n)
+ *
+ * Since the two are adjacent a single two byte burst write
+ * (see spi_ctl.v) will set the whole page.
+ * Both registers can be read back, the unused upper bits of
+ * the high register read as zero.
+ *
+ * Writes follow the same rules as led_ctl.v, the value is
+ * latched when write_n or the chip enable is released.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+module page_ctl(
+    input             read_n,
+                      write_n,
+                      reset_n,
+                      lo_ce_n,
+                      hi_ce_n,
+    inout      [7:0]  data,
+    output     [12:0] page);
+
+    reg [7:0] page_lo;
+    reg [4:0] page_hi;
+
+    assign page = {page_hi, page_lo};
+
+    // READ
+    assign data = (~(lo_ce_n | read_n | ~write_n)) ? page_lo :
+                  (~(hi_ce_n | read_n | ~write_n)) ? {3'b000, page_hi} :
+                  8'bz;
+
+    // psuedo wires that go low when BOTH write_n and the
+    // respective chip enable are low (see led_ctl.v)
+    wire write_lo_ce_n, write_hi_ce_n;
+    assign write_lo_ce_n = write_n | lo_ce_n;
+    assign write_hi_ce_n = write_n | hi_ce_n;
+
+    // WRITE
+    always @(negedge reset_n, posedge write_lo_ce_n) begin
+        if (~reset_n)
+            page_lo <= 8'h00;
+        else
+            page_lo <= data;
+    end
+
+    always @(negedge reset_n, posedge write_hi_ce_n) begin
+        if (~reset_n)
+            page_hi <= 5'h00;
+        else
+            page_hi <= data[4:0];
+    end
+endmodule
@@ -29,6 +29,47 @@
  *            +--+  +--+     +--+  +--+
  *  SCK   ____|  |__|  | ... |  |__|  |_____
  *
+ * BURST MODE
+ *
+ * The first byte is always the 7-bit address and the rw bit.
+ * Any number of data bytes may follow it before NSS is disabled.
+ * After each data byte the address is incremented so that
+ * a block of consecutive addresses (such as a mem_ctl window)
+ * can be transferred with a single NSS assertion.
+ *
+ *   NSS low | addr/rw | data[A] | data[A+1] | ... | data[A+n-1] | NSS high
+ *
+ * For a write each data byte is written to the bus at the end
+ * of that byte.  The address is incremented once the write
+ * strobe (write_n) has been released, during the following byte.
+ *
+ * For a read the data for the next address must already be
+ * in the shift register at the end of each byte.  So the address
+ * is incremented near the start of each data byte and the next
+ * value is loaded at its end (a prefetch).
+ * This means that during a normal two byte read the address bus
+ * is at (A + 1) for most of the second byte.  Reads do not have side
+ * effects on any of the bus devices so this is harmless.
+ *
+ * A two byte transaction behaves just as it did before
+ * burst mode was added.
+ *
+ * PIPELINED READS
+ *
+ * During a read the byte sent by the master while the data
+ * is shifted out on MISO used to be a "form feed" whose value
+ * was ignored.  Now if that byte has the rw bit set it is taken
+ * as the next read command.  Its address is latched at the end of
+ * the byte and its data is shifted out during the following byte.
+ *
+ *   MOSI | read A | read B | read C | 0x00   |
+ *   MISO | xx     | data A | data B | data C |
+ *
+ * So n reads of arbitrary addresses take (n + 1) bytes instead
+ * of 2n.  A byte with the rw bit clear continues the burst
+ * (next address) as described above, so a form feed of 0x00
+ * works for both.  Only reads can be pipelined, a write must
+ * start with a new NSS assertion.
  *
  * AUTHOR
  * ------
@@ -48,8 +89,12 @@ module spi_ctl(
     output reg       write_n);
 
     // sample count
+    // 1 - 8 is the address byte, 9 - 16 repeats for each data byte
     reg [8:0] count;
 
+    // set once the first data byte is complete (burst in progress)
+    reg burst;
+
 	reg mosi_sample;
 
     // drive the data bus for a write, high Z otherwise
@@ -93,7 +138,12 @@ module spi_ctl(
 
             if (start) begin
                 count  <= 1;
+                burst  <= 1'b0;
                 read_n <= 1'b1; // disable
+            end else if (16 == count) begin
+                // end of a data byte, another one follows (BURST)
+                count  <= 9;
+                burst  <= 1'b1;
             end else begin
                 count       <= count + 1;
             end
@@ -111,6 +161,19 @@ module spi_ctl(
                 // (WRITE), got the second byte, setup to write it to the bus
                 write_data_bus <= {r_reg[6:0], mosi};
                 // can't use r_next here because we need mosi
+            end else if (15 == count && r_reg[6] == 1'b1) begin
+                // (PIPELINED READ), the byte that was received while the
+                // data went out is another read command, its data is
+                // loaded at the end of this byte.
+                address_bus <= {r_reg[5:0], mosi};
+            end else if (9 == count) begin
+                // (BURST), advance to the next address
+                //
+                // READ: the next value is loaded at the end of this byte
+                // WRITE: the previous byte has already been written
+                //        (write_n was released on the last PROPAGATE)
+                if (read_n == 1'b0 || burst)
+                    address_bus <= address_bus + 1;
             end
         end
     end
@@ -127,14 +190,20 @@ module spi_ctl(
         end else begin
             r_reg <= r_next;
 
-            if (1 == count) begin
+            if (1 == count || 9 == count) begin
+                // start of first byte or start of next data byte
                 write_n <= 1'b1; // disable
             end else if (8 == count) begin
                 // if (READ), load the data to be sent back
                 if (1'b0 == read_n)
                     r_reg <= data_bus;
             end else if (16 == count) begin
-                // end of second byte
+                // end of a data byte
+
+                // if (READ), load the data for the next byte
+                //  (next address of a burst or a pipelined read command)
+                if (1'b0 == read_n)
+                    r_reg <= data_bus;
 
                 // if (WRITE), enable write.
                 //  (the enabled device will drive the bus)
@@ -0,0 +1,241 @@
+/*
+ * NAME
+ * ----
+ *
+ *   spi_ctl_sync.v - SPI slave with a clocked bus
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This module implements the same SPI protocol as spi_ctl.v
+ * (two byte transactions, bursts and pipelined reads) but
+ * everything is done on the edges of a free running clock
+ * (the MachXO OSCC oscillator, see main.v) instead of on
+ * the edges of SCK and NSS.
+ *
+ *  - SCK, NSS and MOSI pass through two flip flop synchronizers
+ *    and the SCK edges are found by comparing the synchronized
+ *    value with the previous one.
+ *
+ *  - read_n and write_n are registered strobes.  The address (and
+ *    the data for a write) are set up one clock before the strobe
+ *    and held one clock after it, so the edge triggered registers
+ *    (led_ctl.v, page_ctl.v, mem_arb.v) always latch stable data.
+ *
+ *  - A strobe is held until the device signals 'ready'.  All of
+ *    the current devices are ready in one clock so main.v ties
+ *    it high, a slower device could hold it low.
+ *
+ * A bus cycle looks like this (one character per clock).
+ *
+ *               read          write
+ *  address_bus  -<A>-------   -<A>--------
+ *  data_bus     ---<D>-----   --<D  D  D>-
+ *  read_n       ~~~|_|~~~~~   ~~~~~~~~~~~~
+ *  write_n      ~~~~~~~~~~~   ~~~~|_|~~~~~
+ *  ready        ---1-------   ----1-------
+ *
+ * TIMING
+ *
+ * The slave has to turn a read around between the SCK rise of
+ * the last bit of a command and the following SCK fall,
+ * when the data is loaded to be shifted out.  That takes up to
+ * three clocks for the synchronizer and edge detection and
+ * two for the bus cycle.  Then the first bit must be on MISO
+ * before the next SCK rise.
+ *
+ * So the SCK high and low times must be at least three OSC
+ * periods, four are used as the safe limit (SCK <= OSC / 8).
+ * This is found by main-clocked-test.v which sweeps the
+ * SCK/OSC ratio.
+ *
+ * AUTHOR
+ * ------
+ *
+ *   Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+module spi_ctl_sync(
+    input            clk,
+                     reset_n,
+                     nss,
+                     mosi,
+                     sck,
+                     ready,
+    output           miso,
+    output reg [6:0] address_bus,
+    inout      [7:0] data_bus,
+    output reg       read_n,
+    output reg       write_n);
+
+    // {{{ synchronizers
+    reg [2:0] sck_s;
+    reg [1:0] nss_s;
+    reg [1:0] mosi_s;
+
+    always @(posedge clk, negedge reset_n) begin
+        if (~reset_n) begin
+            sck_s  <= 3'b000;
+            nss_s  <= 2'b11;
+            mosi_s <= 2'b00;
+        end else begin
+            sck_s  <= {sck_s[1:0], sck};
+            nss_s  <= {nss_s[0], nss};
+            mosi_s <= {mosi_s[0], mosi};
+        end
+    end
+
+    wire sck_rise, sck_fall;
+    assign sck_rise = sck_s[1] & ~sck_s[2];
+    assign sck_fall = ~sck_s[1] & sck_s[2];
+    // }}}
+
+    // {{{ SPI
+    // sample count, same as spi_ctl.v except 0 is the start
+    // 1 - 8 is the address byte, 9 - 16 repeats for each data byte
+    reg [4:0] count;
+
+    // set once the first data byte is complete (burst in progress)
+    reg burst;
+
+    // this is a read transaction
+    reg read;
+
+    reg mosi_sample;
+
+	// read register, shifted out on MISO
+	reg [7:0] r_reg;
+    assign miso = r_reg[7];
+
+    // requests for a bus cycle, see below
+    reg rd_req, wr_req;
+
+    reg [7:0] write_data_bus;
+    reg [7:0] read_data;
+
+    always @(posedge clk, negedge reset_n) begin
+        if (~reset_n) begin
+            count  <= 0;
+            burst  <= 1'b0;
+            read   <= 1'b0;
+            r_reg  <= 8'h00;
+            rd_req <= 1'b0;
+            wr_req <= 1'b0;
+            address_bus <= 7'h00;
+            write_data_bus <= 8'h00;
+            mosi_sample <= 1'b0;
+        end else begin
+            // defaults
+            rd_req <= 1'b0;
+            wr_req <= 1'b0;
+
+            if (nss_s[1]) begin
+                // disabled, ready for the next transaction
+                count <= 0;
+                burst <= 1'b0;
+                read  <= 1'b0;
+                r_reg <= 8'h00;
+            end else if (sck_rise) begin
+                // SAMPLE
+                mosi_sample <= mosi_s[1];
+
+                if (16 == count) begin
+                    // end of a data byte, another one follows (BURST)
+                    count <= 9;
+                    burst <= 1'b1;
+                end else begin
+                    count <= count + 1;
+                end
+
+                if (7 == count) begin
+                    // end of first byte, 7-bit address and rw bit
+                    address_bus <= {r_reg[5:0], mosi_s[1]};
+
+                    if (r_reg[6] == 1'b1) begin
+                        read   <= 1'b1;
+                        rd_req <= 1'b1;
+                    end
+                end else if (15 == count && ~read) begin
+                    // (WRITE), got a data byte, write it now
+                    write_data_bus <= {r_reg[6:0], mosi_s[1]};
+                    wr_req <= 1'b1;
+                end else if (15 == count && r_reg[6] == 1'b1) begin
+                    // (PIPELINED READ), another read command
+                    address_bus <= {r_reg[5:0], mosi_s[1]};
+                    rd_req <= 1'b1;
+                end else if (9 == count) begin
+                    // (BURST), advance to the next address
+                    if (read) begin
+                        address_bus <= address_bus + 1;
+                        rd_req <= 1'b1;
+                    end else if (burst) begin
+                        address_bus <= address_bus + 1;
+                    end
+                end
+            end else if (sck_fall) begin
+                // PROPAGATE
+                if ((8 == count || 16 == count) && read)
+                    r_reg <= read_data;
+                else
+                    r_reg <= {r_reg[6:0], mosi_sample};
+            end
+        end
+    end
+    // }}}
+
+    // {{{ bus cycles
+    parameter IDLE   = 2'd0,
+              SETUP  = 2'd1,
+              STROBE = 2'd2,
+              HOLD   = 2'd3;
+
+    reg [1:0] state;
+
+    // drive the data bus for a write, high Z otherwise
+    reg drive;
+    assign data_bus = drive ? write_data_bus : 8'bz;
+
+    always @(posedge clk, negedge reset_n) begin
+        if (~reset_n) begin
+            state   <= IDLE;
+            drive   <= 1'b0;
+            read_n  <= 1'b1;
+            write_n <= 1'b1;
+            read_data <= 8'h00;
+        end else begin
+            case (state)
+                IDLE:
+                    if (rd_req) begin
+                        // the address was set up on the last clock
+                        read_n <= 1'b0;
+                        state  <= STROBE;
+                    end else if (wr_req) begin
+                        drive <= 1'b1;
+                        state <= SETUP;
+                    end
+                SETUP: begin
+                    write_n <= 1'b0;
+                    state   <= STROBE;
+                end
+                STROBE:
+                    if (ready) begin
+                        if (~read_n)
+                            read_data <= data_bus;
+                        read_n  <= 1'b1;
+                        write_n <= 1'b1;
+                        state   <= HOLD;
+                    end
+                HOLD: begin
+                    // data is held while the devices latch it
+                    drive <= 1'b0;
+                    state <= IDLE;
+                end
+            endcase
+        end
+    end
+    // }}}
+
+endmodule
+
+// vim:foldmethod=marker
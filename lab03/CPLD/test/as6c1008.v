@@ -0,0 +1,70 @@
+/*
+ * NAME
+ * ----
+ *
+ * as6c1008.v - behavioral model of the Alliance AS6C1008 RAM
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * A simple model of the 128K x 8 Alliance AS6C1008 static RAM
+ * used for simulation only.
+ * It follows the truth table given on page 3 of the data sheet
+ * (datasheets/Alliance-RAM-1927457.pdf).
+ *
+ *   ce_n  ce2  oe_n  we_n | mode
+ *  -----------------------+------------------------
+ *    1     x    x     x   | standby, dq high Z
+ *    x     0    x     x   | standby, dq high Z
+ *    0     1    1     1   | output disabled, high Z
+ *    0     1    0     1   | read, mem[a] driven on dq
+ *    0     1    x     0   | write, dq stored in mem[a]
+ *
+ * No timing is modeled, reads and writes take effect immediately.
+ * The contents can be inspected by a test bench through
+ * the 'mem' array (e.g. 'test.ram1.mem[5]').
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+module as6c1008(
+    input      [16:0] a,
+    inout      [7:0]  dq,
+    input             ce_n,
+                      ce2,
+                      we_n,
+                      oe_n);
+
+    reg [7:0] mem [0:(1 << 17) - 1];
+
+    wire enabled;
+    assign enabled = ~ce_n & ce2;
+
+    // READ
+    assign dq = (enabled & ~oe_n & we_n) ? mem[a] : 8'bz;
+
+    // WRITE
+    // The last value on dq while we_n is low is the one stored.
+    // Since no timing is modeled dq may go high Z in the same
+    // instant that we_n is released.  Such values are ignored
+    // in place of the data hold time of the real device.
+    // (Verilator has no Z or X values and settles all the
+    // combinational logic first so it does not have this problem.)
+`ifdef VERILATOR
+    /* verilator lint_off LATCH */
+    always @(enabled, we_n, a, dq) begin
+        if (enabled & ~we_n)
+            mem[a] = dq;
+    end
+    /* verilator lint_on LATCH */
+`else
+    always @(enabled, we_n, a, dq) begin
+        if (enabled & ~we_n & (^dq !== 1'bx))
+            mem[a] = dq;
+    end
+`endif
+endmodule
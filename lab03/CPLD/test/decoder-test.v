@@ -9,14 +9,20 @@ module test;
          board_led_ce_n,
          switch_ce_n,
          mem1_ce_n,
-         mem2_ce_n;
+         mem2_ce_n,
+         page_lo_ce_n,
+         page_hi_ce_n,
+         swap_ce_n;
 
 	decoder d1(address,
         bar_led_ce_n,
         board_led_ce_n,
         switch_ce_n,
         mem1_ce_n,
-        mem2_ce_n);
+        mem2_ce_n,
+        page_lo_ce_n,
+        page_hi_ce_n,
+        swap_ce_n);
 
 	initial begin
 		$dumpfile("decoder-test.vcd");
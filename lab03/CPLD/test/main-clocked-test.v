@@ -0,0 +1,221 @@
+/*
+ * NAME
+ * ----
+ *
+ *  main-clocked-test.v - SCK/OSC ratio sweep of the clocked bus
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench builds main.v with CLOCKED_BUS defined
+ * (spi_ctl_sync.v) and a model of the OSCC oscillator, and then
+ * runs the same set of SPI transactions at a range of SCK rates.
+ *
+ * The SCK high/low time (SPI_DELAY) is swept from 10 OSC periods
+ * down to 1 in steps of a tenth of an OSC period.  Since the
+ * steps do not line up with the oscillator the SCK edges land
+ * on many different phases of it.
+ * At each step the following are performed and checked.
+ *
+ *  - write/read the bar LEDs
+ *  - a 16 byte burst write/read of a RAM window
+ *  - pipelined reads of the switches, bar LEDs and RAM
+ *
+ * A line is displayed for each step and the fastest SCK for which
+ * it and every slower step passed is reported as the maximum
+ * safe rate.  The test FAILs if any step at or above the design
+ * limit (MIN_DELAY, see spi_ctl_sync.v) fails.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`define CLOCKED_BUS
+`include "../main.v"
+`include "as6c1008.v"
+
+// half of the OSC period
+`define OSC_HALF 5
+
+// GSR is a module provide by Diamond for the MachXO
+// Here we create a pseudo one that does nothing,
+// reset_n is driven by the test bench.
+module GSR(input GSR);
+endmodule
+
+// OSCC is also provided by Diamond, this one just free runs.
+module OSCC(output reg OSC);
+    initial
+        OSC = 1'b0;
+
+    always
+        #`OSC_HALF OSC = ~OSC;
+endmodule
+
+module test;
+
+    // slowest and fastest SCK high/low time tested
+    parameter MAX_DELAY = 20 * `OSC_HALF;
+    parameter MIN_TESTED = 2 * `OSC_HALF;
+    // design limit, four OSC periods
+    parameter MIN_DELAY = 8 * `OSC_HALF;
+
+    reg           sck,
+                  nss,
+                  mosi,
+                  reset_n;
+    wire          miso;
+    wire   [16:0] mem_address;
+    wire   [7:0]  mem_data;
+    wire          mem1_ceh_n,
+                  mem1_ce2,
+                  mem1_we_n,
+                  mem1_oe_n,
+                  mem2_ceh_n,
+                  mem2_ce2,
+                  mem2_we_n,
+                  mem2_oe_n;
+    wire   [7:0]  board_leds,
+                  bar_leds;
+    reg    [7:0]  switches;
+
+    main m1(sck, nss, mosi, reset_n, miso, mem_address,
+            mem_data, mem1_ceh_n, mem1_ce2, mem1_we_n,
+            mem1_oe_n, mem2_ceh_n, mem2_ce2, mem2_we_n,
+            mem2_oe_n, board_leds, bar_leds, switches);
+
+    as6c1008 ram1(mem_address, mem_data, mem1_ceh_n, mem1_ce2,
+                    mem1_we_n, mem1_oe_n);
+
+    as6c1008 ram2(mem_address, mem_data, mem2_ceh_n, mem2_ce2,
+                    mem2_we_n, mem2_oe_n);
+
+    integer errors;
+    integer checks;
+
+    // the SCK rate is changed during the test
+    integer spi_delay;
+    `define SPI_DELAY spi_delay
+
+    `include "spi_tasks.v"
+
+    // errors in the current step
+    integer step_errors;
+
+    /*
+     * step_check(got, expected)
+     *
+     * Like check() (spi_tasks.v) but failures are expected at
+     * high rates so they are only counted.
+     */
+    task step_check;
+        input [7:0] got;
+        input [7:0] expected;
+        begin
+            if (got !== expected)
+                step_errors = step_errors + 1;
+        end
+    endtask
+
+    integer n;
+    integer seed;
+    integer safe;
+    integer broken;
+    reg [7:0] rx;
+    reg [7:0] val;
+    reg [7:0] block [0:15];
+
+	initial begin
+		$dumpfile("main-clocked-test.vcd");
+		$dumpvars(1,test);
+
+        errors = 0;
+        checks = 0;
+        seed = 344;
+        safe = 0;
+        broken = 0;
+
+        nss = 1;
+        sck = 0;
+        mosi = 0;
+        switches = ~(8'hF4);
+
+        reset_n = 1;
+        #10 reset_n = 0;
+        #10 reset_n = 1;
+
+        for (spi_delay = MAX_DELAY; spi_delay >= MIN_TESTED;
+                spi_delay = spi_delay - 1) begin
+            step_errors = 0;
+
+            // bar leds
+            val = $random(seed);
+            spi_write(7'h6C, val);
+            step_check(~(bar_leds), val);
+            spi_read(7'h6C, rx);
+            step_check(rx, val);
+
+            // burst write/read of mem1
+            for (n = 0; n < 16; n = n + 1)
+                block[n] = $random(seed);
+
+            #`SPI_DELAY nss = 0;
+            spi_byte(8'h00, rx);  // WRITE 0x00
+            for (n = 0; n < 16; n = n + 1)
+                spi_byte(block[n], rx);
+            #`SPI_DELAY nss = 1;
+
+            #`SPI_DELAY nss = 0;
+            spi_byte(8'h80, rx);  // READ 0x00
+            for (n = 0; n < 16; n = n + 1) begin
+                spi_byte(8'h00, rx);
+                step_check(rx, block[n]);
+            end
+            #`SPI_DELAY nss = 1;
+
+            // pipelined reads
+            #`SPI_DELAY nss = 0;
+            spi_byte(8'hF4, rx);  // READ switches
+            spi_byte(8'hEC, rx);  // READ bar leds
+            step_check(rx, 8'hF4);
+            spi_byte(8'h85, rx);  // READ mem1[5]
+            step_check(rx, val);
+            spi_byte(8'h00, rx);  // form feed
+            step_check(rx, block[5]);
+            #`SPI_DELAY nss = 1;
+
+            $display("SCK high/low %0d.%0d OSC periods: %0s",
+                        spi_delay / (2 * `OSC_HALF),
+                        (spi_delay % (2 * `OSC_HALF)) * 10 / (2 * `OSC_HALF),
+                        step_errors ? "FAIL" : "ok");
+
+            checks = checks + 1;
+            if (step_errors) begin
+                broken = 1;
+                if (spi_delay >= MIN_DELAY)
+                    errors = errors + 1;
+            end else if (! broken) begin
+                // this and every slower step passed
+                safe = spi_delay;
+            end
+        end
+
+        if (safe) begin
+            $display("maximum safe SCK = OSC / %0d.%0d",
+                        2 * safe / (2 * `OSC_HALF),
+                        (2 * safe % (2 * `OSC_HALF)) * 10 / (2 * `OSC_HALF));
+        end else begin
+            $display("no safe SCK rate found");
+        end
+
+        report;
+
+        #20 $finish;
+	end
+
+endmodule
+
+// vim:foldmethod=marker
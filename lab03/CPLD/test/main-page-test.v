@@ -0,0 +1,221 @@
+/*
+ * NAME
+ * ----
+ *
+ *  main-page-test.v - RAM page register test of 'main'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench acts as the SPI master (spi_tasks.v) for the
+ * whole design and uses the page register (page_ctl.v) to reach
+ * every byte of both RAM chips.
+ *
+ * For each of the PAGES pages it writes the page register with
+ * a two byte burst and then fills the 16 byte window of each RAM
+ * with a burst write.
+ * Then every page is selected again, the page register is read
+ * back and both windows are checked with burst reads.
+ *
+ * Finally the contents of the behavioral RAM models (as6c1008.v)
+ * are compared directly so that any aliasing of the upper address
+ * bits is caught.
+ *
+ * A PASS or FAIL summary is displayed at the end (see the Makefile).
+ * Fewer pages can be given for a quick run.
+ *
+ *   iverilog ... -Ptest.PAGES=64 ...
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`include "../main.v"
+`include "as6c1008.v"
+
+// GSR is a module provide by Diamond for the MachXO
+// Here we create a pseudo one that does nothing,
+// reset_n is driven by the test bench.
+module GSR(input GSR);
+endmodule
+
+module test;
+
+    // number of pages tested, 8192 covers all 128K
+    parameter PAGES = 8192;
+
+    reg           sck,
+                  nss,
+                  mosi,
+                  reset_n;
+    wire          miso;
+    wire   [16:0] mem_address;
+    wire   [7:0]  mem_data;
+    wire          mem1_ceh_n,
+                  mem1_ce2,
+                  mem1_we_n,
+                  mem1_oe_n,
+                  mem2_ceh_n,
+                  mem2_ce2,
+                  mem2_we_n,
+                  mem2_oe_n;
+    wire   [7:0]  board_leds,
+                  bar_leds;
+    reg    [7:0]  switches;
+
+    main m1(sck, nss, mosi, reset_n, miso, mem_address,
+            mem_data, mem1_ceh_n, mem1_ce2, mem1_we_n,
+            mem1_oe_n, mem2_ceh_n, mem2_ce2, mem2_we_n,
+            mem2_oe_n, board_leds, bar_leds, switches);
+
+    as6c1008 ram1(mem_address, mem_data, mem1_ceh_n, mem1_ce2,
+                    mem1_we_n, mem1_oe_n);
+
+    as6c1008 ram2(mem_address, mem_data, mem2_ceh_n, mem2_ce2,
+                    mem2_we_n, mem2_oe_n);
+
+    integer errors;
+    integer checks;
+
+    `include "spi_tasks.v"
+
+    /*
+     * pattern(page, n, chip)
+     *
+     * Value stored in byte 'n' of 'page' of RAM 'chip'.
+     * The upper page bits are mixed in so that aliased
+     * pages hold different values.
+     */
+    function [7:0] pattern;
+        input [12:0] page;
+        input [3:0]  n;
+        input        chip;
+        pattern = (page[7:0] * 37) ^ {page[12:8], 3'b000} ^ (n * 13)
+                    ^ (chip ? 8'h5A : 8'h00);
+    endfunction
+
+    /*
+     * set_page(page)
+     *
+     * Write both page registers with one burst.
+     */
+    task set_page;
+        input [12:0] page;
+        reg   [7:0]  rx;
+        begin
+            #`SPI_DELAY nss = 0;
+            spi_byte(8'h30, rx);  // WRITE 0x30
+            spi_byte(page[7:0], rx);
+            spi_byte({3'b000, page[12:8]}, rx);
+            #`SPI_DELAY nss = 1;
+        end
+    endtask
+
+    /*
+     * fill_window(base, page, chip)
+     *
+     * Burst write the 16 byte RAM window at 'base'.
+     */
+    task fill_window;
+        input [6:0]  base;
+        input [12:0] page;
+        input        chip;
+        reg   [7:0]  rx;
+        integer k;
+        begin
+            #`SPI_DELAY nss = 0;
+            spi_byte({1'b0, base}, rx);
+            for (k = 0; k < 16; k = k + 1)
+                spi_byte(pattern(page, k, chip), rx);
+            #`SPI_DELAY nss = 1;
+        end
+    endtask
+
+    /*
+     * check_window(base, page, chip)
+     *
+     * Burst read the 16 byte RAM window at 'base' and check it.
+     */
+    task check_window;
+        input [6:0]  base;
+        input [12:0] page;
+        input        chip;
+        reg   [7:0]  rx;
+        integer k;
+        begin
+            #`SPI_DELAY nss = 0;
+            spi_byte({1'b1, base}, rx);
+            for (k = 0; k < 16; k = k + 1) begin
+                spi_byte(8'h00, rx);  // form feed
+                check("page read", rx, pattern(page, k, chip));
+            end
+            #`SPI_DELAY nss = 1;
+        end
+    endtask
+
+    integer p;
+    integer k;
+    reg [7:0] rx;
+
+	initial begin
+		$dumpfile("main-page-test.vcd");
+		// only the pins, the whole design for every page is too large
+		$dumpvars(1,test);
+
+        errors = 0;
+        checks = 0;
+
+        nss = 1;
+        sck = 0;
+        mosi = 0;
+        switches = 8'hFF;
+
+        reset_n = 1;
+        #10 reset_n = 0;
+        #10 reset_n = 1;
+
+        // page is zero after reset
+        spi_read(7'h30, rx);
+        check("page lo", rx, 8'h00);
+        spi_read(7'h31, rx);
+        check("page hi", rx, 8'h00);
+
+        // *** fill ***
+        for (p = 0; p < PAGES; p = p + 1) begin
+            set_page(p);
+            fill_window(7'h00, p, 0);
+            fill_window(7'h50, p, 1);
+        end
+
+        // *** verify ***
+        for (p = 0; p < PAGES; p = p + 1) begin
+            set_page(p);
+
+            spi_read(7'h30, rx);
+            check("page lo", rx, p[7:0]);
+            spi_read(7'h31, rx);
+            check("page hi", rx, {3'b000, p[12:8]});
+
+            check_window(7'h00, p, 0);
+            check_window(7'h50, p, 1);
+        end
+
+        // *** RAM contents ***
+        for (p = 0; p < PAGES; p = p + 1) begin
+            for (k = 0; k < 16; k = k + 1) begin
+                check("ram1", ram1.mem[p * 16 + k], pattern(p, k, 0));
+                check("ram2", ram2.mem[p * 16 + k], pattern(p, k, 1));
+            end
+        end
+
+        report;
+
+        #20 $finish;
+	end
+
+endmodule
+
+// vim:foldmethod=marker
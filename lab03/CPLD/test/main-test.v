@@ -1,15 +1,57 @@
+/*
+ * NAME
+ * ----
+ *
+ *  main-test.v - self checking test of 'main'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench acts as the SPI master (spi_tasks.v) for
+ * the whole design and runs every bus scenario in one simulation.
+ *
+ *  1. read the switches
+ *  2. write/read the bar LEDs and the board LEDs
+ *  3. write/read both RAM windows
+ *  4. burst write/read of a RAM window
+ *  5. pipelined reads of several devices
+ *  6. ping-pong between the RAM chips (swap register, see mem_arb.v)
+ *  7. NRANDOM random reads and writes
+ *
+ * Two behavioral models of the RAM chips (as6c1008.v) are
+ * connected to the memory pins.
+ *
+ * Every value read and the LED pins are checked against a
+ * scoreboard of the expected bus state, and the contention monitor
+ * of mem_arb.v must not have found anything.
+ * A PASS or FAIL summary is displayed at the end (see the Makefile).
+ *
+ * The number of random transactions and the seed can be
+ * changed from the command line.
+ *
+ *   iverilog ... -Ptest.NRANDOM=10000 -Ptest.SEED=7 ...
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
 
 `include "../main.v"
+`include "as6c1008.v"
 
 // GSR is a module provide by Diamond for the MachXO
-// Here we create a pseudo one that just never causes
-// a reset.
-module GSR(output GSR);
-    assign GSR = 1'b1;
+// Here we create a pseudo one that does nothing,
+// reset_n is driven by the test bench.
+module GSR(input GSR);
 endmodule
 
 module test;
 
+    parameter NRANDOM = 1000;
+    parameter SEED    = 344;
+
     reg           sck,
                   nss,
                   mosi,
@@ -34,176 +76,260 @@ module test;
             mem1_oe_n, mem2_ceh_n, mem2_ce2, mem2_we_n,
             mem2_oe_n, board_leds, bar_leds, switches);
 
-	// data to be written to the slave
-	reg [7:0] w_mosi;
+    as6c1008 ram1(mem_address, mem_data, mem1_ceh_n, mem1_ce2,
+                    mem1_we_n, mem1_oe_n);
+
+    as6c1008 ram2(mem_address, mem_data, mem2_ceh_n, mem2_ce2,
+                    mem2_we_n, mem2_oe_n);
+
+    integer errors;
+    integer checks;
+
+    `include "spi_tasks.v"
+
+    // {{{ scoreboard
+    // expected values of each device on the bus
+    reg [7:0] sb_bar;
+    reg [7:0] sb_board;
+    reg       sb_swap;
+    // indexed by chip, not window
+    reg [7:0] sb_mem1 [0:15];
+    reg [7:0] sb_mem2 [0:15];
+
+    /*
+     * sb_read(addr, data)
+     *
+     * Expected value of a read of 'addr'.
+     */
+    task sb_read;
+        input  [6:0] addr;
+        output [7:0] data;
+        begin
+            casex (addr)
+                7'h74: data = ~(switches);
+                7'h6C: data = sb_bar;
+                7'h5?: data = sb_swap ? sb_mem1[addr[3:0]] : sb_mem2[addr[3:0]];
+                7'h32: data = {7'b0, sb_swap};
+                7'h2F: data = sb_board;
+                7'h0?: data = sb_swap ? sb_mem2[addr[3:0]] : sb_mem1[addr[3:0]];
+                default: data = 8'hxx;
+            endcase
+        end
+    endtask
+
+    /*
+     * sb_write(addr, data)
+     *
+     * Record a write of 'data' to 'addr'.
+     */
+    task sb_write;
+        input [6:0] addr;
+        input [7:0] data;
+        begin
+            casex (addr)
+                7'h6C: sb_bar = data;
+                7'h5?: if (sb_swap)
+                           sb_mem1[addr[3:0]] = data;
+                       else
+                           sb_mem2[addr[3:0]] = data;
+                7'h32: sb_swap = data[0];
+                7'h2F: sb_board = data;
+                7'h0?: if (sb_swap)
+                           sb_mem2[addr[3:0]] = data;
+                       else
+                           sb_mem1[addr[3:0]] = data;
+            endcase
+        end
+    endtask
+
+    /*
+     * check_read(addr)
+     *
+     * Read 'addr' over the SPI and check it.
+     */
+    task check_read;
+        input [6:0] addr;
+        reg   [7:0] got;
+        reg   [7:0] expected;
+        begin
+            spi_read(addr, got);
+            sb_read(addr, expected);
+            check("read", got, expected);
+        end
+    endtask
+
+    /*
+     * check_write(addr, data)
+     *
+     * Write 'data' to 'addr' over the SPI and check the LED pins.
+     */
+    task check_write;
+        input [6:0] addr;
+        input [7:0] data;
+        begin
+            spi_write(addr, data);
+            sb_write(addr, data);
+
+            // the LEDs are inverted due to the pull up circuit
+            check("bar leds", ~(bar_leds), sb_bar);
+            check("board leds", ~(board_leds), sb_board);
+        end
+    endtask
+    // }}}
 
-	reg [4:0] i;
+    // mapped addresses, see ../decoder.v
+    function [6:0] random_addr;
+        input [31:0] r;
+        begin
+            case (r[2:0] % 6)
+                0: random_addr = 7'h74;
+                1: random_addr = 7'h6C;
+                2: random_addr = 7'h2F;
+                3: random_addr = {3'h0, r[6:3]};
+                4: random_addr = {3'h5, r[6:3]};
+                5: random_addr = 7'h32;
+            endcase
+        end
+    endfunction
+
+    integer n;
+    integer k;
+    integer seed;
+    reg [31:0] r;
+    reg [6:0]  addr;
+    reg [7:0]  rx;
+    reg [7:0]  expected;
 
 	initial begin
 		$dumpfile("main-test.vcd");
 		$dumpvars(0,test);
 
-        w_mosi = 8'h00;
+        errors = 0;
+        checks = 0;
+        seed = SEED;
+
         nss = 1;
         sck = 0;
+        mosi = 0;
 
-        // The time delays in this section are slower (#10)
-        // relative to the OSC clock (#1) (if used).
-        // On a real board the magnitudes would be much larger
-        // (kHz to MHz) so this is a worst case situation.
-        // Currently this is only important for the memory modules.
-
-        // {{{ *** EXAMPLE #1, read switches ***
-        // tested OK [jmm]  Wed, 02 May 2012 10:45:33 -0700
-
-        /*
-        // input value of external switches
-        switches = ~(8'hF4);
         // The switch_ctl module inverts the input switch values
         // due to the behavior of the pull up circuit.
         // Here we invert the values to mimic this behavior.
+        switches = ~(8'hF4);
 
-        #10 nss = 0;  // enabled
-
-        //
-        // At the END of the first byte:
-        //
-        //  read_n = 0, ce_n = 0  (enabled)
-        //
-        //  data = 0xF4  (value of switches)
-        //
-
-        // address of switches (0x74), read (0x80)
-        w_mosi = 8'h74 | 8'h80; // switches value with WRITE bit set
-        SPI_once();
-
-        //
-        // For the second byte the value read from the
-        // switches (0xF4) should be seen transferred
-        // across the miso pin.
-        //
-
-        w_mosi = 8'h00; // form feed, can be any value
-        SPI_once();
-
-        #10 nss = 1; // disable
-        */
-        // *** END EXAMPLE #1 *** }}}
-
-        // {{{ *** EXAMPLE #2, write bar leds ***
-        // tested OK [jmm]  Wed, 02 May 2012 19:20:39 -0700
-        /*
-        #10 nss = 0; // enable
-
-        // ADDRESS to write (rw bit left at 0 for WRITE)
-        w_mosi = 8'h6C;
-        SPI_once();
-
-        // DATA to be written
-        //
-        // At the END of the SECOND byte:
-        //
-        //   - leds should have the value ~(0x6D)
-        //   - when write_ce_n is low, data should be 0x6D
-        //   - when write_ce_n becomes disabled, data should go high z
-        //
-        w_mosi = 8'h6D;
-        SPI_once();
-
-        #10 nss = 1; // disable
-        */
-        // *** END EXAMPLE #2 *** }}}
-
-        // {{{ *** EXAMPLE #3, read bar leds ***
-
-        /*
-        #10 nss = 0;  // enabled
-
-        //
-        // At the END of the FIRST byte:
-        //   - the value stored in 'leds' should be driven on to 'data'
-        //
-
-        // address of bar leds (0x6C), read (0x80)
-        w_mosi = 8'h6C | 8'h80;
-        SPI_once();
-
-        // At the END of the SECOND byte:
-        //  - the 'data' should go high z
-        //
-
-        w_mosi = 8'h00; // form feed, can be any value
-        SPI_once();
-
-        #10 nss = 1; // disable
-        */
-        // *** END EXAMPLE #3 *** }}}
-
-        // {{{ *** EXAMPLE #4, write memor (RAM) ***
-
-        #10 nss = 0;  // enabled
-
-        //
-        // At the END of the FIRST byte:
-        //   - the value stored in 'leds' should be driven on to 'data'
-        //
-
-        // CMD: write first chip at address 0x00
-        w_mosi = 8'h00;
-        SPI_once();
-
-        // At the END of the SECOND byte:
-        //  - the 'data' should go high z
-        //
-
-        // data to write
-        w_mosi = 8'h3D;
-        SPI_once();
-
-        #10 nss = 1; // disable
-        // *** END EXAMPLE #4 *** }}}
+        // reset, leds are set to ~(0x00)
+        reset_n = 1;
+        #10 reset_n = 0;
+        #10 reset_n = 1;
+
+        sb_bar = 8'h00;
+        sb_board = 8'h00;
+        sb_swap = 1'b0;
+        check("bar leds", ~(bar_leds), sb_bar);
+        check("board leds", ~(board_leds), sb_board);
+
+        // *** 1. read switches ***
+        check_read(7'h74);
+
+        // *** 2. LEDs ***
+        check_write(7'h6C, 8'h6D);
+        check_read(7'h6C);
+        check_write(7'h2F, 8'hA5);
+        check_read(7'h2F);
+        // the switches are read only
+        check_write(7'h74, 8'h00);
+        check_read(7'h74);
+
+        // *** 3. RAM windows ***
+        for (n = 0; n < 16; n = n + 1) begin
+            check_write(n, n * 3);
+            check_write(7'h50 + n, 8'hFF - n);
+        end
+        for (n = 0; n < 16; n = n + 1) begin
+            check_read(n);
+            check_read(7'h50 + n);
+        end
+
+        // *** 4. burst write/read of mem2 ***
+        #`SPI_DELAY nss = 0;
+        spi_byte(8'h50, rx);  // WRITE 0x50
+        for (n = 0; n < 16; n = n + 1) begin
+            spi_byte(n * 17, rx);
+            sb_write(7'h50 + n, n * 17);
+        end
+        #`SPI_DELAY nss = 1;
+
+        #`SPI_DELAY nss = 0;
+        spi_byte(8'hD0, rx);  // READ 0x50
+        for (n = 0; n < 16; n = n + 1) begin
+            spi_byte(8'h00, rx);
+            sb_read(7'h50 + n, expected);
+            check("burst read", rx, expected);
+        end
+        #`SPI_DELAY nss = 1;
+
+        // *** 5. pipelined reads ***
+        #`SPI_DELAY nss = 0;
+        spi_byte(8'hF4, rx);  // READ switches
+        spi_byte(8'hEC, rx);  // READ bar leds
+        check("pipelined read", rx, ~(switches));
+        spi_byte(8'h85, rx);  // READ mem1[5]
+        check("pipelined read", rx, sb_bar);
+        spi_byte(8'h00, rx);  // form feed
+        check("pipelined read", rx, sb_mem1[5]);
+        #`SPI_DELAY nss = 1;
+
+        // *** 6. ping-pong ***
+        // Fill the back buffer (window 2) while reading the front
+        // buffer (window 1), then swap them, a few times over.
+        for (k = 0; k < 4; k = k + 1) begin
+            #`SPI_DELAY nss = 0;
+            spi_byte(8'h50, rx);  // WRITE 0x50
+            for (n = 0; n < 16; n = n + 1) begin
+                spi_byte(k * 16 + n, rx);
+                sb_write(7'h50 + n, k * 16 + n);
+            end
+            #`SPI_DELAY nss = 1;
+
+            for (n = 0; n < 16; n = n + 1)
+                check_read(n);
+
+            check_write(7'h32, {7'b0, ~sb_swap});
+            check_read(7'h32);
+
+            // the new front buffer is what was just written
+            for (n = 0; n < 16; n = n + 1) begin
+                spi_read(n, rx);
+                check("ping-pong", rx, k * 16 + n);
+            end
+        end
+
+        // *** 7. random ***
+        for (n = 0; n < NRANDOM; n = n + 1) begin
+            r = $random(seed);
+            addr = random_addr(r);
+
+            if (0 == r[15:8] % 32)
+                switches = r[31:24];
+
+            if (r[7])
+                check_read(addr);
+            else
+                check_write(addr, r[23:16]);
+        end
+
+        // the whole count, check() would compare only the low 8 bits
+        checks = checks + 1;
+        if (m1.arb1.contentions != 0) begin
+            errors = errors + 1;
+            $display("%t: FAIL contentions: %0d", $time, m1.arb1.contentions);
+        end
+
+        report;
 
         #20 $finish;
 	end
 
-    // {{{ SPI_once() 
-	/*
-     * SPI_once()
-     *
-     * Perform a single 8-bit SPI cycle.
-     *
-     * It mutates the global variables: mosi, sck
-     * And it writes to mosi whatever value is in w_mosi.
-     *
-     * It does not mutate nss, this is left to the controlling
-     * block.
-     */
-	task SPI_once;
-		begin
-
-		// enable SPI and assign the first value
-		 mosi = w_mosi[7];
-
-		// and finish the remaining 7 bits
-		i = 7;
-		repeat (7) begin
-			i = i - 1;
-			#10;
-			// sample
-			sck = 1;
-			#10;
-			// propagate
-			sck = 0;
-			mosi = w_mosi[i];
-		end
-		#10 sck = 1;
-		#10 sck = 0; // CPOL = 0
-
-		end
-	endtask
-    // }}}
-
 endmodule
 
-
-
+// vim:foldmethod=marker
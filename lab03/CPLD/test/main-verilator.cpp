@@ -0,0 +1,264 @@
+/*
+ * NAME
+ * ----
+ *
+ *  main-verilator.cpp - Verilator harness for 'main'
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  make verilator
+ *  ./obj_dir/Vmain_verilator [number of transactions] [seed]
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Streams random SPI transactions through the Verilator build
+ * of main.v (see main-verilator.v) and checks every byte received
+ * on MISO, and the LEDs after each transaction, against the golden
+ * model of the bus in ../../sim/cpld_model.c.
+ *
+ * The transactions are a random mix of
+ *
+ *  - single and burst writes to the LEDs, page and swap registers
+ *    and RAM windows
+ *  - single and burst reads of the RAM windows
+ *  - pipelined reads of random devices (including the switches)
+ *
+ * and the switch inputs are changed from time to time.
+ *
+ * At the end the number of simulated transactions per second of
+ * wall clock time is displayed.
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "Vmain_verilator.h"
+#include "verilated.h"
+
+#include "cpld_model.h"
+
+static Vmain_verilator *top;
+static cpld_model model;
+
+static unsigned long errors;
+static unsigned long bytes;
+
+// {{{ SPI
+/*
+ * spi_byte()
+ *
+ * Perform a single 8-bit SPI cycle (MSB first, CPOL = 0, CPHA = 0)
+ * and return the byte received on MISO.
+ * NSS is not changed.
+ */
+static uint8_t spi_byte(uint8_t mosi) {
+    uint8_t miso = 0;
+
+    for (int i = 7; i >= 0; i--) {
+        top->mosi = (mosi >> i) & 1;
+        top->eval();
+
+        // sample
+        top->sck = 1;
+        top->eval();
+        miso = (miso << 1) | (top->miso & 1);
+
+        // propagate
+        top->sck = 0;
+        top->eval();
+    }
+
+    bytes++;
+
+    return miso;
+}
+
+static void nss(int level) {
+    top->nss = level;
+    top->eval();
+
+    cpld_model_nss(&model, level);
+}
+
+/*
+ * transaction()
+ *
+ * Send 'n' bytes with a single NSS assertion and compare each
+ * byte received with the model.
+ */
+static void transaction(const uint8_t *tx, unsigned int n) {
+    uint8_t miso;
+    uint8_t expect;
+
+    nss(0);
+
+    for (unsigned int i = 0; i < n; i++) {
+        miso = spi_byte(tx[i]);
+        expect = cpld_model_xfer(&model, tx[i]);
+
+        if (miso != expect) {
+            if (errors < 10)
+                fprintf(stderr, "byte %u of transaction 0x%.2x: "
+                        "expected 0x%.2x, got 0x%.2x\n",
+                        i, tx[0], expect, miso);
+            errors++;
+        }
+    }
+
+    nss(1);
+
+    if (top->bar_leds != model.bar_leds || top->board_leds != model.board_leds) {
+        if (errors < 10)
+            fprintf(stderr, "LEDs after transaction 0x%.2x: expected "
+                    "0x%.2x 0x%.2x, got 0x%.2x 0x%.2x\n", tx[0],
+                    model.bar_leds, model.board_leds,
+                    top->bar_leds, top->board_leds);
+        errors++;
+    }
+}
+// }}}
+
+// {{{ random transactions
+// readable devices, see ../decoder.v
+static const uint8_t devices[] = {0x74, 0x6C, 0x32, 0x31, 0x30, 0x2F, 0x00, 0x50};
+
+#define NDEVICES (sizeof(devices) / sizeof(devices[0]))
+
+static uint8_t random_addr() {
+    uint8_t addr = devices[rand() % NDEVICES];
+
+    // somewhere in a RAM window
+    if (0x00 == addr || 0x50 == addr)
+        addr += rand() % 16;
+
+    return addr;
+}
+
+/*
+ * random_transaction()
+ *
+ * Fill 'tx' with a random transaction and return its length.
+ */
+static unsigned int random_transaction(uint8_t *tx) {
+    unsigned int n = 0;
+    unsigned int len;
+    uint8_t addr;
+
+    switch (rand() % 3) {
+        case 0:
+            // (burst) write, the switches are read only
+            do {
+                addr = random_addr();
+            } while (0x74 == addr);
+
+            // bursts stay inside the RAM window (or the page register)
+            len = 1;
+            if (0x30 == addr)
+                len += rand() % 2;
+            else if (0x00 == (addr & 0x70) || 0x50 == (addr & 0x70))
+                len += rand() % (16 - (addr & 0x0F));
+
+            tx[n++] = addr;
+            while (len--)
+                tx[n++] = rand();
+            break;
+        case 1:
+            // (burst) read of a RAM window
+            addr = (rand() % 2) ? 0x00 : 0x50;
+            addr += rand() % 16;
+            len = 1 + rand() % (16 - (addr & 0x0F));
+
+            tx[n++] = addr | 0x80;
+            while (len--)
+                tx[n++] = 0x00;  // form feed
+            break;
+        default:
+            // pipelined reads
+            len = 1 + rand() % 8;
+
+            while (len--)
+                tx[n++] = random_addr() | 0x80;
+            tx[n++] = 0x00;  // form feed
+            break;
+    }
+
+    return n;
+}
+// }}}
+
+int main(int argc, char *argv[]) {
+    unsigned long count = 1000000;
+    unsigned int seed = 344;
+    uint8_t tx[20];
+    unsigned int n;
+    struct timespec t0, t1;
+    double secs;
+
+    Verilated::commandArgs(argc, argv);
+
+    if (argc > 1)
+        count = strtoul(argv[1], 0, 0);
+    if (argc > 2)
+        seed = strtoul(argv[2], 0, 0);
+
+    srand(seed);
+
+    top = new Vmain_verilator;
+    cpld_model_init(&model);
+
+    // idle, then reset
+    top->sck = 0;
+    top->nss = 1;
+    top->mosi = 0;
+    top->switches = model.switches;
+    top->reset_n = 1;
+    top->eval();
+    top->reset_n = 0;
+    top->eval();
+    top->reset_n = 1;
+    top->eval();
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (unsigned long i = 0; i < count; i++) {
+        if (0 == rand() % 64) {
+            model.switches = rand();
+            top->switches = model.switches;
+            top->eval();
+        }
+
+        n = random_transaction(tx);
+        transaction(tx, n);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    top->final();
+    delete top;
+
+    printf("%lu transactions, %lu bytes in %.2f s\n", count, bytes, secs);
+    printf("%.0f transactions/s, %.0f bytes/s\n", count / secs, bytes / secs);
+
+    if (errors) {
+        printf("FAIL: %lu errors\n", errors);
+        return 1;
+    }
+
+    printf("PASS\n");
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,64 @@
+/*
+ * NAME
+ * ----
+ *
+ *  main-verilator.v - top level for the Verilator build of 'main'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Verilator does not support bidirectional (inout) ports at the
+ * top level very well, so this module wraps 'main' along with
+ * the two RAM chips (as6c1008.v).  Only the SPI pins, the reset,
+ * the switches and the LEDs are left as ports.
+ *
+ * It is driven by the C++ harness in main-verilator.cpp.
+ * Refer to that file and to the Makefile ('make verilator').
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`include "../main.v"
+`include "as6c1008.v"
+
+// GSR is a module provide by Diamond for the MachXO.
+// Here it does nothing, reset_n is driven by the harness.
+module GSR(input GSR);
+endmodule
+
+module main_verilator(
+    input        sck,
+                 nss,
+                 mosi,
+                 reset_n,
+    output       miso,
+    output [7:0] board_leds,
+                 bar_leds,
+    input  [7:0] switches);
+
+    wire [16:0] mem_address;
+    wire [7:0]  mem_data;
+    wire        mem1_ceh_n,
+                mem1_ce2,
+                mem1_we_n,
+                mem1_oe_n,
+                mem2_ceh_n,
+                mem2_ce2,
+                mem2_we_n,
+                mem2_oe_n;
+
+    main m1(sck, nss, mosi, reset_n, miso, mem_address,
+            mem_data, mem1_ceh_n, mem1_ce2, mem1_we_n,
+            mem1_oe_n, mem2_ceh_n, mem2_ce2, mem2_we_n,
+            mem2_oe_n, board_leds, bar_leds, switches);
+
+    as6c1008 ram1(mem_address, mem_data, mem1_ceh_n, mem1_ce2,
+                    mem1_we_n, mem1_oe_n);
+
+    as6c1008 ram2(mem_address, mem_data, mem2_ceh_n, mem2_ce2,
+                    mem2_we_n, mem2_oe_n);
+endmodule
@@ -0,0 +1,230 @@
+/*
+ * NAME
+ * ----
+ *
+ *  mem_arb-test.v - test of the RAM arbiter 'mem_arb.v'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench drives the bus side of mem_arb directly
+ * (no SPI) with two behavioral RAM models (as6c1008.v) on the
+ * memory pins.
+ *
+ *  1. writes/reads through both windows reach the right chips
+ *  2. ping-pong, with the swap register set the windows
+ *     are exchanged
+ *  3. both windows enabled at once, only one chip is granted
+ *     and the contention monitor counts it
+ *
+ * A PASS or FAIL summary is displayed at the end (see the Makefile).
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`include "../mem_ctl.v"
+`include "../mem_arb.v"
+`include "as6c1008.v"
+
+module test;
+
+    reg         read_n,
+                write_n,
+                reset_n,
+                mem1_ce_n,
+                mem2_ce_n,
+                swap_ce_n;
+    reg  [6:0]  address_bus;
+    reg  [12:0] page;
+    wire [7:0]  data_bus;
+
+    wire [7:0]  mem_data;
+    wire [16:0] mem_address;
+    wire        mem1_ceh_n,
+                mem1_ce2,
+                mem1_we_n,
+                mem1_oe_n,
+                mem2_ceh_n,
+                mem2_ce2,
+                mem2_we_n,
+                mem2_oe_n;
+
+    mem_arb arb1(read_n, write_n, reset_n, mem1_ce_n, mem2_ce_n, swap_ce_n,
+                address_bus, page, data_bus, mem_data, mem_address,
+                mem1_ceh_n, mem1_ce2, mem1_we_n, mem1_oe_n,
+                mem2_ceh_n, mem2_ce2, mem2_we_n, mem2_oe_n);
+
+    as6c1008 ram1(mem_address, mem_data, mem1_ceh_n, mem1_ce2,
+                    mem1_we_n, mem1_oe_n);
+
+    as6c1008 ram2(mem_address, mem_data, mem2_ceh_n, mem2_ce2,
+                    mem2_we_n, mem2_oe_n);
+
+    // the bus master (spi_ctl) drives the data bus during writes
+    reg [7:0] write_data_bus;
+    assign data_bus = (~write_n & read_n) ? write_data_bus : 8'bz;
+
+    integer errors;
+    integer checks;
+
+    // {{{ bus tasks
+    /*
+     * bus_write(window, addr, data)
+     *
+     * Write 'data' to 'addr' with the enable of 'window'
+     * (1, 2, 3 for both or 0 for the swap register).
+     */
+    task bus_write;
+        input [1:0] window;
+        input [6:0] addr;
+        input [7:0] data;
+        begin
+            address_bus = addr;
+            write_data_bus = data;
+            #2;
+            mem1_ce_n = ~window[0];
+            mem2_ce_n = ~window[1];
+            swap_ce_n = (0 != window);
+            #2 write_n = 0;
+            // release the enables first so the data is still
+            // driven when the registers latch it
+            #4;
+            mem1_ce_n = 1;
+            mem2_ce_n = 1;
+            swap_ce_n = 1;
+            #2 write_n = 1;
+        end
+    endtask
+
+    /*
+     * bus_read(window, addr, data)
+     *
+     * Read 'addr' in to 'data', 'window' as for bus_write().
+     */
+    task bus_read;
+        input  [1:0] window;
+        input  [6:0] addr;
+        output [7:0] data;
+        begin
+            address_bus = addr;
+            #2;
+            mem1_ce_n = ~window[0];
+            mem2_ce_n = ~window[1];
+            swap_ce_n = (0 != window);
+            #2 read_n = 0;
+            #4 data = data_bus;
+            read_n = 1;
+            #2;
+            mem1_ce_n = 1;
+            mem2_ce_n = 1;
+            swap_ce_n = 1;
+        end
+    endtask
+
+    task check;
+        input [8*16:1] name;
+        input [7:0]    got;
+        input [7:0]    expected;
+        begin
+            checks = checks + 1;
+            if (got !== expected) begin
+                errors = errors + 1;
+                $display("%t: FAIL %0s: expected 0x%h, got 0x%h",
+                            $time, name, expected, got);
+            end
+        end
+    endtask
+    // }}}
+
+    integer n;
+    reg [7:0] rx;
+
+	initial begin
+		$dumpfile("mem_arb-test.vcd");
+		$dumpvars(0,test);
+
+        errors = 0;
+        checks = 0;
+
+        read_n = 1;
+        write_n = 1;
+        mem1_ce_n = 1;
+        mem2_ce_n = 1;
+        swap_ce_n = 1;
+        address_bus = 7'h00;
+        page = 13'h0003;
+
+        reset_n = 1;
+        #10 reset_n = 0;
+        #10 reset_n = 1;
+
+        bus_read(0, 7'h32, rx);
+        check("swap reset", rx, 8'h00);
+
+        // *** 1. windows ***
+        for (n = 0; n < 16; n = n + 1) begin
+            bus_write(1, n, 8'h10 + n);
+            bus_write(2, 7'h50 + n, 8'hA0 + n);
+        end
+        for (n = 0; n < 16; n = n + 1) begin
+            check("ram1", ram1.mem[3 * 16 + n], 8'h10 + n);
+            check("ram2", ram2.mem[3 * 16 + n], 8'hA0 + n);
+            bus_read(1, n, rx);
+            check("window 1", rx, 8'h10 + n);
+            bus_read(2, 7'h50 + n, rx);
+            check("window 2", rx, 8'hA0 + n);
+        end
+
+        // *** 2. ping-pong ***
+        bus_write(0, 7'h32, 8'h01);
+        bus_read(0, 7'h32, rx);
+        check("swap", rx, 8'h01);
+
+        for (n = 0; n < 16; n = n + 1) begin
+            // front buffer (now mem2) through window 1
+            bus_read(1, n, rx);
+            check("swapped read", rx, 8'hA0 + n);
+            // back buffer (now mem1) through window 2
+            bus_write(2, 7'h50 + n, 8'h30 + n);
+        end
+        for (n = 0; n < 16; n = n + 1) begin
+            check("ram1 swapped", ram1.mem[3 * 16 + n], 8'h30 + n);
+            check("ram2 swapped", ram2.mem[3 * 16 + n], 8'hA0 + n);
+        end
+
+        bus_write(0, 7'h32, 8'h00);
+        bus_read(1, 7'h05, rx);
+        check("unswapped", rx, 8'h35);
+
+        // the whole count, check() would compare only the low 8 bits
+        checks = checks + 1;
+        if (arb1.contentions != 0) begin
+            errors = errors + 1;
+            $display("FAIL contentions: %0d", arb1.contentions);
+        end
+
+        // *** 3. contention ***
+        // only window 1 (mem1) may be written
+        bus_write(3, 7'h07, 8'h77);
+        check("contention ram1", ram1.mem[3 * 16 + 7], 8'h77);
+        check("contention ram2", ram2.mem[3 * 16 + 7], 8'hA7);
+        if (0 == arb1.contentions) begin
+            errors = errors + 1;
+            $display("FAIL: contention was not detected");
+        end
+
+        if (0 == errors)
+            $display("PASS: %0d checks", checks);
+        else
+            $display("FAIL: %0d of %0d checks", errors, checks);
+
+		#10 $finish;
+	end
+
+endmodule
+
+// vim:foldmethod=marker
@@ -8,6 +8,7 @@ module test;
                 ce_n,
                 clk;
 	reg  [6:0]  address_bus;
+	reg  [12:0] page;
 	wire [7:0]  data_bus;
 
 	wire [7:0]  mem_data;
@@ -17,8 +18,8 @@ module test;
 	wire        we_n;
 	wire        oe_n;
 
-	mem_ctl mem1(read_n, write_n, ce_n, address_bus, data_bus, mem_data,
-                    mem_address, ceh_n, ce2, we_n, oe_n);
+	mem_ctl mem1(read_n, write_n, ce_n, address_bus, page, data_bus,
+                    mem_data, mem_address, ceh_n, ce2, we_n, oe_n);
 
 	reg [7:0] write_data_bus;
 	assign data_bus = (~(ce_n | write_n | ~read_n)) ? write_data_bus : 8'bz;
@@ -35,7 +36,8 @@ module test;
         read_n = 1'b1;
         ce_n = 1'b1;
         address_bus = 7'h00;
-        // (upper 9 bits are ignored, see mem_ctl.v)
+        page = 13'h0000;
+        // (upper 13 bits come from the page, see mem_ctl.v)
 
         // The time scale is larger throughout this section
         // because it is assumed that the clock speed (clk)
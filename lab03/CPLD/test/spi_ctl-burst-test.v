@@ -0,0 +1,135 @@
+/*
+ * NAME
+ * ----
+ *
+ *  spi_ctl-burst-test.v - burst mode test for 'spi_ctl.v'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench connects spi_ctl to a mem_ctl and a behavioral
+ * model of the AS6C1008 RAM (as6c1008.v).
+ * The decoder is left out and the mem_ctl is always enabled
+ * so that the whole 128 byte window can be reached.
+ *
+ * It performs a 64 byte burst write followed by a 64 byte
+ * burst read, each with a single NSS assertion.
+ * The values written are checked against the RAM model and
+ * the values read over MISO are checked against the values written.
+ *
+ * It is self checking, it uses the SPI master and scoreboard
+ * tasks in spi_tasks.v and ends with PASS or FAIL ('make' fails
+ * if it does not pass).
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`include "../spi_ctl.v"
+`include "../mem_ctl.v"
+`include "as6c1008.v"
+
+module test;
+
+    // number of bytes in each burst
+    parameter BURST = 64;
+    // starting address of each burst
+    parameter START = 7'h10;
+
+    reg         nss,
+                mosi,
+                sck;
+    wire        miso;
+    wire [6:0]  address_bus;
+    wire [7:0]  data_bus;
+    wire        read_n,
+                write_n;
+
+    reg         ce_n;
+
+    wire [7:0]  mem_data;
+    wire [16:0] mem_address;
+    wire        ceh_n,
+                ce2,
+                we_n,
+                oe_n;
+
+    spi_ctl s1(nss, mosi, sck, miso, address_bus, data_bus, read_n, write_n);
+
+    // Use the upper address bits as the page so that the RAM
+    // sees one linear 128 byte window (see page_ctl.v).
+    wire [12:0] page;
+    assign page = {10'b0, address_bus[6:4]};
+
+    mem_ctl mem1(read_n, write_n, ce_n, address_bus, page, data_bus,
+                mem_data, mem_address, ceh_n, ce2, we_n, oe_n);
+
+    as6c1008 ram1(mem_address, mem_data, ceh_n, ce2, we_n, oe_n);
+
+    integer n;
+    integer errors;
+    integer checks;
+
+    `include "spi_tasks.v"
+
+    reg [7:0] rx;
+
+    // value written to the n'th address of a burst
+    function [7:0] pattern;
+        input integer k;
+        pattern = (k * 37 + 8'h5A) & 8'hFF;
+    endfunction
+
+	initial begin
+		$dumpfile("spi_ctl-burst-test.vcd");
+		$dumpvars(0,test);
+
+        errors = 0;
+        checks = 0;
+
+		sck     = 0;
+		mosi    = 0;
+		nss     = 1;  // disabled
+        ce_n    = 0;  // always enabled
+
+        #2;
+
+        // *** BURST WRITE ***
+
+		#1 nss = 0; // enabled
+
+        spi_byte({1'b0, START}, rx); // WRITE address START
+
+        for (n = 0; n < BURST; n = n + 1)
+            spi_byte(pattern(n), rx);
+
+		#1 nss = 1; // disabled
+
+        #1;
+        for (n = 0; n < BURST; n = n + 1)
+            check("burst write", ram1.mem[START + n], pattern(n));
+
+        // *** BURST READ ***
+
+		#1 nss = 0; // enabled
+
+        spi_byte({1'b1, START}, rx); // READ address START
+
+        for (n = 0; n < BURST; n = n + 1) begin
+            spi_byte(8'h00, rx);  // form feed
+            check("burst read", rx, pattern(n));
+        end
+
+		#1 nss = 1; // disabled
+
+        report;
+
+		#3 $finish;
+	end
+
+endmodule
+
+// vim:foldmethod=marker
@@ -0,0 +1,156 @@
+/*
+ * NAME
+ * ----
+ *
+ *  spi_ctl-pipeline-test.v - pipelined read test for 'spi_ctl.v'
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This test bench connects spi_ctl to a mem_ctl and a behavioral
+ * model of the AS6C1008 RAM (as6c1008.v), which is loaded
+ * with a known pattern.
+ *
+ * A series of reads from random addresses is performed twice.
+ * First using the two byte protocol (command, form feed) with
+ * one NSS assertion per read.
+ * Then using pipelined reads where the next read command is
+ * sent while the previous data is shifted out, all with a single
+ * NSS assertion.
+ *
+ * The values read are checked against the RAM model and the
+ * number of bytes on the wire per read is displayed for each.
+ * It uses the SPI master and scoreboard tasks in spi_tasks.v
+ * and ends with PASS or FAIL ('make' fails if it does not pass).
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`include "../spi_ctl.v"
+`include "../mem_ctl.v"
+`include "as6c1008.v"
+
+module test;
+
+    // number of reads
+    parameter N = 32;
+
+    reg         nss,
+                mosi,
+                sck;
+    wire        miso;
+    wire [6:0]  address_bus;
+    wire [7:0]  data_bus;
+    wire        read_n,
+                write_n;
+
+    reg         ce_n;
+
+    wire [7:0]  mem_data;
+    wire [16:0] mem_address;
+    wire        ceh_n,
+                ce2,
+                we_n,
+                oe_n;
+
+    spi_ctl s1(nss, mosi, sck, miso, address_bus, data_bus, read_n, write_n);
+
+    // Use the upper address bits as the page so that the RAM
+    // sees one linear 128 byte window (see page_ctl.v).
+    wire [12:0] page;
+    assign page = {10'b0, address_bus[6:4]};
+
+    mem_ctl mem1(read_n, write_n, ce_n, address_bus, page, data_bus,
+                mem_data, mem_address, ceh_n, ce2, we_n, oe_n);
+
+    as6c1008 ram1(mem_address, mem_data, ceh_n, ce2, we_n, oe_n);
+
+    // addresses to read
+    reg [6:0] addrs [0:N-1];
+
+    integer n;
+    integer seed;
+    integer errors;
+    integer checks;
+    // bytes on the wire
+    integer bytes;
+
+    `include "spi_tasks.v"
+
+    reg [7:0] rx;
+
+	initial begin
+		$dumpfile("spi_ctl-pipeline-test.vcd");
+		$dumpvars(0,test);
+
+        errors = 0;
+        checks = 0;
+        seed   = 344;
+
+		sck     = 0;
+		mosi    = 0;
+		nss     = 1;  // disabled
+        ce_n    = 0;  // always enabled
+
+        for (n = 0; n < 128; n = n + 1)
+            ram1.mem[n] = (n * 37 + 8'h5A) & 8'hFF;
+
+        for (n = 0; n < N; n = n + 1)
+            addrs[n] = $random(seed);
+
+        #2;
+
+        // *** TWO BYTE READS ***
+
+        bytes = 0;
+        for (n = 0; n < N; n = n + 1) begin
+		    #1 nss = 0; // enabled
+
+            spi_byte({1'b1, addrs[n]}, rx);  // READ
+            spi_byte(8'h00, rx);  // form feed
+
+		    #1 nss = 1; // disabled
+
+            bytes = bytes + 2;
+            check("read", rx, ram1.mem[addrs[n]]);
+        end
+
+        $display("two byte reads: %0d bytes for %0d reads, %0d.%02d bytes/read",
+                    bytes, N, bytes / N, (bytes * 100 / N) % 100);
+
+        // *** PIPELINED READS ***
+
+        bytes = 0;
+		#1 nss = 0; // enabled
+
+        spi_byte({1'b1, addrs[0]}, rx);  // READ
+        bytes = bytes + 1;
+
+        for (n = 1; n <= N; n = n + 1) begin
+            // next read command, or a form feed after the last one
+            if (n < N)
+                spi_byte({1'b1, addrs[n]}, rx);
+            else
+                spi_byte(8'h00, rx);
+
+            bytes = bytes + 1;
+            check("pipelined read", rx, ram1.mem[addrs[n - 1]]);
+        end
+
+		#1 nss = 1; // disabled
+
+        $display("pipelined reads: %0d bytes for %0d reads, %0d.%02d bytes/read",
+                    bytes, N, bytes / N, (bytes * 100 / N) % 100);
+
+        report;
+
+		#3 $finish;
+	end
+
+endmodule
+
+// vim:foldmethod=marker
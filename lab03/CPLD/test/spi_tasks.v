@@ -0,0 +1,155 @@
+/*
+ * NAME
+ * ----
+ *
+ *  spi_tasks.v - SPI master and scoreboard tasks for test benches
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * This file is meant to be included INSIDE of a test module
+ * (`include "spi_tasks.v") which declares the following.
+ *
+ *   reg  sck, nss, mosi;   // connected to the slave
+ *   wire miso;
+ *   integer errors;        // number of failed checks
+ *   integer checks;        // number of checks performed
+ *
+ * The time unit for each half SCK cycle is given by SPI_DELAY
+ * which may be defined before including this file.
+ *
+ * SPI settings, same as spi_ctl.v:
+ *
+ *   MSB first
+ *   CPOL = 0
+ *   CPHA = 0
+ *   SS_L (enable on low)
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  reg [7:0] val;
+ *
+ *  spi_write(7'h6C, 8'h3D);          // write bar leds
+ *  spi_read(7'h6C, val);             // read them back
+ *  check("bar leds", val, 8'h3D);    // scoreboard
+ *
+ *  report;  // display PASS/FAIL summary
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+`ifndef SPI_DELAY
+`define SPI_DELAY 10
+`endif
+
+// {{{ spi_byte()
+/*
+ * spi_byte(tx, rx)
+ *
+ * Perform a single 8-bit SPI cycle.
+ * 'tx' is sent on mosi and the byte received on miso is
+ * returned in 'rx'.
+ *
+ * It does not mutate nss, this is left to the controlling
+ * block.
+ */
+task spi_byte;
+    input  [7:0] tx;
+    output [7:0] rx;
+    integer k;
+    begin
+        for (k = 7; k >= 0; k = k - 1) begin
+            mosi = tx[k];
+            #`SPI_DELAY;
+            // sample
+            sck = 1;
+            rx = {rx[6:0], miso};
+            #`SPI_DELAY;
+            // propagate
+            sck = 0;
+        end
+    end
+endtask
+// }}}
+
+// {{{ spi_write(), spi_read()
+/*
+ * spi_write(addr, data)
+ *
+ * Write 'data' to bus address 'addr' (two byte transaction).
+ */
+task spi_write;
+    input [6:0] addr;
+    input [7:0] data;
+    reg   [7:0] rx;
+    begin
+        #`SPI_DELAY nss = 0; // enable
+
+        spi_byte({1'b0, addr}, rx);
+        spi_byte(data, rx);
+
+        #`SPI_DELAY nss = 1; // disable
+    end
+endtask
+
+/*
+ * spi_read(addr, data)
+ *
+ * Read bus address 'addr' in to 'data' (two byte transaction).
+ */
+task spi_read;
+    input  [6:0] addr;
+    output [7:0] data;
+    reg    [7:0] rx;
+    begin
+        #`SPI_DELAY nss = 0; // enable
+
+        spi_byte({1'b1, addr}, rx);
+        spi_byte(8'h00, data);  // form feed
+
+        #`SPI_DELAY nss = 1; // disable
+    end
+endtask
+// }}}
+
+// {{{ check(), report()
+/*
+ * check(name, got, expected)
+ *
+ * Compare a value with the expected one and count any error.
+ */
+task check;
+    input [8*16:1] name;
+    input [7:0]    got;
+    input [7:0]    expected;
+    begin
+        checks = checks + 1;
+        if (got !== expected) begin
+            errors = errors + 1;
+            $display("%t: FAIL %0s: expected 0x%h, got 0x%h",
+                        $time, name, expected, got);
+        end
+    end
+endtask
+
+/*
+ * report
+ *
+ * Display the summary.  The Makefile looks for the PASS line.
+ */
+task report;
+    begin
+        if (0 == errors)
+            $display("PASS: %0d checks", checks);
+        else
+            $display("FAIL: %0d of %0d checks", errors, checks);
+    end
+endtask
+// }}}
+
+// vim:foldmethod=marker
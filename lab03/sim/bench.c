@@ -0,0 +1,279 @@
+/*
+ * NAME
+ * ----
+ *
+ * bench.c - bus protocol benchmark using the CPLD model
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./bench [number of operations]
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Random bus operations (reads and writes of the LEDs, switches,
+ * page and swap registers and both RAM windows) are performed through the ARM cpld_bus
+ * module, which is linked against the CPLD model instead of the
+ * SPI hardware (spi_dma_model.c).
+ *
+ * The same operations are performed one at a time
+ * (cpld_read()/cpld_write()) and in batches (cpld_batch()).
+ * Every value read is checked against a reference model that is
+ * accessed directly through the bus, and the final state of
+ * both is compared.
+ *
+ * For each protocol variant the number of operations per second,
+ * SPI bytes per operation and NSS assertions per operation are
+ * displayed.
+ *
+ * Then random blocks are copied to and from both RAM chips
+ * with cpld_mem_write() and cpld_mem_read() and checked against
+ * the RAM of the model, and the copy rate is displayed.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "cpld_model.h"
+#include "cpld_bus.h"
+#include "spi_dma.h"
+
+extern cpld_model *spi_dma_model;
+extern unsigned long spi_dma_xfers;
+
+static cpld_model dut;
+static cpld_model ref;
+
+static unsigned long errors;
+
+// {{{ random_op()
+/*
+ * random_op()
+ *
+ * Fill in a random operation on one of the bus devices.
+ * Memory accesses are often sequential so that bursts occur.
+ */
+static void random_op(cpld_op *op, const cpld_op *prev) {
+    unsigned int r = rand();
+
+    if (prev && (r % 2) && (prev->addr & 0x0F) != 0x0F
+            && (CPLD_MEM1 == (prev->addr & 0x70)
+                || CPLD_MEM2 == (prev->addr & 0x70))) {
+        // next memory address, same direction
+        op->addr = prev->addr + 1;
+        op->rw = prev->rw;
+    } else {
+        switch ((r >> 1) % 6) {
+            case 0: op->addr = CPLD_SWITCHES; break;
+            case 1: op->addr = CPLD_BAR_LEDS; break;
+            case 2: op->addr = CPLD_BOARD_LEDS; break;
+            case 3: op->addr = CPLD_MEM1 + ((r >> 4) & 0x0F); break;
+            case 4: op->addr = CPLD_MEM2 + ((r >> 4) & 0x0F); break;
+            default:
+                switch ((r >> 4) % 3) {
+                    case 0: op->addr = CPLD_PAGE_LO; break;
+                    case 1: op->addr = CPLD_PAGE_HI; break;
+                    default: op->addr = CPLD_MEM_SWAP; break;
+                }
+                break;
+        }
+        op->rw = ((r >> 8) % 2) ? CPLD_READ : CPLD_WRITE;
+    }
+
+    if (CPLD_SWITCHES == op->addr)
+        op->rw = CPLD_READ;
+
+    op->data = (CPLD_WRITE == op->rw) ? (r >> 12) & 0xFF : 0x00;
+}
+// }}}
+
+// {{{ check()
+/*
+ * check()
+ *
+ * Apply the operations to the reference model and check
+ * the values that were read.
+ */
+static void check(const cpld_op *ops, unsigned int n) {
+    unsigned int i;
+    uint8_t expect;
+
+    for (i = 0; i < n; i++) {
+        if (CPLD_READ == ops[i].rw) {
+            expect = cpld_model_bus_read(&ref, ops[i].addr);
+            if (expect != ops[i].data) {
+                if (errors < 10)
+                    fprintf(stderr, "READ 0x%.2x: expected 0x%.2x, got 0x%.2x\n",
+                            ops[i].addr, expect, ops[i].data);
+                errors++;
+            }
+        } else {
+            cpld_model_bus_write(&ref, ops[i].addr, ops[i].data);
+        }
+    }
+}
+// }}}
+
+// {{{ run()
+/*
+ * run()
+ *
+ * Perform 'n' random operations, in batches of 'batch'
+ * (or one at a time if 'batch' is 0) and display the results.
+ */
+static void run(const char *name, unsigned long n, unsigned int batch) {
+    cpld_op ops[CPLD_BATCH_MAX];
+    unsigned long done;
+    unsigned int m;
+    unsigned int i;
+    struct timespec t0, t1;
+    double secs;
+
+    cpld_model_init(&dut);
+    cpld_model_init(&ref);
+    dut.switches = ref.switches = (uint8_t) ~0xA5;
+
+    spi_dma_model = &dut;
+    configure_SPI_DMA();
+
+    srand(344);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (done = 0; done < n; done += m) {
+        m = batch ? batch : 1;
+        if (m > n - done)
+            m = n - done;
+
+        for (i = 0; i < m; i++)
+            random_op(&ops[i], i ? &ops[i - 1] : 0);
+
+        if (batch) {
+            cpld_batch(ops, m);
+        } else if (CPLD_READ == ops[0].rw) {
+            ops[0].data = cpld_read(ops[0].addr);
+        } else {
+            cpld_write(ops[0].addr, ops[0].data);
+        }
+
+        check(ops, m);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    if (dut.bar_leds != ref.bar_leds || dut.board_leds != ref.board_leds
+            || dut.page != ref.page || dut.swap != ref.swap
+            || memcmp(dut.mem1, ref.mem1, sizeof(dut.mem1))
+            || memcmp(dut.mem2, ref.mem2, sizeof(dut.mem2))) {
+        fprintf(stderr, "%s: final state differs from the reference\n", name);
+        errors++;
+    }
+
+    printf("%-10s %10lu ops %12.0f ops/s %6.2f bytes/op %6.2f NSS/op\n",
+            name, n, n / secs,
+            (double) dut.bytes / n, (double) spi_dma_xfers / n);
+}
+// }}}
+
+// {{{ copy()
+/*
+ * copy()
+ *
+ * Copy random blocks, totaling at least 'n' bytes, to and from
+ * random places in both RAM chips and display the results.
+ */
+static void copy(unsigned long n) {
+    static uint8_t in[CPLD_MEM_SIZE];
+    static uint8_t out[CPLD_MEM_SIZE];
+    unsigned long done;
+    unsigned int len;
+    uint32_t offset;
+    uint8_t mem;
+    unsigned int i;
+    struct timespec t0, t1;
+    double secs;
+
+    cpld_model_init(&dut);
+
+    spi_dma_model = &dut;
+    configure_SPI_DMA();
+
+    srand(344);
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (done = 0; done < n; done += len) {
+        mem = (rand() % 2) ? CPLD_MEM2 : CPLD_MEM1;
+        len = 1 + rand() % 4096;
+        offset = rand() % (CPLD_MEM_SIZE - len + 1);
+
+        for (i = 0; i < len; i++)
+            in[i] = rand();
+
+        cpld_mem_write(mem, offset, in, len);
+
+        if (memcmp(((CPLD_MEM1 == mem) ? dut.mem1 : dut.mem2) + offset, in, len)) {
+            if (errors < 10)
+                fprintf(stderr, "WRITE 0x%.2x 0x%.5x, %u bytes: wrong RAM contents\n",
+                        mem, offset, len);
+            errors++;
+        }
+
+        cpld_mem_read(mem, offset, out, len);
+
+        if (memcmp(out, in, len)) {
+            if (errors < 10)
+                fprintf(stderr, "READ 0x%.2x 0x%.5x, %u bytes: wrong values read\n",
+                        mem, offset, len);
+            errors++;
+        }
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) / 1e9;
+
+    // each byte was both written and read
+    printf("%-10s %10lu bytes %10.0f bytes/s %6.2f SPI bytes/byte\n",
+            "copy", 2 * done, 2 * done / secs, (double) dut.bytes / (2 * done));
+}
+// }}}
+
+int main(int argc, char *argv[]) {
+    unsigned long n = 1000000;
+
+    if (argc > 1)
+        n = strtoul(argv[1], 0, 0);
+
+    if (0 == n)
+        n = 1;
+
+    run("single", n, 0);
+    run("batch-8", n, 8);
+    run("batch-32", n, CPLD_BATCH_MAX);
+    copy(n);
+
+    if (errors) {
+        printf("FAIL: %lu errors\n", errors);
+        return 1;
+    }
+
+    printf("PASS\n");
+
+    return 0;
+}
+
+// vim:foldmethod=marker
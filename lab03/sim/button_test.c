@@ -0,0 +1,238 @@
+/*
+ * NAME
+ * ----
+ *
+ * button_test.c - test of the button debouncing and events
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./button_test
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The ARM button event code (../ARM/button_event.c) is run
+ * against a simulated comparator output and debounce timer,
+ * with time counted in milliseconds.
+ *
+ * Edges of the comparator output are injected (clean ones,
+ * bouncing ones and short glitches) and the events that come
+ * out of the queue are checked for their type, order and the
+ * time at which they appear.  The queue is also filled up, the
+ * events taken out must still alternate after some are dropped.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "button_event.h"
+
+static long now;            // simulated time, ms
+static long deadline = -1;  // debounce timer expiry, -1 stopped
+static int level;           // comparator output
+
+static unsigned long errors;
+static unsigned long checks;
+
+// {{{ simulated hardware
+/*
+ * button_timer_start()
+ *
+ * Replaces the TIM6 version in button.c.
+ */
+void button_timer_start(unsigned int ms) {
+    deadline = now + ms;
+}
+
+/*
+ * set_level()
+ *
+ * Change the comparator output, an edge interrupt occurs if
+ * it changed.
+ */
+static void set_level(int l) {
+    if (l != level) {
+        level = l;
+        button_event_edge();
+    }
+}
+
+/*
+ * run_until()
+ *
+ * Advance the time to 't', the timer interrupt occurs
+ * when it expires.
+ */
+static void run_until(long t) {
+    while (now < t) {
+        now++;
+        if (deadline == now) {
+            deadline = -1;
+            button_event_timeout(level);
+        }
+    }
+}
+// }}}
+
+// {{{ checks
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %ld, got %ld\n", name, expected, got);
+        errors++;
+    }
+}
+
+/*
+ * expect_event()
+ *
+ * Run until 'when' checking that there is no event before it,
+ * and that 'event' is the next one at that time.
+ */
+static void expect_event(const char *name, int event, long when) {
+    while (now < when) {
+        check(name, button_get_event(), BUTTON_NONE);
+        run_until(now + 1);
+    }
+    check(name, button_get_event(), event);
+}
+
+/*
+ * bounce()
+ *
+ * 'n' edges 1 ms apart ending at level 'l', returns the
+ * time of the last one.
+ */
+static long bounce(int l, int n) {
+    int i;
+
+    for (i = 0; i < n; i++) {
+        set_level((n - i) % 2 ? l : ! l);
+        run_until(now + 1);
+    }
+
+    return now - 1;
+}
+// }}}
+
+int main() {
+    long last;
+    int i;
+    int n;
+    int event;
+    int last_event;
+
+    level = 0;
+    button_event_init(0);
+
+    // clean press and release
+    run_until(100);
+    set_level(1);
+    expect_event("clean press", BUTTON_DOWN, 100 + BUTTON_DEBOUNCE_MS);
+    run_until(300);
+    set_level(0);
+    expect_event("clean release", BUTTON_UP, 300 + BUTTON_DEBOUNCE_MS);
+
+    // bouncing press and release, the event follows the last edge
+    run_until(1000);
+    last = bounce(1, 5);
+    expect_event("bounce press", BUTTON_DOWN, last + BUTTON_DEBOUNCE_MS);
+    run_until(1500);
+    last = bounce(0, 7);
+    expect_event("bounce release", BUTTON_UP, last + BUTTON_DEBOUNCE_MS);
+
+    // a glitch that returns to the same level
+    run_until(2000);
+    set_level(1);
+    run_until(2005);
+    set_level(0);
+    expect_event("glitch", BUTTON_NONE, 2100);
+
+    // noise faster than the debounce time never settles
+    run_until(3000);
+    for (i = 0; i < 10; i++) {
+        set_level(! level);
+        run_until(now + BUTTON_DEBOUNCE_MS - 1);
+        check("noise", button_get_event(), BUTTON_NONE);
+    }
+    set_level(1);
+    expect_event("after noise", BUTTON_DOWN, now + BUTTON_DEBOUNCE_MS);
+    set_level(0);
+    expect_event("after noise", BUTTON_UP, now + BUTTON_DEBOUNCE_MS);
+
+    // random presses, events come out in order
+    srand(344);
+    for (i = 0; i < 1000; i++) {
+        run_until(now + 1 + rand() % 100);
+        n = 1 + 2 * (rand() % 4);
+        last = bounce(! level, n);
+        expect_event("random", level ? BUTTON_DOWN : BUTTON_UP,
+                        last + BUTTON_DEBOUNCE_MS);
+    }
+    run_until(now + 100);
+    check("random, dropped", button_event_dropped(), 0);
+
+    // queue overflow, the oldest events are kept
+    button_event_init(0);
+    for (i = 0; i < 10; i++) {
+        set_level(1);
+        run_until(now + 2 * BUTTON_DEBOUNCE_MS);
+        set_level(0);
+        run_until(now + 2 * BUTTON_DEBOUNCE_MS);
+    }
+    for (i = 0; i < BUTTON_QUEUE_LEN - 1; i++) {
+        event = button_get_event();
+        check("overflow order", event, (i % 2) ? BUTTON_UP : BUTTON_DOWN);
+    }
+    check("overflow empty", button_get_event(), BUTTON_NONE);
+    // the releases while it was full, the presses then did not change it
+    check("overflow dropped", button_event_dropped(),
+            10 - (BUTTON_QUEUE_LEN - 1) / 2);
+
+    // after a drop the events still alternate, never DOWN, DOWN
+    last_event = BUTTON_DOWN;
+    for (i = 0; i < 100; i++) {
+        run_until(now + 1 + rand() % 100);
+        set_level(! level);
+        run_until(now + 2 * BUTTON_DEBOUNCE_MS);
+        // fill it up now and then
+        if (rand() % 4)
+            continue;
+        while (BUTTON_NONE != (event = button_get_event())) {
+            check("overflow alternate", event != last_event, 1);
+            last_event = event;
+        }
+    }
+    while (BUTTON_NONE != (event = button_get_event())) {
+        check("overflow alternate", event != last_event, 1);
+        last_event = event;
+    }
+    // with room again the next change is the level
+    set_level(! level);
+    run_until(now + 2 * BUTTON_DEBOUNCE_MS);
+    event = button_get_event();
+    check("overflow alternate", event != last_event, 1);
+    check("overflow level", event, level ? BUTTON_DOWN : BUTTON_UP);
+    check("overflow dropped again", button_event_dropped() > 10 - (BUTTON_QUEUE_LEN - 1) / 2, 1);
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,23 @@
+/*
+ * Host stand-in for the CMSIS core_cmFunc.h.
+ *
+ * The ARM sources built with the real device header for the
+ * register model (spi_dma.c) mask the interrupts with the
+ * intrinsics of core_cmFunc.h, which are Cortex-M3 instructions.
+ * This file is included first (-include cmfunc_model.h), its
+ * guard keeps core_cmFunc.h out, and PRIMASK is a variable
+ * which the test can set and check.
+ */
+#ifndef __CORE_CMFUNC_H
+#define __CORE_CMFUNC_H
+
+#include <stdint.h>
+
+extern uint32_t cmfunc_primask;
+
+static inline uint32_t __get_PRIMASK(void) { return cmfunc_primask; }
+static inline void __set_PRIMASK(uint32_t primask) { cmfunc_primask = primask & 1; }
+static inline void __disable_irq(void) { cmfunc_primask = 1; }
+static inline void __enable_irq(void) { cmfunc_primask = 0; }
+
+#endif
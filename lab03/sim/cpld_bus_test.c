@@ -0,0 +1,486 @@
+/*
+ * NAME
+ * ----
+ *
+ * cpld_bus_test.c - unit tests of cpld_bus.c on a stub DMA engine
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./cpld_bus_test
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The ARM bus code (../ARM/cpld_bus.c) is linked against a stub of
+ * the DMA engine (spi_dma.h) defined here instead of spi_dma_model.c.
+ * The stub exchanges the bytes of each transaction (frame) with the
+ * CPLD model (cpld_model.c) as it is submitted, in order, but
+ *
+ *  - it holds at most 'stub_queue' frames, and may also refuse
+ *    one at random as if other frames filled the queue, in both
+ *    cases SPI_DMA_submit() returns 0 (full)
+ *
+ *  - the received bytes are only stored, and 'done' set, when a
+ *    frame completes, and the frames complete in a random order
+ *    when SPI_DMA_wait() is called
+ *
+ * So the retry and wait of batch() for a full queue are run, and
+ * the values read must come from the right frames once all of
+ * them are done.
+ *
+ * The packing of the operations in to frames is checked for
+ * fixed cases, pipelined read runs, bursts of consecutive writes
+ * and the split between them, along with the value of each
+ * read (rx_pos).  Then random batches, longer than CPLD_BATCH_MAX,
+ * are run for several queue sizes and every value read is checked
+ * against a reference model accessed directly through its address
+ * map (cpld_model_bus_read(), cpld_model_bus_write()).  The
+ * form of every frame is checked, the read commands have the rw
+ * bit set and are followed by a form feed with it clear.
+ *
+ * The bytes of a single operation from cpld_op_bytes(), which
+ * ../ARM/main.c submits itself, are checked for every address,
+ * rw and data, the second byte of a read must be a form feed
+ * whatever the data left in the operation.  They are also run
+ * through the CPLD model and compared with the reference.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cpld_model.h"
+#include "cpld_bus.h"
+#include "spi_dma.h"
+
+#define RANDOM_BATCHES  2000
+#define MAX_OPS         (3 * CPLD_BATCH_MAX)
+#define MAX_FRAME       (2 * CPLD_BATCH_MAX)
+#define MAX_LOG         (2 * MAX_OPS)
+
+static cpld_model dut;
+static cpld_model ref;
+
+static unsigned long errors;
+static unsigned long checks;
+
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected 0x%lx, got 0x%lx\n",
+                    name, expected, got);
+        errors++;
+    }
+}
+
+// {{{ stub DMA
+static unsigned int stub_queue = SPI_DMA_QUEUE_LEN - 1;
+// one in 'stub_refuse' submits is refused, 0 never
+static unsigned int stub_refuse;
+
+static unsigned long stub_full;
+static unsigned long stub_out_of_order;
+
+// frames submitted and not yet done, oldest first
+static struct {
+    SPI_DMA_xfer *xfer;
+    uint8_t rx[MAX_FRAME];
+} pending[SPI_DMA_QUEUE_LEN];
+static unsigned int npending;
+
+// the bytes of each frame sent since stub_clear()
+static uint8_t frame[MAX_LOG][MAX_FRAME];
+static uint16_t frame_len[MAX_LOG];
+static unsigned int nframes;
+
+static void stub_clear() {
+    nframes = 0;
+}
+
+void configure_SPI_DMA() {
+}
+
+int SPI_DMA_submit(SPI_DMA_xfer *xfer, const uint8_t *tx, uint8_t *rx,
+                    uint16_t n, void (*callback)(SPI_DMA_xfer *)) {
+    uint16_t i;
+
+    if (0 == n)
+        return 0;
+
+    if (npending >= stub_queue
+            || (stub_refuse && 0 == rand() % stub_refuse)) {
+        stub_full++;
+        return 0;
+    }
+
+    check("frame size", n <= MAX_FRAME, 1);
+    if (n > MAX_FRAME)
+        return 0;
+
+    xfer->tx = tx;
+    xfer->rx = rx;
+    xfer->n = n;
+    xfer->callback = callback;
+    xfer->done = 0;
+
+    if (nframes < MAX_LOG) {
+        memcpy(frame[nframes], tx, n);
+        frame_len[nframes] = n;
+    }
+    nframes++;
+
+    // on the wire in order, the bytes received are held until done
+    cpld_model_nss(&dut, 0);
+    for (i = 0; i < n; i++)
+        pending[npending].rx[i] = cpld_model_xfer(&dut, tx[i]);
+    cpld_model_nss(&dut, 1);
+
+    pending[npending].xfer = xfer;
+    npending++;
+
+    return 1;
+}
+
+// complete pending frame 'k'
+static void complete(unsigned int k) {
+    SPI_DMA_xfer *xfer = pending[k].xfer;
+
+    if (k != 0)
+        stub_out_of_order++;
+
+    if (xfer->rx)
+        memcpy(xfer->rx, pending[k].rx, xfer->n);
+
+    npending--;
+    memmove(&pending[k], &pending[k + 1], (npending - k) * sizeof(pending[0]));
+
+    xfer->done = 1;
+    if (xfer->callback)
+        xfer->callback(xfer);
+}
+
+void SPI_DMA_wait(SPI_DMA_xfer *xfer) {
+    while (! xfer->done) {
+        if (0 == npending) {
+            check("wait submitted", 0, 1);
+            return;
+        }
+        complete(rand() % npending);
+    }
+}
+
+unsigned int SPI_DMA_busy() {
+    return npending;
+}
+// }}}
+
+// {{{ reference
+/*
+ * check_ops()
+ *
+ * Apply the operations to the reference model and check
+ * the values that were read.
+ */
+static void check_ops(const char *name, const cpld_op *ops, unsigned int n) {
+    unsigned int i;
+
+    for (i = 0; i < n; i++) {
+        if (CPLD_READ == ops[i].rw)
+            check(name, ops[i].data, cpld_model_bus_read(&ref, ops[i].addr));
+        else
+            cpld_model_bus_write(&ref, ops[i].addr, ops[i].data);
+    }
+}
+
+/*
+ * check_frames()
+ *
+ * Each frame is either pipelined reads, commands with the rw bit
+ * set ended by a form feed with it clear, or a burst write.
+ */
+static void check_frames(const char *name) {
+    unsigned int f;
+    unsigned int i;
+
+    for (f = 0; f < nframes && f < MAX_LOG; f++) {
+        if (frame[f][0] & CPLD_RW_BIT) {
+            for (i = 1; i < frame_len[f] - 1U; i++)
+                check(name, frame[f][i] & CPLD_RW_BIT, CPLD_RW_BIT);
+            check(name, frame_len[f] >= 2, 1);
+            check(name, frame[f][frame_len[f] - 1], 0x00);
+        } else {
+            check(name, frame_len[f] >= 2, 1);
+        }
+    }
+}
+
+static void reset_models() {
+    unsigned int i;
+
+    cpld_model_init(&dut);
+    for (i = 0; i < sizeof(dut.mem1); i++) {
+        dut.mem1[i] = i * 7 + 1;
+        dut.mem2[i] = i * 13 + 5;
+    }
+    dut.switches = (uint8_t) ~0xC5;
+    memcpy(&ref, &dut, sizeof(dut));
+}
+// }}}
+
+// {{{ packing
+#define R(a)    {(a), CPLD_READ, 0x00}
+#define W(a, d) {(a), CPLD_WRITE, (d)}
+
+static const struct {
+    const char *name;
+    unsigned int n;
+    cpld_op ops[8];
+    // frames, each is its length then its bytes
+    uint8_t frames[32];
+} cases[] = {
+    {"read", 1, {R(CPLD_SWITCHES)},
+        {2, 0xF4, 0x00}},
+    {"write", 1, {W(CPLD_BAR_LEDS, 0x3C)},
+        {2, 0x6C, 0x3C}},
+    {"pipelined reads", 3, {R(CPLD_SWITCHES), R(CPLD_MEM1 + 3), R(CPLD_BAR_LEDS)},
+        {4, 0xF4, 0x83, 0xEC, 0x00}},
+    {"burst", 4, {W(CPLD_MEM2, 0x11), W(CPLD_MEM2 + 1, 0x22),
+                    W(CPLD_MEM2 + 2, 0x33), W(CPLD_MEM2 + 3, 0x44)},
+        {5, 0x50, 0x11, 0x22, 0x33, 0x44}},
+    {"not consecutive", 3, {W(CPLD_MEM2, 0x01), W(CPLD_MEM2 + 2, 0x02),
+                    W(CPLD_MEM2 + 1, 0x03)},
+        {2, 0x50, 0x01, 2, 0x52, 0x02, 2, 0x51, 0x03}},
+    {"wraps", 2, {W(0x7F, 0x01), W(0x00, 0x02)},
+        {3, 0x7F, 0x01, 0x02}},
+    {"mixed", 6, {R(CPLD_SWITCHES), R(CPLD_MEM1 + 5), W(CPLD_MEM1 + 6, 0xAA),
+                    W(CPLD_MEM1 + 7, 0xBB), R(CPLD_BAR_LEDS),
+                    W(CPLD_BOARD_LEDS, 0x0F)},
+        {3, 0xF4, 0x85, 0x00, 3, 0x06, 0xAA, 0xBB, 2, 0xEC, 0x00,
+            2, 0x2F, 0x0F}},
+    {"read back", 4, {W(CPLD_MEM1 + 3, 0x5A), R(CPLD_MEM1 + 3),
+                    W(CPLD_PAGE_LO, 0x12), R(CPLD_PAGE_LO)},
+        {2, 0x03, 0x5A, 2, 0x83, 0x00, 2, 0x30, 0x12, 2, 0xB0, 0x00}},
+};
+#define NCASES (sizeof(cases) / sizeof(cases[0]))
+
+static void check_packing() {
+    cpld_op ops[8];
+    unsigned int c;
+    unsigned int f;
+    unsigned int pos;
+    unsigned int len;
+    unsigned int i;
+
+    for (c = 0; c < NCASES; c++) {
+        reset_models();
+        stub_clear();
+        memcpy(ops, cases[c].ops, sizeof(ops));
+        // stale values must be replaced
+        for (i = 0; i < cases[c].n; i++) {
+            if (CPLD_READ == ops[i].rw)
+                ops[i].data = 0xEE;
+        }
+
+        cpld_batch(ops, cases[c].n);
+        check_ops(cases[c].name, ops, cases[c].n);
+
+        pos = 0;
+        for (f = 0; cases[c].frames[pos]; f++) {
+            len = cases[c].frames[pos++];
+            if (f >= nframes) {
+                check(cases[c].name, nframes, f + 1);
+                break;
+            }
+            check(cases[c].name, frame_len[f], len);
+            for (i = 0; i < len && i < frame_len[f]; i++)
+                check(cases[c].name, frame[f][i], cases[c].frames[pos + i]);
+            pos += len;
+        }
+        check(cases[c].name, nframes, f);
+    }
+}
+// }}}
+
+// {{{ random
+/*
+ * random_op()
+ *
+ * A random operation on one of the bus devices, memory accesses
+ * often follow the one before so that bursts occur.
+ */
+static void random_op(cpld_op *op, const cpld_op *prev) {
+    unsigned int r = rand();
+
+    if (prev && (r % 2) && (prev->addr & 0x0F) != 0x0F
+            && (CPLD_MEM1 == (prev->addr & 0x70)
+                || CPLD_MEM2 == (prev->addr & 0x70))) {
+        op->addr = prev->addr + 1;
+        op->rw = prev->rw;
+    } else {
+        switch ((r >> 1) % 7) {
+            case 0: op->addr = CPLD_SWITCHES; break;
+            case 1: op->addr = CPLD_BAR_LEDS; break;
+            case 2: op->addr = CPLD_BOARD_LEDS; break;
+            case 3: op->addr = CPLD_MEM1 + ((r >> 4) & 0x0F); break;
+            case 4: op->addr = CPLD_MEM2 + ((r >> 4) & 0x0F); break;
+            case 5: op->addr = CPLD_PAGE_LO; break;
+            default: op->addr = CPLD_MEM_SWAP; break;
+        }
+        op->rw = ((r >> 8) % 2) ? CPLD_READ : CPLD_WRITE;
+    }
+
+    if (CPLD_SWITCHES == op->addr)
+        op->rw = CPLD_READ;
+
+    op->data = (CPLD_WRITE == op->rw) ? (r >> 12) & 0xFF : 0xEE;
+}
+
+static void check_random(unsigned int queue, unsigned int refuse) {
+    unsigned long full = stub_full;
+    unsigned long out_of_order = stub_out_of_order;
+    cpld_op ops[MAX_OPS];
+    unsigned int b;
+    unsigned int n;
+    unsigned int i;
+
+    stub_queue = queue;
+    stub_refuse = refuse;
+    reset_models();
+
+    for (b = 0; b < RANDOM_BATCHES; b++) {
+        n = 1 + rand() % MAX_OPS;
+        for (i = 0; i < n; i++)
+            random_op(&ops[i], i ? &ops[i - 1] : 0);
+
+        stub_clear();
+        cpld_batch(ops, n);
+
+        check("random", npending, 0);
+        check_ops("random read", ops, n);
+        check_frames("random frame");
+    }
+
+    // the single operations too
+    for (b = 0; b < RANDOM_BATCHES; b++) {
+        random_op(&ops[0], 0);
+        stub_clear();
+        if (CPLD_READ == ops[0].rw)
+            ops[0].data = cpld_read(ops[0].addr);
+        else
+            cpld_write(ops[0].addr, ops[0].data);
+        check("single frames", nframes, 1);
+        check_ops("single read", ops, 1);
+        check_frames("single frame");
+    }
+
+    check("random mem1", memcmp(dut.mem1, ref.mem1, sizeof(dut.mem1)), 0);
+    check("random mem2", memcmp(dut.mem2, ref.mem2, sizeof(dut.mem2)), 0);
+    check("random page", dut.page, ref.page);
+    check("random swap", dut.swap, ref.swap);
+    check("random bar leds", dut.bar_leds, ref.bar_leds);
+    check("random board leds", dut.board_leds, ref.board_leds);
+
+    printf("queue of %u", queue);
+    if (refuse)
+        printf(", 1 in %u refused", refuse);
+    printf(": %lu full, %lu out of order\n", stub_full - full,
+            stub_out_of_order - out_of_order);
+}
+// }}}
+
+// {{{ single operation bytes
+/*
+ * check_op_bytes()
+ *
+ * cpld_op_bytes() for every operation, with the stale data of
+ * a read (all values) which must not be sent.
+ */
+static void check_op_bytes() {
+    uint8_t bytes[2];
+    uint8_t rx[2];
+    cpld_op op;
+    unsigned int addr;
+    unsigned int data;
+    unsigned int i;
+
+    reset_models();
+
+    for (addr = 0; addr <= CPLD_ADDR_BITS; addr++) {
+        for (data = 0; data <= 0xFF; data++) {
+            op.addr = addr;
+            op.rw = CPLD_READ;
+            op.data = data;
+            cpld_op_bytes(&op, bytes);
+            check("read command", bytes[0], addr | CPLD_RW_BIT);
+            check("read form feed", bytes[1] & CPLD_RW_BIT, 0);
+            check("read form feed", bytes[1], 0x00);
+
+            op.rw = CPLD_WRITE;
+            cpld_op_bytes(&op, bytes);
+            check("write command", bytes[0], addr);
+            check("write data", bytes[1], data);
+        }
+    }
+
+    // on the model, as a frame of its own
+    for (i = 0; i < RANDOM_BATCHES; i++) {
+        random_op(&op, 0);
+        op.data = rand();
+        cpld_op_bytes(&op, bytes);
+
+        cpld_model_nss(&dut, 0);
+        rx[0] = cpld_model_xfer(&dut, bytes[0]);
+        rx[1] = cpld_model_xfer(&dut, bytes[1]);
+        cpld_model_nss(&dut, 1);
+
+        if (CPLD_READ == op.rw)
+            op.data = rx[1];
+        check_ops("op bytes read", &op, 1);
+    }
+
+    check("op bytes mem1", memcmp(dut.mem1, ref.mem1, sizeof(dut.mem1)), 0);
+    check("op bytes mem2", memcmp(dut.mem2, ref.mem2, sizeof(dut.mem2)), 0);
+    check("op bytes page", dut.page, ref.page);
+}
+// }}}
+
+int main() {
+    srand(344);
+
+    stub_queue = SPI_DMA_QUEUE_LEN - 1;
+    stub_refuse = 0;
+    check_packing();
+    check_op_bytes();
+
+    stub_full = 0;
+    stub_out_of_order = 0;
+    check_random(SPI_DMA_QUEUE_LEN - 1, 0);
+    check_random(1, 0);
+    check_random(2, 4);
+    check_random(3, 2);
+
+    // both paths must have been run
+    check("full seen", stub_full > 0, 1);
+    check("out of order seen", stub_out_of_order > 0, 1);
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,206 @@
+/*
+ * NAME
+ * ----
+ *
+ * cpld_model.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Functional model of the Lab 3 CPLD, refer to cpld_model.h.
+ *
+ * The bus devices are modeled by cpld_model_bus_read() and
+ * cpld_model_bus_write() which follow decoder.v.
+ *
+ *    address (hex) | device
+ *  ----------------+---------------
+ *   0x74           | switches
+ *   0x6C           | bar leds
+ *   0x50 - 0x5F    | mem2 (mem1 if swapped)
+ *   0x32           | swap
+ *   0x31           | page[12:8]
+ *   0x30           | page[7:0]
+ *   0x2F           | board leds
+ *   0x00 - 0x0F    | mem1 (mem2 if swapped)
+ *
+ * The RAM windows are 16 bytes of the page selected by
+ * the page register (see page_ctl.v and mem_ctl.v), and the
+ * chips behind them are exchanged by the swap register
+ * (see mem_arb.v).
+ *
+ * The SPI side follows spi_ctl.v a byte at a time.
+ *
+ *  byte  read (rw = 1)                 write (rw = 0)
+ *  ----  -------------                 --------------
+ *  1     address, rw                   address, rw
+ *  2     MISO = data[A]                data written to A
+ *  3...  MISO = data[A+1] or data of   data written to A+1, ...
+ *        the pipelined read command
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <string.h>
+
+#include "cpld_model.h"
+
+#define ADDR_BITS 0x7F
+#define RW_BIT    0x80
+#define PAGE_BITS 0x1FFF
+
+// RAM address of 'addr' in the current page, see mem_ctl.v
+#define MEM_ADDR(m, addr) ((((uint32_t) (m)->page) << 4) | ((addr) & 0x0F))
+
+// RAM chip behind each window, see mem_arb.v
+#define WINDOW1(m) ((m)->swap ? (m)->mem2 : (m)->mem1)
+#define WINDOW2(m) ((m)->swap ? (m)->mem1 : (m)->mem2)
+
+void cpld_model_init(cpld_model *m) {
+    memset(m, 0, sizeof(*m));
+
+    // reset, led_ctl sets leds to ~(0x00)
+    m->bar_leds = 0xFF;
+    m->board_leds = 0xFF;
+    // all switches off (pulled up)
+    m->switches = 0xFF;
+
+    m->nss = 1;
+}
+
+// {{{ bus
+/*
+ * cpld_model_bus_read()
+ *
+ * Value driven on to the data bus for a read of 'addr'.
+ * Nothing drives the bus for unmapped addresses, 0x00 is
+ * returned for those.
+ */
+uint8_t cpld_model_bus_read(cpld_model *m, uint8_t addr) {
+    addr &= ADDR_BITS;
+
+    if (0x74 == addr)
+        return ~(m->switches);
+    else if (0x6C == addr)
+        return ~(m->bar_leds);
+    else if (0x50 == (addr & 0x70))
+        return WINDOW2(m)[MEM_ADDR(m, addr)];
+    else if (0x32 == addr)
+        return m->swap;
+    else if (0x31 == addr)
+        return m->page >> 8;
+    else if (0x30 == addr)
+        return m->page & 0xFF;
+    else if (0x2F == addr)
+        return ~(m->board_leds);
+    else if (0x00 == (addr & 0x70))
+        return WINDOW1(m)[MEM_ADDR(m, addr)];
+
+    return 0x00;
+}
+
+/*
+ * cpld_model_bus_write()
+ *
+ * Write 'data' to 'addr'.  Writes to read only or unmapped
+ * addresses are ignored.
+ */
+void cpld_model_bus_write(cpld_model *m, uint8_t addr, uint8_t data) {
+    addr &= ADDR_BITS;
+
+    if (0x6C == addr)
+        m->bar_leds = ~(data);
+    else if (0x50 == (addr & 0x70))
+        WINDOW2(m)[MEM_ADDR(m, addr)] = data;
+    else if (0x32 == addr)
+        m->swap = data & 0x01;
+    else if (0x31 == addr)
+        m->page = ((data << 8) | (m->page & 0xFF)) & PAGE_BITS;
+    else if (0x30 == addr)
+        m->page = (m->page & 0xFF00) | data;
+    else if (0x2F == addr)
+        m->board_leds = ~(data);
+    else if (0x00 == (addr & 0x70))
+        WINDOW1(m)[MEM_ADDR(m, addr)] = data;
+}
+// }}}
+
+// {{{ SPI
+/*
+ * cpld_model_nss()
+ *
+ * Set the level of the NSS pin, 0 enabled, 1 disabled.
+ */
+void cpld_model_nss(cpld_model *m, int level) {
+    if (level && ! m->nss) {
+        // disabled, r_reg is reset
+        m->r_reg = 0x00;
+        m->read = 0;
+    } else if (! level && m->nss) {
+        // enabled, start of a transaction
+        m->count = 0;
+        m->r_reg = 0x00;
+        m->read = 0;
+    }
+
+    m->nss = level ? 1 : 0;
+}
+
+/*
+ * cpld_model_xfer()
+ *
+ * Transfer one byte, 'mosi' is received and the byte
+ * sent on MISO is returned.
+ * Nothing happens if NSS is disabled (MISO is returned as 0x00).
+ */
+uint8_t cpld_model_xfer(cpld_model *m, uint8_t mosi) {
+    uint8_t miso;
+
+    if (m->nss)
+        return 0x00;
+
+    m->bytes++;
+
+    // whatever is in the shift register goes out during this byte
+    miso = m->r_reg;
+    // and by default the received byte replaces it
+    m->r_reg = mosi;
+
+    if (0 == m->count) {
+        // address, rw
+        m->address = mosi & ADDR_BITS;
+        m->read = (mosi & RW_BIT) ? 1 : 0;
+
+        if (m->read) {
+            m->r_reg = cpld_model_bus_read(m, m->address);
+            m->reads++;
+        }
+    } else if (m->read) {
+        // a read command continues the pipeline, otherwise
+        // it is the next address of a burst
+        if (mosi & RW_BIT)
+            m->address = mosi & ADDR_BITS;
+        else
+            m->address = (m->address + 1) & ADDR_BITS;
+
+        m->r_reg = cpld_model_bus_read(m, m->address);
+        m->reads++;
+    } else {
+        // write, the address advances after each data byte
+        if (m->count > 1)
+            m->address = (m->address + 1) & ADDR_BITS;
+
+        cpld_model_bus_write(m, m->address, mosi);
+        m->writes++;
+    }
+
+    m->count++;
+
+    return miso;
+}
+// }}}
+
+// vim:foldmethod=marker
@@ -0,0 +1,92 @@
+#ifndef CPLD_MODEL_H
+#define CPLD_MODEL_H
+
+#include <stdint.h>
+
+/*
+ * NAME
+ * ----
+ *
+ * cpld_model.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Functional model of the Lab 3 CPLD (../CPLD/main.v) as seen
+ * from its SPI pins, for use on a host (Linux) computer.
+ *
+ * It models the spi_ctl protocol (two byte transactions, bursts
+ * and pipelined reads), the decoder address map, the two led_ctl
+ * registers, the switch_ctl input, the page_ctl register and
+ * both mem_ctl RAM chips.
+ *
+ * The model works a byte at a time.  The value returned for each
+ * byte is what spi_ctl would shift out on MISO during that byte,
+ * including the "junk" bytes (0x00 during the first byte,
+ * the previous byte during writes).
+ *
+ * The LED and switch values are kept at the pin level, so they
+ * are inverted just like on the board.
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  cpld_model m;
+ *
+ *  cpld_model_init(&m);
+ *  m.switches = ~0xF4;  // pins, inverted
+ *
+ *  cpld_model_nss(&m, 0);          // enable
+ *  cpld_model_xfer(&m, 0x74 | 0x80);
+ *  sw = cpld_model_xfer(&m, 0x00); // 0xF4
+ *  cpld_model_nss(&m, 1);          // disable
+ *
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    // pins
+    uint8_t bar_leds;
+    uint8_t board_leds;
+    uint8_t switches;
+
+    // page_ctl, upper 13 bits of the RAM address
+    uint16_t page;
+    // mem_arb, 1 if the RAM windows are swapped
+    uint8_t swap;
+
+    // RAM chips (AS6C1008, 128K x 8)
+    uint8_t mem1[1 << 17];
+    uint8_t mem2[1 << 17];
+
+    // spi_ctl state
+    uint8_t nss;
+    unsigned int count;     // bytes since NSS was enabled
+    uint8_t address;        // address_bus
+    uint8_t read;           // 1 if this is a read (read_n low)
+    uint8_t r_reg;          // shift register, shifted out next byte
+
+    // statistics
+    unsigned long bytes;
+    unsigned long reads;
+    unsigned long writes;
+} cpld_model;
+
+void cpld_model_init(cpld_model *);
+
+void cpld_model_nss(cpld_model *, int);
+
+uint8_t cpld_model_xfer(cpld_model *, uint8_t);
+
+uint8_t cpld_model_bus_read(cpld_model *, uint8_t);
+
+void cpld_model_bus_write(cpld_model *, uint8_t, uint8_t);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
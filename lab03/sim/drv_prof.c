@@ -0,0 +1,554 @@
+/*
+ * NAME
+ * ----
+ *
+ * drv_prof.c - register accesses of the driver calls
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./drv_prof
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The init and runtime paths of ../ARM/main.c, the LCD glass
+ * driver (../ARM/Libraries/STM32L-DISCOVERY) and the ST drivers
+ * run against the register model (regmodel.c), each wrapped in
+ * PROF_CALL() (../ARM/prof.h).
+ *
+ * Two reports are displayed, each ranked by register accesses.
+ *
+ *  sites        each PROF_CALL(), its calls and the register
+ *               reads and writes per call
+ *
+ *  call sites   the function which accessed the register and
+ *               the function which called it, from the stack
+ *               at each access, with the number of places it
+ *               was called from
+ *
+ * A register access on the board takes a few cycles on the
+ * peripheral bus, and most are a read-modify-write, so the
+ * accesses are the cost which the host can count.  The time
+ * of the sites is not displayed, on the host it is mostly the
+ * trap of each access.
+ *
+ * The configuration of the LCD pins as it was, GPIO_Init() and
+ * a GPIO_PinAFConfig() for each pin, is run first for its counts
+ * and to check that LCD_GLASS_Configure_GPIO(), by GPIO_InitBatch(),
+ * leaves the same registers.
+ *
+ * The counts are also checked.  The exit status is non-zero
+ * if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stm32l1xx.h"
+#include "stm32l_discovery_lcd.h"
+
+#include "prof.h"
+#include "regmodel.h"
+
+#define MAX_CALLERS 128
+#define MAX_FRAMES  32
+#define TOP         12
+
+static unsigned long errors;
+static unsigned long checks;
+
+// {{{ host
+// PROF_CLOCK, the time of the sites
+uint32_t host_clock(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// the LCD glass driver only waits while scrolling in place
+void delay_ms(uint32_t ms) {
+}
+
+/*
+ * PWR_RTCAccessCmd()
+ *
+ * As stm32l1xx_pwr.c, which has the WFI instruction and can
+ * not be built for the host, DBP of PWR_CR by its bit-band.
+ */
+void PWR_RTCAccessCmd(FunctionalState NewState) {
+    *(__IO uint32_t *) (PERIPH_BB_BASE + (PWR_BASE - PERIPH_BASE) * 32
+                        + 8 * 4) = NewState;
+}
+// }}}
+
+// {{{ call sites
+typedef struct {
+    void *fn;           // function which accessed the register
+    void *caller;       // function which called it
+    void *ret[64];      // places it was called from
+    int nret;
+    unsigned long reads;
+    unsigned long writes;
+} call_site;
+
+static call_site callers[MAX_CALLERS];
+static int ncallers;
+static unsigned long unknown;
+
+static void *function_of(void *pc) {
+    Dl_info info;
+
+    if (dladdr(pc, &info) && info.dli_saddr)
+        return info.dli_saddr;
+
+    return 0;
+}
+
+static const char *name_of(void *fn) {
+    Dl_info info;
+
+    if (fn && dladdr(fn, &info) && info.dli_sname)
+        return info.dli_sname;
+
+    return "?";
+}
+
+/*
+ * listen()
+ *
+ * Given each access by the register model, counts it for
+ * the open sites and for the function which made it, as
+ * called by its caller.  The stack is that of the trap,
+ * the access is in the first frame in the function of
+ * the pc and the next frame is the return to its caller.
+ */
+static void listen(const regmodel_access *a) {
+    void *frames[MAX_FRAMES];
+    void *fn = function_of(a->pc);
+    void *caller;
+    void *ret = 0;
+    call_site *c;
+    int n;
+    int i;
+
+    prof_access(a->write);
+
+    n = backtrace(frames, MAX_FRAMES);
+    for (i = 0; i < n - 1; i++) {
+        if (fn && function_of(frames[i]) == fn) {
+            ret = frames[i + 1];
+            break;
+        }
+    }
+    if (! ret) {
+        unknown++;
+        return;
+    }
+    caller = function_of(ret);
+
+    for (i = 0; i < ncallers; i++) {
+        if (callers[i].fn == fn && callers[i].caller == caller)
+            break;
+    }
+    if (i == ncallers) {
+        if (MAX_CALLERS == ncallers) {
+            unknown++;
+            return;
+        }
+        ncallers++;
+    }
+    c = &callers[i];
+    c->fn = fn;
+    c->caller = caller;
+
+    for (i = 0; i < c->nret && c->ret[i] != ret; i++)
+        ;
+    if (i == c->nret && c->nret < 64)
+        c->ret[c->nret++] = ret;
+
+    if (a->write)
+        c->writes++;
+    else
+        c->reads++;
+}
+// }}}
+
+// {{{ paths
+/*
+ * The pins of the LCD as LCD_GLASS_Configure_GPIO() did
+ * before GPIO_InitBatch().
+ */
+void configure_LCD_GPIO_per_pin() {
+    static const uint16_t pins[3] = {
+        GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_8 | GPIO_Pin_9
+            | GPIO_Pin_10 | GPIO_Pin_15,
+        GPIO_Pin_3 | GPIO_Pin_4 | GPIO_Pin_5 | GPIO_Pin_8 | GPIO_Pin_9
+            | GPIO_Pin_10 | GPIO_Pin_11 | GPIO_Pin_12 | GPIO_Pin_13
+            | GPIO_Pin_14 | GPIO_Pin_15,
+        GPIO_Pin_0 | GPIO_Pin_1 | GPIO_Pin_2 | GPIO_Pin_3 | GPIO_Pin_6
+            | GPIO_Pin_7 | GPIO_Pin_8 | GPIO_Pin_9 | GPIO_Pin_10
+            | GPIO_Pin_11};
+    GPIO_TypeDef *const ports[3] = {GPIOA, GPIOB, GPIOC};
+    GPIO_InitTypeDef init;
+    int i;
+    int pin;
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA | RCC_AHBPeriph_GPIOB
+            | RCC_AHBPeriph_GPIOC | RCC_AHBPeriph_GPIOD
+            | RCC_AHBPeriph_GPIOE | RCC_AHBPeriph_GPIOH, ENABLE);
+
+    GPIO_StructInit(&init);
+    for (i = 0; i < 3; i++) {
+        init.GPIO_Pin = pins[i];
+        init.GPIO_Mode = GPIO_Mode_AF;
+        GPIO_Init(ports[i], &init);
+        for (pin = 0; pin < 16; pin++) {
+            if (pins[i] & 1 << pin)
+                GPIO_PinAFConfig(ports[i], pin, GPIO_AF_LCD);
+        }
+    }
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA | RCC_AHBPeriph_GPIOB
+            | RCC_AHBPeriph_GPIOC | RCC_AHBPeriph_GPIOD
+            | RCC_AHBPeriph_GPIOE | RCC_AHBPeriph_GPIOH, DISABLE);
+}
+
+/*
+ * The init paths of ../ARM/main.c, configure_LCD() and
+ * configure_SPI(), with each driver call a site.
+ */
+void configure_LCD() {
+    PROF_CALL(RCC_HSICmd(ENABLE));
+    PROF_CALL(RCC_SYSCLKConfig(RCC_SYSCLKSource_HSI));
+    PROF_CALL(RCC_APB1PeriphClockCmd(RCC_APB1Periph_PWR, ENABLE));
+    PROF_CALL(RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE));
+    PROF_CALL(RCC_APB1PeriphClockCmd(RCC_APB1Periph_LCD, ENABLE));
+    PROF_CALL(PWR_RTCAccessCmd(ENABLE));
+    PROF_CALL(RCC_RTCCLKConfig(RCC_RTCCLKSource_LSE));
+    PROF_CALL(RCC_LSEConfig(RCC_LSE_ON));
+    PROF_CALL(LCD_GLASS_Configure_GPIO());
+    PROF_CALL(LCD_GLASS_Init());
+    PROF_CALL(LCD_GLASS_Clear());
+}
+
+void configure_SPI() {
+    GPIO_InitTypeDef GPIO_init;
+    SPI_InitTypeDef SPI_init;
+
+    PROF_CALL(RCC_APB2PeriphClockCmd(RCC_APB2Periph_SPI1, ENABLE));
+    PROF_CALL(RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOA, ENABLE));
+
+    PROF_CALL(GPIO_PinAFConfigMask(GPIOA, GPIO_Pin_5 | GPIO_Pin_12
+                | GPIO_Pin_11, GPIO_AF_SPI1));
+    GPIO_init.GPIO_Pin = GPIO_Pin_5 | GPIO_Pin_12 | GPIO_Pin_11;
+    GPIO_init.GPIO_Mode = GPIO_Mode_AF;
+    GPIO_init.GPIO_Speed = GPIO_Speed_40MHz;
+    GPIO_init.GPIO_OType = GPIO_OType_PP;
+    GPIO_init.GPIO_PuPd = GPIO_PuPd_NOPULL;
+    PROF_CALL(GPIO_Init(GPIOA, &GPIO_init));
+
+    SPI_StructInit(&SPI_init);
+    SPI_init.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
+    SPI_init.SPI_Mode = SPI_Mode_Master;
+    SPI_init.SPI_DataSize = SPI_DataSize_8b;
+    SPI_init.SPI_NSS = SPI_NSS_Soft;
+    SPI_init.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_256;
+    PROF_CALL(SPI_Init(SPI1, &SPI_init));
+    PROF_CALL(SPI_Cmd(SPI1, ENABLE));
+
+    PROF_CALL(RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOB, ENABLE));
+    GPIO_init.GPIO_Pin = GPIO_Pin_5;
+    GPIO_init.GPIO_Mode = GPIO_Mode_OUT;
+    GPIO_init.GPIO_Speed = GPIO_Speed_400KHz;
+    PROF_CALL(GPIO_Init(GPIOB, &GPIO_init));
+}
+
+/*
+ * A bus operation, two bytes on the SPI with the slave
+ * select (PB5) around them, polled rather than by DMA.
+ */
+uint8_t bus_op(uint8_t addr, uint8_t data) {
+    uint8_t rx = 0;
+    int i;
+
+    PROF_CALL(GPIO_ResetBits(GPIOB, GPIO_Pin_5));
+    for (i = 0; i < 2; i++) {
+        PROF_CALL(SPI_I2S_SendData(SPI1, i ? data : addr));
+        while (SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE) == RESET)
+            ;
+        PROF_CALL(rx = SPI_I2S_ReceiveData(SPI1));
+    }
+    PROF_CALL(GPIO_SetBits(GPIOB, GPIO_Pin_5));
+
+    return rx;
+}
+
+/*
+ * The runtime paths, the lcd task showing the strings of
+ * the ui, and the bus task.
+ */
+void run() {
+    static const char *const strs[] = {"CMD 0a", "CMD 0a", "CMD 8b",
+                                       "DAT 55", "CMD 0a"};
+    unsigned int i;
+
+    for (i = 0; i < sizeof(strs) / sizeof(strs[0]); i++)
+        PROF_CALL(LCD_GLASS_ShowString((uint8_t *) strs[i]));
+
+    PROF_CALL(LCD_GLASS_ScrollString((uint8_t *) "ADDR 0a READ 55   ", 0, 300));
+    PROF_CALL(LCD_GLASS_ScrollStop());
+
+    for (i = 0; i < 10; i++)
+        PROF_CALL(bus_op(0x80 | i, 0));
+}
+// }}}
+
+// {{{ reports
+static int by_accesses(const void *a, const void *b) {
+    const prof_site *x = *(const prof_site **) a;
+    const prof_site *y = *(const prof_site **) b;
+    unsigned long nx = x->reads + x->writes;
+    unsigned long ny = y->reads + y->writes;
+
+    return nx < ny ? 1 : (nx > ny ? -1 : 0);
+}
+
+static int by_caller_accesses(const void *a, const void *b) {
+    const call_site *x = a;
+    const call_site *y = b;
+    unsigned long nx = x->reads + x->writes;
+    unsigned long ny = y->reads + y->writes;
+
+    return nx < ny ? 1 : (nx > ny ? -1 : 0);
+}
+
+static void report_sites() {
+    prof_site *sites[64];
+    prof_site *s;
+    int n = 0;
+    int i;
+
+    for (s = prof_sites; s && n < 64; s = s->next)
+        sites[n++] = s;
+    qsort(sites, n, sizeof(sites[0]), by_accesses);
+
+    printf("%-44s %5s %6s %6s %7s\n",
+            "site", "calls", "reads", "writes", "total");
+    for (i = 0; i < n && i < TOP; i++) {
+        s = sites[i];
+        printf("%-44.44s %5lu %6.1f %6.1f %7lu\n", s->name, s->calls,
+                (double) s->reads / s->calls, (double) s->writes / s->calls,
+                s->reads + s->writes);
+    }
+    printf("\n");
+}
+
+static void report_callers() {
+    char name[64];
+    int i;
+
+    qsort(callers, ncallers, sizeof(callers[0]), by_caller_accesses);
+
+    printf("%-50s %5s %6s %6s\n", "call site", "from", "reads", "writes");
+    for (i = 0; i < ncallers && i < TOP; i++) {
+        snprintf(name, sizeof(name), "%s <- %s", name_of(callers[i].fn),
+                name_of(callers[i].caller));
+        printf("%-50.50s %5d %6lu %6lu\n", name, callers[i].nret,
+                callers[i].reads, callers[i].writes);
+    }
+    printf("\n");
+}
+// }}}
+
+// {{{ checks
+static GPIO_TypeDef *const ports[] = {GPIOA, GPIOB, GPIOC};
+#define NPORTS (sizeof(ports) / sizeof(ports[0]))
+
+// MODER, OTYPER, OSPEEDR, PUPDR, AFR[0], AFR[1] of each port
+#define NREGS 6
+
+static void snapshot(uint32_t regs[NPORTS][NREGS]) {
+    unsigned int i;
+
+    for (i = 0; i < NPORTS; i++) {
+        regs[i][0] = regmodel_peek(&ports[i]->MODER);
+        regs[i][1] = regmodel_peek(&ports[i]->OTYPER);
+        regs[i][2] = regmodel_peek(&ports[i]->OSPEEDR);
+        regs[i][3] = regmodel_peek(&ports[i]->PUPDR);
+        regs[i][4] = regmodel_peek(&ports[i]->AFR[0]);
+        regs[i][5] = regmodel_peek(&ports[i]->AFR[1]);
+    }
+}
+
+static void restore(uint32_t regs[NPORTS][NREGS]) {
+    unsigned int i;
+
+    for (i = 0; i < NPORTS; i++) {
+        regmodel_poke(&ports[i]->MODER, regs[i][0]);
+        regmodel_poke(&ports[i]->OTYPER, regs[i][1]);
+        regmodel_poke(&ports[i]->OSPEEDR, regs[i][2]);
+        regmodel_poke(&ports[i]->PUPDR, regs[i][3]);
+        regmodel_poke(&ports[i]->AFR[0], regs[i][4]);
+        regmodel_poke(&ports[i]->AFR[1], regs[i][5]);
+    }
+}
+
+static void check(const char *name, long got, long expected);
+
+/*
+ * check_lcd_gpio()
+ *
+ * The LCD pins configured as before and by
+ * LCD_GLASS_Configure_GPIO() must be the same.
+ */
+static void check_lcd_gpio() {
+    uint32_t start[NPORTS][NREGS];
+    uint32_t expected[NPORTS][NREGS];
+    uint32_t got[NPORTS][NREGS];
+    unsigned int i;
+    unsigned int j;
+
+    snapshot(start);
+    PROF_CALL(configure_LCD_GPIO_per_pin());
+    snapshot(expected);
+    restore(start);
+
+    PROF_CALL(LCD_GLASS_Configure_GPIO());
+    snapshot(got);
+    for (i = 0; i < NPORTS; i++) {
+        for (j = 0; j < NREGS; j++)
+            check("lcd gpio", got[i][j], expected[i][j]);
+    }
+    restore(start);
+}
+
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %ld, got %ld\n", name, expected, got);
+        errors++;
+    }
+}
+
+static prof_site *site(const char *name) {
+    prof_site *s;
+
+    for (s = prof_sites; s; s = s->next) {
+        if (0 == strcmp(s->name, name))
+            return s;
+    }
+
+    fprintf(stderr, "no site %s\n", name);
+    exit(1);
+}
+
+static call_site *caller(const char *fn, const char *from) {
+    int i;
+
+    for (i = 0; i < ncallers; i++) {
+        if (0 == strcmp(name_of(callers[i].fn), fn)
+                && 0 == strcmp(name_of(callers[i].caller), from))
+            return &callers[i];
+    }
+
+    fprintf(stderr, "no call site %s <- %s\n", fn, from);
+    exit(1);
+}
+
+static void check_counts() {
+    unsigned long sum = 0;
+    prof_site *s;
+    call_site *c;
+    int i;
+
+    // every access has its call site
+    for (i = 0; i < ncallers; i++)
+        sum += callers[i].reads + callers[i].writes;
+    check("unknown", unknown, 0);
+    check("all", sum, regmodel_reads + regmodel_writes);
+
+    // a single store to BSRR
+    s = site("GPIO_SetBits(GPIOB, GPIO_Pin_5)");
+    check("set calls", s->calls, 10);
+    check("set reads", s->reads, 0);
+    check("set writes", s->writes, 10);
+
+    // it was two read-modify-writes of AFR for each of the
+    // 28 pins, and two of MODER, OSPEEDR, OTYPER and PUPDR
+    c = caller("GPIO_PinAFConfig", "configure_LCD_GPIO_per_pin");
+    check("af reads", c->reads, 2 * 28);
+    check("af writes", c->writes, 2 * 28);
+    s = site("configure_LCD_GPIO_per_pin()");
+    check("per pin", s->reads + s->writes, 564);
+
+    // it is now one of each register of the three ports, and
+    // the clock on and off, by check_lcd_gpio() and configure_LCD()
+    c = caller("GPIO_InitBatch", "LCD_GLASS_Configure_GPIO");
+    check("batch reads", c->reads, 2 * 3 * 6);
+    check("batch writes", c->writes, 2 * 3 * 6);
+    s = site("LCD_GLASS_Configure_GPIO()");
+    check("batch calls", s->calls, 1);
+    check("batch", s->reads + s->writes, 3 * 6 * 2 + 4);
+
+    // nested sites include those within them
+    s = site("bus_op(0x80 | i, 0)");
+    check("nested", s->writes, site("SPI_I2S_SendData(SPI1, i ? data : addr)")->writes
+            + 2 * site("GPIO_SetBits(GPIOB, GPIO_Pin_5)")->writes);
+
+    // an unchanged string does not touch the LCD
+    s = site("LCD_GLASS_ShowString((uint8_t *) strs[i])");
+    check("show calls", s->calls, 5);
+}
+// }}}
+
+int main() {
+    void *frames[MAX_FRAMES];
+
+    // the unwinder is loaded by its first use, not in a trap
+    backtrace(frames, MAX_FRAMES);
+
+    regmodel_init();
+    prof_init();
+    regmodel_listen(listen);
+
+    check_lcd_gpio();
+    configure_LCD();
+    configure_SPI();
+    run();
+
+    regmodel_listen(0);
+
+    printf("%lu register reads, %lu writes\n\n",
+            regmodel_reads, regmodel_writes);
+    report_sites();
+    report_callers();
+
+    check_counts();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
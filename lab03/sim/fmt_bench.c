@@ -0,0 +1,283 @@
+/*
+ * NAME
+ * ----
+ *
+ * fmt_bench.c - test and benchmark of the LCD formatting
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./fmt_bench
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The fixed width formatting (../ARM/fmt.c) which replaced
+ * sprintf() for the LCD strings is compared with sprintf(),
+ * for each of its fields over a range of values and for the
+ * lines displayed by Lab 1, 2 and 3.
+ *
+ * Then the time to build each of those lines, by sprintf()
+ * and by fmt, is measured (on the host) and displayed.
+ * 'make fmt_size' shows the code size of each.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "fmt.h"
+
+#define BENCH_LINES 10000000
+
+static unsigned long errors;
+static unsigned long checks;
+
+// {{{ lines
+/*
+ * The lines of each lab, by sprintf() as they were and
+ * by fmt as they are now.
+ */
+static void lab1_sprintf(char *str, uint16_t count) {
+    sprintf(str, "%x", count);
+}
+
+static void lab1_fmt(char *str, uint16_t count) {
+    *fmt_hex(str, count, 0) = 0;
+}
+
+static void lab2_sprintf(char *str, uint8_t res) {
+    char sign = (res & 0x20) ? '1' : '0';
+    char oflow = (res & 0x10) ? '1' : '0';
+    uint8_t num = res & 0x0f;
+    char sign_char = (0 == num) ? ' ' : ('1' == sign) ? '-' : '+';
+
+    if ('1' == sign)
+        num = (~num + 1) & 0x0f;
+
+    sprintf(str, "N%cV%c%c%u", sign, oflow, sign_char, num);
+}
+
+static void lab2_fmt(char *str, uint8_t res) {
+    char sign = (res & 0x20) ? '1' : '0';
+    char oflow = (res & 0x10) ? '1' : '0';
+    uint8_t num = res & 0x0f;
+    char sign_char = (0 == num) ? ' ' : ('1' == sign) ? '-' : '+';
+    char *p = str;
+
+    if ('1' == sign)
+        num = (~num + 1) & 0x0f;
+
+    *p++ = 'N';
+    *p++ = sign;
+    *p++ = 'V';
+    *p++ = oflow;
+    *p++ = sign_char;
+    p = fmt_udec(p, num, 0);
+    *p = 0;
+}
+
+static void lab3_sprintf(char *str, uint8_t addr, uint8_t data) {
+    sprintf(str, "ADDR %.2x READ %.2x   ", addr, data);
+}
+
+static void lab3_fmt(char *str, uint8_t addr, uint8_t data) {
+    char *p = str;
+
+    p = fmt_str(p, "ADDR ");
+    p = fmt_hex(p, addr, 2);
+    p = fmt_str(p, " READ ");
+    p = fmt_hex(p, data, 2);
+    p = fmt_str(p, "   ");
+    *p = 0;
+}
+// }}}
+
+// {{{ checks
+static void check_str(const char *name, const char *got,
+                        const char *expected) {
+    checks++;
+    if (strcmp(got, expected)) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected '%s', got '%s'\n",
+                    name, expected, got);
+        errors++;
+    }
+}
+
+static void check_fields() {
+    char got[32];
+    char expected[32];
+    uint32_t v;
+    int32_t sv;
+    long i;
+
+    for (i = 0; i < 200000; i++) {
+        // small values, then all sizes
+        v = (i < 100000) ? i : ((uint32_t) rand() << 16 ^ rand()) >> (rand() % 32);
+        sv = (int32_t) v;
+
+        *fmt_hex(got, v, 0) = 0;
+        sprintf(expected, "%x", v);
+        check_str("hex", got, expected);
+
+        *fmt_hex(got, v, 8) = 0;
+        sprintf(expected, "%.8x", v);
+        check_str("hex 8", got, expected);
+
+        *fmt_hex(got, v & 0xff, 2) = 0;
+        sprintf(expected, "%.2x", v & 0xff);
+        check_str("hex 2", got, expected);
+
+        // too big, the lowest digits
+        *fmt_hex(got, v | 0x100, 2) = 0;
+        sprintf(expected, "%.2x", v & 0xff);
+        check_str("hex cut", got, expected);
+
+        *fmt_udec(got, v, 0) = 0;
+        sprintf(expected, "%u", v);
+        check_str("udec", got, expected);
+
+        *fmt_udec(got, v % 1000, 3) = 0;
+        sprintf(expected, "%3u", v % 1000);
+        check_str("udec 3", got, expected);
+
+        *fmt_udec(got, v, 3) = 0;
+        sprintf(expected, (v < 1000) ? "%3u" : "%.3u", v % 1000);
+        check_str("udec cut", got, expected);
+
+        *fmt_sdec(got, sv, 0) = 0;
+        sprintf(expected, "%c%u", (sv < 0) ? '-' : (sv) ? '+' : ' ',
+                (sv < 0) ? -(uint32_t) sv : (uint32_t) sv);
+        check_str("sdec", got, expected);
+
+        *fmt_sdec(got, sv % 100, 3) = 0;
+        sprintf(expected, "%c%2u", (sv % 100 < 0) ? '-' : (sv % 100) ? '+' : ' ',
+                (sv % 100 < 0) ? -(sv % 100) : sv % 100);
+        check_str("sdec 3", got, expected);
+
+        // only the sign fits
+        *fmt_sdec(got, sv, 1) = 0;
+        sprintf(expected, "%c", (sv < 0) ? '-' : (sv) ? '+' : ' ');
+        check_str("sdec 1", got, expected);
+    }
+
+    // exactly 'width' characters, whatever the value
+    for (i = 1; i <= 12; i++) {
+        *fmt_hex(got, 0xffffffff, i) = 0;
+        checks++;
+        if (strlen(got) != (size_t) i) {
+            fprintf(stderr, "hex width %ld: got '%s'\n", i, got);
+            errors++;
+        }
+        *fmt_udec(got, 4294967295U, i) = 0;
+        checks++;
+        if (strlen(got) != (size_t) i) {
+            fprintf(stderr, "udec width %ld: got '%s'\n", i, got);
+            errors++;
+        }
+        *fmt_sdec(got, -2147483647 - 1, i) = 0;
+        checks++;
+        if (strlen(got) != (size_t) i) {
+            fprintf(stderr, "sdec width %ld: got '%s'\n", i, got);
+            errors++;
+        }
+    }
+
+    *fmt_flag(got, 0) = 0;
+    check_str("flag 0", got, "0");
+    *fmt_flag(got, 0x20) = 0;
+    check_str("flag 1", got, "1");
+    *fmt_str(got, "") = 0;
+    check_str("str empty", got, "");
+}
+
+static void check_lines() {
+    char got[32];
+    char expected[32];
+    int i, j;
+
+    for (i = 0; i < 0x10000; i++) {
+        lab1_fmt(got, i);
+        lab1_sprintf(expected, i);
+        check_str("lab 1", got, expected);
+    }
+
+    for (i = 0; i < 0x40; i++) {
+        lab2_fmt(got, i);
+        lab2_sprintf(expected, i);
+        check_str("lab 2", got, expected);
+    }
+
+    for (i = 0; i < 0x100; i++) {
+        for (j = 0; j < 0x100; j += 7) {
+            lab3_fmt(got, i, j);
+            lab3_sprintf(expected, i, j);
+            check_str("lab 3", got, expected);
+        }
+    }
+}
+// }}}
+
+// {{{ benchmark
+static double seconds() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// keeps the compiler from dropping the lines
+static volatile char sink;
+
+#define BENCH(name, call) do { \
+    double t = seconds(); \
+    for (i = 0; i < BENCH_LINES; i++) { \
+        call; \
+        sink = str[1]; \
+    } \
+    t = seconds() - t; \
+    printf("%-14s %10.1f ns/line\n", name, t * 1e9 / BENCH_LINES); \
+} while (0)
+
+static void bench() {
+    char str[32];
+    unsigned long i;
+
+    BENCH("lab 1 sprintf", lab1_sprintf(str, i));
+    BENCH("lab 1 fmt",     lab1_fmt(str, i));
+    BENCH("lab 2 sprintf", lab2_sprintf(str, i));
+    BENCH("lab 2 fmt",     lab2_fmt(str, i));
+    BENCH("lab 3 sprintf", lab3_sprintf(str, i, i >> 8));
+    BENCH("lab 3 fmt",     lab3_fmt(str, i, i >> 8));
+}
+// }}}
+
+int main() {
+    srand(344);
+
+    check_fields();
+    check_lines();
+    bench();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,18 @@
+/*
+ * Host stand-in for the board header (ST STM32L-DISCOVERY).
+ *
+ * Only what the LCD glass driver (stm32l_discovery_lcd.c)
+ * needs to build on the host, refer to lcd_model.c.
+ */
+#ifndef __DISCOVER_BOARD_H
+#define __DISCOVER_BOARD_H
+
+#include "stm32l1xx.h"
+
+#define bool _Bool
+#define FALSE 0
+#define TRUE !FALSE
+
+#define USERBUTTON_GPIO_PIN     GPIO_Pin_0
+
+#endif
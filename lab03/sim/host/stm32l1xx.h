@@ -0,0 +1,21 @@
+/*
+ * Host stand-in for the ST device header.
+ *
+ * The ARM sources used by the simulation (cpld_bus.c, tick.c) only
+ * need the standard integer types and the CMSIS interrupt masking
+ * functions, which do nothing here since the simulated interrupts
+ * are only called between the functions under test.
+ * This directory is placed first on the include path so they
+ * build on the host without CMSIS.
+ */
+#ifndef STM32L1XX_H
+#define STM32L1XX_H
+
+#include <stdint.h>
+
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t primask) { (void) primask; }
+static inline void __disable_irq(void) { }
+static inline void __enable_irq(void) { }
+
+#endif
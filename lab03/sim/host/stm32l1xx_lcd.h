@@ -0,0 +1,180 @@
+/*
+ * Host stand-in for the ST LCD driver header (stm32l1xx_lcd.h).
+ *
+ * The LCD registers are a structure in memory (lcd_model.c)
+ * and the driver functions act on it, so the LCD glass driver
+ * (stm32l_discovery_lcd.c) can be built and tested on the host.
+ * The GPIO, RCC and NVIC parts it uses are included here too,
+ * they do nothing.
+ */
+#ifndef STM32L1XX_LCD_H
+#define STM32L1XX_LCD_H
+
+#include "stm32l1xx.h"
+
+// {{{ LCD
+typedef struct {
+    volatile uint32_t CR;
+    volatile uint32_t FCR;
+    volatile uint32_t SR;
+    volatile uint32_t CLR;
+    uint32_t RESERVED;
+    volatile uint32_t RAM[16];
+} LCD_TypeDef;
+
+extern LCD_TypeDef lcd_model;
+#define LCD (&lcd_model)
+
+// number of update requests and of waits for UDR
+extern unsigned long lcd_model_updates;
+extern unsigned long lcd_model_udr_waits;
+
+// the RAM as displayed, copied from LCD->RAM by each update
+extern uint32_t lcd_model_display[16];
+
+void lcd_model_frame(void);
+
+typedef struct {
+    uint32_t LCD_Prescaler;
+    uint32_t LCD_Divider;
+    uint32_t LCD_Duty;
+    uint32_t LCD_Bias;
+    uint32_t LCD_VoltageSource;
+} LCD_InitTypeDef;
+
+#define LCD_SR_ENS  0x01
+#define LCD_SR_SOF  0x02
+#define LCD_SR_UDR  0x04
+#define LCD_SR_UDD  0x08
+#define LCD_SR_RDY  0x10
+
+#define LCD_FCR_SOFIE   0x02
+#define LCD_FCR_UDDIE   0x08
+
+#define LCD_CLR_SOFC    0x02
+#define LCD_CLR_UDDC    0x08
+
+#define LCD_IT_SOF      LCD_FCR_SOFIE
+#define LCD_IT_UDD      LCD_FCR_UDDIE
+
+#define LCD_FLAG_ENS    LCD_SR_ENS
+#define LCD_FLAG_SOF    LCD_SR_SOF
+#define LCD_FLAG_UDR    LCD_SR_UDR
+#define LCD_FLAG_UDD    LCD_SR_UDD
+#define LCD_FLAG_RDY    LCD_SR_RDY
+
+#define LCD_RAMRegister_0   0
+#define LCD_RAMRegister_2   2
+#define LCD_RAMRegister_4   4
+#define LCD_RAMRegister_6   6
+#define LCD_RAMRegister_15  15
+
+#define LCD_Prescaler_1             0
+#define LCD_Divider_31              0
+#define LCD_Duty_1_4                0
+#define LCD_Bias_1_3                0
+#define LCD_VoltageSource_Internal  0
+#define LCD_DeadTime_0              0
+#define LCD_PulseOnDuration_4       0
+#define LCD_BlinkMode_Off           0
+#define LCD_BlinkFrequency_Div32    0
+
+#define LCD_Contrast_Level_0    0x000
+#define LCD_Contrast_Level_1    0x400
+#define LCD_Contrast_Level_4    0x1000
+#define LCD_Contrast_Level_7    0x1C00
+
+void LCD_Init(LCD_InitTypeDef *);
+void LCD_Cmd(int);
+void LCD_MuxSegmentCmd(int);
+void LCD_ContrastConfig(uint32_t);
+void LCD_DeadTimeConfig(uint32_t);
+void LCD_PulseOnDurationConfig(uint32_t);
+void LCD_BlinkConfig(uint32_t, uint32_t);
+void LCD_WaitForSynchro(void);
+void LCD_UpdateDisplayRequest(void);
+int LCD_GetFlagStatus(uint32_t);
+void LCD_ITConfig(uint32_t, int);
+int LCD_GetITStatus(uint32_t);
+void LCD_ClearITPendingBit(uint32_t);
+
+// in stm32l_discovery_lcd.c
+void LCD_IRQHandler(void);
+// }}}
+
+// {{{ GPIO, RCC, NVIC
+typedef struct {
+    volatile uint32_t IDR;
+} GPIO_TypeDef;
+
+extern GPIO_TypeDef gpio_model[3];
+#define GPIOA (&gpio_model[0])
+#define GPIOB (&gpio_model[1])
+#define GPIOC (&gpio_model[2])
+
+typedef struct {
+    uint32_t GPIO_Pin;
+    uint32_t GPIO_Mode;
+    uint32_t GPIO_Speed;
+    uint32_t GPIO_OType;
+    uint32_t GPIO_PuPd;
+} GPIO_InitTypeDef;
+
+#define GPIO_Pin_0  0x0001
+#define GPIO_Pin_1  0x0002
+#define GPIO_Pin_2  0x0004
+#define GPIO_Pin_3  0x0008
+#define GPIO_Pin_4  0x0010
+#define GPIO_Pin_5  0x0020
+#define GPIO_Pin_6  0x0040
+#define GPIO_Pin_7  0x0080
+#define GPIO_Pin_8  0x0100
+#define GPIO_Pin_9  0x0200
+#define GPIO_Pin_10 0x0400
+#define GPIO_Pin_11 0x0800
+#define GPIO_Pin_12 0x1000
+#define GPIO_Pin_13 0x2000
+#define GPIO_Pin_14 0x4000
+#define GPIO_Pin_15 0x8000
+
+#define GPIO_Mode_AF        2
+#define GPIO_Speed_400KHz   0
+#define GPIO_OType_PP       0
+#define GPIO_PuPd_NOPULL    0
+#define GPIO_AF_LCD         11
+
+typedef struct {
+    GPIO_TypeDef *GPIOx;
+    GPIO_InitTypeDef GPIO_Init;
+    uint8_t GPIO_AF;
+} GPIO_BatchTypeDef;
+
+#define RCC_AHBPeriph_GPIOA 0x01
+#define RCC_AHBPeriph_GPIOB 0x02
+#define RCC_AHBPeriph_GPIOC 0x04
+#define RCC_AHBPeriph_GPIOD 0x08
+#define RCC_AHBPeriph_GPIOE 0x10
+#define RCC_AHBPeriph_GPIOH 0x20
+
+#define DISABLE 0
+#define ENABLE  1
+#define RESET   0
+
+void GPIO_InitBatch(const GPIO_BatchTypeDef *, uint32_t);
+void RCC_AHBPeriphClockCmd(uint32_t, int);
+
+typedef struct {
+    uint8_t NVIC_IRQChannel;
+    uint8_t NVIC_IRQChannelPreemptionPriority;
+    uint8_t NVIC_IRQChannelSubPriority;
+    int NVIC_IRQChannelCmd;
+} NVIC_InitTypeDef;
+
+#define LCD_IRQn    24
+
+void NVIC_Init(NVIC_InitTypeDef *);
+// }}}
+
+#endif
+
+// vim:foldmethod=marker
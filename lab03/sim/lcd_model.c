@@ -0,0 +1,138 @@
+/*
+ * NAME
+ * ----
+ *
+ * lcd_model.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Host replacement for the parts of the ST LCD driver
+ * (stm32l1xx_lcd.c) used by the LCD glass driver, refer to
+ * host/stm32l1xx_lcd.h.
+ *
+ * lcd_model_frame() is the start of a frame.  An update
+ * requested before it (UDR) copies the LCD RAM to the display
+ * (lcd_model_display[]) and sets UDD, then SOF is set and
+ * LCD_IRQHandler() is called if its interrupt is enabled.
+ *
+ * Outside of the frames, a read of UDR that finds it set also
+ * does the update (as if a frame then started) so that waiting
+ * for it does not wait for ever.  The requests and the reads of
+ * UDR that found it set are counted.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "stm32l1xx_lcd.h"
+
+LCD_TypeDef lcd_model;
+GPIO_TypeDef gpio_model[3];
+
+unsigned long lcd_model_updates;
+unsigned long lcd_model_udr_waits;
+
+uint32_t lcd_model_display[16];
+
+// {{{ frames
+static void update() {
+    int i;
+
+    for (i = 0; i < 16; i++)
+        lcd_model_display[i] = lcd_model.RAM[i];
+
+    lcd_model.SR &= ~LCD_SR_UDR;
+    lcd_model.SR |= LCD_SR_UDD;
+}
+
+void lcd_model_frame(void) {
+    if (lcd_model.SR & LCD_SR_UDR)
+        update();
+
+    lcd_model.SR |= LCD_SR_SOF;
+
+    if (lcd_model.FCR & LCD_FCR_SOFIE)
+        LCD_IRQHandler();
+}
+// }}}
+
+// {{{ LCD
+void LCD_Init(LCD_InitTypeDef *init) {
+}
+
+void LCD_Cmd(int enable) {
+    if (enable)
+        lcd_model.SR |= LCD_SR_ENS | LCD_SR_RDY;
+    else
+        lcd_model.SR &= ~(LCD_SR_ENS | LCD_SR_RDY);
+}
+
+void LCD_MuxSegmentCmd(int enable) {
+}
+
+void LCD_ContrastConfig(uint32_t contrast) {
+    lcd_model.FCR = (lcd_model.FCR & ~LCD_Contrast_Level_7) | contrast;
+}
+
+void LCD_DeadTimeConfig(uint32_t dead) {
+}
+
+void LCD_PulseOnDurationConfig(uint32_t pulse) {
+}
+
+void LCD_BlinkConfig(uint32_t mode, uint32_t freq) {
+}
+
+void LCD_WaitForSynchro(void) {
+}
+
+void LCD_UpdateDisplayRequest(void) {
+    lcd_model.SR |= LCD_SR_UDR;
+    lcd_model_updates++;
+}
+
+int LCD_GetFlagStatus(uint32_t flag) {
+    int set = (lcd_model.SR & flag) ? 1 : 0;
+
+    // a frame starts, the update is done
+    if (LCD_FLAG_UDR == flag && set) {
+        update();
+        lcd_model_udr_waits++;
+    }
+
+    return set;
+}
+
+void LCD_ITConfig(uint32_t it, int enable) {
+    if (enable)
+        lcd_model.FCR |= it;
+    else
+        lcd_model.FCR &= ~it;
+}
+
+int LCD_GetITStatus(uint32_t it) {
+    // the SR and FCR bits are the same
+    return (lcd_model.SR & it) && (lcd_model.FCR & it);
+}
+
+void LCD_ClearITPendingBit(uint32_t it) {
+    lcd_model.SR &= ~it;
+}
+// }}}
+
+// {{{ GPIO, RCC, NVIC
+void GPIO_InitBatch(const GPIO_BatchTypeDef *batch, uint32_t count) {
+}
+
+void RCC_AHBPeriphClockCmd(uint32_t periph, int enable) {
+}
+
+void NVIC_Init(NVIC_InitTypeDef *init) {
+}
+// }}}
+
+// vim:foldmethod=marker
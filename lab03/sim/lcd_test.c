@@ -0,0 +1,496 @@
+/*
+ * NAME
+ * ----
+ *
+ * lcd_test.c - test and benchmark of the LCD character tables
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./lcd_test
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The LCD glass driver (../ARM/Libraries/STM32L-DISCOVERY/
+ * stm32l_discovery_lcd.c) is built against a model of the LCD
+ * registers (lcd_model.c) and every character, 0 to 255, is
+ * written to every position with and without the point and
+ * column.  After each write the LCD RAM must be the same as
+ * that of a copy of the original conversion, LCD_Conv_Char_Seg()
+ * and the shifts of each position, written to the registers.
+ *
+ * The original used Latin-1 character constants for the micro
+ * and degree signs which are negative in a (signed) char, so
+ * they were never matched.  The copy here uses 0xb5 and 0xb0,
+ * which is what was meant and what the tables do.
+ *
+ * LCD_GLASS_ScrollString() is checked by running frames of the
+ * model, it must step once every so many frames, from its
+ * interrupt, with a single update, show the right part of the
+ * string after each step and stop after the number of scrolls.
+ *
+ * The time to set a character in the shadow of the LCD RAM
+ * (LCD_GLASS_SetChar()) with the original conversion and with
+ * the tables is then measured (on the host) and displayed.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "stm32l_discovery_lcd.h"
+#include "stm32l1xx_lcd.h"
+#include "tick.h"
+
+#define BENCH_CHARS 10000000
+#define SCROLL_MS   100     // milliseconds per step
+
+static unsigned long errors;
+static unsigned long checks;
+
+// LCD RAM as written by the original
+static uint32_t ref_ram[16];
+
+// {{{ simulated hardware
+/*
+ * tick_wait()
+ *
+ * Replaces the WFI version in timebase.c, for the Delay()
+ * in LCD_GLASS_Init().
+ */
+void tick_wait() {
+    tick();
+}
+// }}}
+
+// {{{ original conversion
+static const uint16_t CapLetterMap[26] = {
+    0xFE00,0x6714,0x1d00,0x4714,0x9d00,0x9c00,0x3f00,0xfa00,0x0014,
+    0x5300,0x9841,0x1900,0x5a48,0x5a09,0x5f00,0xFC00,0x5F01,0xFC01,
+    0xAF00,0x0414,0x5b00,0x18c0,0x5a81,0x00c9,0x0058,0x05c0
+};
+
+static const uint16_t NumberMap[10] = {
+    0x5F00,0x4200,0xF500,0x6700,0xEa00,0xAF00,0xBF00,0x04600,0xFF00,0xEF00
+};
+
+static void LCD_Conv_Char_Seg(uint8_t *c, bool point, bool column,
+                                uint8_t *digit) {
+    uint16_t ch = 0;
+    uint8_t i, j;
+
+    switch (*c) {
+    case ' ':  ch = 0x00; break;
+    case '*':  ch = star; break;
+    case 0xb5: ch = C_UMAP; break;
+    case 'm':  ch = C_mMap; break;
+    case 'n':  ch = C_nMap; break;
+    case '-':  ch = C_minus; break;
+    case '+':  ch = C_plus; break;
+    case '/':  ch = C_slatch; break;
+    case 0xb0: ch = C_percent_1; break;
+    case '%':  ch = C_percent_2; break;
+    case 255:  ch = C_full; break;
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+        ch = NumberMap[*c - 0x30];
+        break;
+    default:
+        if ((*c < 0x5b) && (*c > 0x40))
+            ch = CapLetterMap[*c - 'A'];
+        if ((*c < 0x7b) && (*c > 0x60))
+            ch = CapLetterMap[*c - 'a'];
+        break;
+    }
+
+    if (point)
+        ch |= 0x0002;
+    if (column)
+        ch |= 0x0020;
+
+    for (i = 12, j = 0; j < 4; i -= 4, j++)
+        digit[j] = (ch >> i) & 0x0f;
+}
+
+static void ref_write_char(uint8_t *ch, bool point, bool column,
+                            uint8_t position) {
+    uint8_t digit[4];
+    uint32_t *ram = ref_ram;
+
+    LCD_Conv_Char_Seg(ch, point, column, digit);
+
+    switch (position) {
+    case 1:
+        ram[0] &= 0xcffffffc;
+        ram[0] |= ((digit[0] & 0x0c) << 26) | (digit[0] & 0x03);
+        ram[2] &= 0xcffffffc;
+        ram[2] |= ((digit[1] & 0x0c) << 26) | (digit[1] & 0x03);
+        ram[4] &= 0xcffffffc;
+        ram[4] |= ((digit[2] & 0x0c) << 26) | (digit[2] & 0x03);
+        ram[6] &= 0xcffffffc;
+        ram[6] |= ((digit[3] & 0x0c) << 26) | (digit[3] & 0x03);
+        break;
+    case 2:
+        ram[0] &= 0xf3ffff03;
+        ram[0] |= ((digit[0] & 0x0c) << 24) | ((digit[0] & 0x02) << 6) | ((digit[0] & 0x01) << 2);
+        ram[2] &= 0xf3ffff03;
+        ram[2] |= ((digit[1] & 0x0c) << 24) | ((digit[1] & 0x02) << 6) | ((digit[1] & 0x01) << 2);
+        ram[4] &= 0xf3ffff03;
+        ram[4] |= ((digit[2] & 0x0c) << 24) | ((digit[2] & 0x02) << 6) | ((digit[2] & 0x01) << 2);
+        ram[6] &= 0xf3ffff03;
+        ram[6] |= ((digit[3] & 0x0c) << 24) | ((digit[3] & 0x02) << 6) | ((digit[3] & 0x01) << 2);
+        break;
+    case 3:
+        ram[0] &= 0xfcfffcff;
+        ram[0] |= ((digit[0] & 0x0c) << 22) | ((digit[0] & 0x03) << 8);
+        ram[2] &= 0xfcfffcff;
+        ram[2] |= ((digit[1] & 0x0c) << 22) | ((digit[1] & 0x03) << 8);
+        ram[4] &= 0xfcfffcff;
+        ram[4] |= ((digit[2] & 0x0c) << 22) | ((digit[2] & 0x03) << 8);
+        ram[6] &= 0xfcfffcff;
+        ram[6] |= ((digit[3] & 0x0c) << 22) | ((digit[3] & 0x03) << 8);
+        break;
+    case 4:
+        ram[0] &= 0xffcff3ff;
+        ram[0] |= ((digit[0] & 0x0c) << 18) | ((digit[0] & 0x03) << 10);
+        ram[2] &= 0xffcff3ff;
+        ram[2] |= ((digit[1] & 0x0c) << 18) | ((digit[1] & 0x03) << 10);
+        ram[4] &= 0xffcff3ff;
+        ram[4] |= ((digit[2] & 0x0c) << 18) | ((digit[2] & 0x03) << 10);
+        ram[6] &= 0xffcff3ff;
+        ram[6] |= ((digit[3] & 0x0c) << 18) | ((digit[3] & 0x03) << 10);
+        break;
+    case 5:
+        ram[0] &= 0xfff3cfff;
+        ram[0] |= ((digit[0] & 0x0c) << 16) | ((digit[0] & 0x03) << 12);
+        ram[2] &= 0xfff3cfff;
+        ram[2] |= ((digit[1] & 0x0c) << 16) | ((digit[1] & 0x03) << 12);
+        ram[4] &= 0xfff3efff;
+        ram[4] |= ((digit[2] & 0x0c) << 16) | ((digit[2] & 0x01) << 12);
+        ram[6] &= 0xfff3efff;
+        ram[6] |= ((digit[3] & 0x0c) << 16) | ((digit[3] & 0x01) << 12);
+        break;
+    case 6:
+        ram[0] &= 0xfffc3fff;
+        ram[0] |= ((digit[0] & 0x04) << 15) | ((digit[0] & 0x08) << 13) | ((digit[0] & 0x03) << 14);
+        ram[2] &= 0xfffc3fff;
+        ram[2] |= ((digit[1] & 0x04) << 15) | ((digit[1] & 0x08) << 13) | ((digit[1] & 0x03) << 14);
+        ram[4] &= 0xfffc3fff;
+        ram[4] |= ((digit[2] & 0x04) << 15) | ((digit[2] & 0x08) << 13) | ((digit[2] & 0x01) << 14);
+        ram[6] &= 0xfffc3fff;
+        ram[6] |= ((digit[3] & 0x04) << 15) | ((digit[3] & 0x08) << 13) | ((digit[3] & 0x01) << 14);
+        break;
+    }
+}
+
+/*
+ * ref_set_char()
+ *
+ * LCD_GLASS_SetChar() as it was before the tables, the same
+ * shadow of the LCD RAM but each character converted by
+ * LCD_Conv_Char_Seg() and shifted by a switch on the position.
+ */
+static uint32_t ref_fb_ram[4];
+static uint16_t ref_fb_seg[7];
+static uint8_t ref_fb_dirty;
+
+static const uint32_t digit_mask[7][4] = {
+    {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+    {0xcffffffc, 0xcffffffc, 0xcffffffc, 0xcffffffc},
+    {0xf3ffff03, 0xf3ffff03, 0xf3ffff03, 0xf3ffff03},
+    {0xfcfffcff, 0xfcfffcff, 0xfcfffcff, 0xfcfffcff},
+    {0xffcff3ff, 0xffcff3ff, 0xffcff3ff, 0xffcff3ff},
+    {0xfff3cfff, 0xfff3cfff, 0xfff3efff, 0xfff3efff},
+    {0xfffc3fff, 0xfffc3fff, 0xfffc3fff, 0xfffc3fff}
+};
+
+static uint32_t LCD_Digit_Bits(uint8_t d, uint8_t com, uint8_t position) {
+    switch (position) {
+    case 1:
+        return ((d & 0x0c) << 26) | (d & 0x03);
+    case 2:
+        return ((d & 0x0c) << 24) | ((d & 0x02) << 6) | ((d & 0x01) << 2);
+    case 3:
+        return ((d & 0x0c) << 22) | ((d & 0x03) << 8);
+    case 4:
+        return ((d & 0x0c) << 18) | ((d & 0x03) << 10);
+    case 5:
+        return ((d & 0x0c) << 16) | ((d & ((com < 2) ? 0x03 : 0x01)) << 12);
+    case 6:
+        return ((d & 0x04) << 15) | ((d & 0x08) << 13) | ((d & ((com < 2) ? 0x03 : 0x01)) << 14);
+    default:
+        return 0;
+    }
+}
+
+static void ref_set_char(uint8_t *ch, bool point, bool column,
+                            uint8_t position) {
+    uint8_t digit[4];
+    uint16_t seg;
+    uint32_t ram;
+    uint8_t com;
+
+    if ((position < 1) || (position > 6))
+        return;
+
+    LCD_Conv_Char_Seg(ch, point, column, digit);
+
+    seg = (digit[0] << 12) | (digit[1] << 8) | (digit[2] << 4) | digit[3];
+    if (seg == ref_fb_seg[position])
+        return;
+    ref_fb_seg[position] = seg;
+
+    for (com = 0; com < 4; com++) {
+        ram = (ref_fb_ram[com] & digit_mask[position][com])
+                | LCD_Digit_Bits(digit[com], com, position);
+        if (ram != ref_fb_ram[com]) {
+            ref_fb_ram[com] = ram;
+            ref_fb_dirty |= 1 << com;
+        }
+    }
+}
+// }}}
+
+// {{{ checks
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %ld, got %ld\n", name, expected, got);
+        errors++;
+    }
+}
+
+static void check_ram(uint8_t c, int point, int column, int position) {
+    char name[64];
+    int i;
+
+    for (i = 0; i < 8; i += 2) {
+        snprintf(name, sizeof(name), "char 0x%02x%s%s at %d, RAM[%d]",
+                c, point ? " point" : "", column ? " column" : "",
+                position, i);
+        check(name, LCD->RAM[i], ref_ram[i]);
+    }
+}
+
+/*
+ * check_chars()
+ *
+ * Write every character, at every position, with and without
+ * the point and column, and compare the LCD RAM.  The other
+ * positions keep the characters written before.
+ */
+static void check_chars() {
+    int c, point, column, position;
+    uint8_t ch;
+
+    LCD_GLASS_Clear();
+    memset(ref_ram, 0, sizeof(ref_ram));
+
+    for (c = 0; c < 256; c++) {
+        for (position = 1; position <= 6; position++) {
+            for (point = 0; point < 2; point++) {
+                for (column = 0; column < 2; column++) {
+                    ch = c;
+                    LCD_GLASS_WriteChar(&ch, point, column, position);
+                    ref_write_char(&ch, point, column, position);
+                    check_ram(ch, point, column, position);
+                }
+            }
+        }
+    }
+
+    // a whole string and a single update for it
+    lcd_model_updates = 0;
+    LCD_GLASS_ShowString((uint8_t *) "AbC-42");
+    LCD_GLASS_ShowString((uint8_t *) "AbC-42");
+    check("one update", lcd_model_updates, 1);
+}
+
+/*
+ * expect_shown()
+ *
+ * Compare the LCD RAM with the six characters of 'text'
+ * from 'pos', the string wrapping around to its start.
+ */
+static void expect_shown(const char *name, const volatile uint32_t *ram,
+                            const char *text, int pos) {
+    int len = strlen(text);
+    uint8_t ch;
+    int i;
+
+    memset(ref_ram, 0, sizeof(ref_ram));
+    for (i = 0; i < 6; i++) {
+        ch = text[(pos + i) % len];
+        ref_write_char(&ch, FALSE, FALSE, i + 1);
+    }
+
+    for (i = 0; i < 8; i += 2)
+        check(name, ram[i], ref_ram[i]);
+}
+
+static void frames(int n) {
+    while (n-- > 0)
+        lcd_model_frame();
+}
+
+/*
+ * check_scroll()
+ *
+ * Scroll strings with LCD_GLASS_ScrollString() by running
+ * frames of the model, which calls LCD_IRQHandler().
+ */
+static void check_scroll() {
+    static char text[] = "HELLO WORLD ";
+    static char other[] = "ABCDEFGHIJ";
+    char longer[SCROLL_RING_LEN + 20];
+    int len = strlen(text);
+    int n = (SCROLL_MS * LCD_FRAME_HZ + 999) / 1000;
+    unsigned long updates;
+    int step;
+    int i;
+
+    LCD_GLASS_Clear();
+    frames(1);
+
+    // the start is shown at once
+    LCD_GLASS_ScrollString((uint8_t *) text, 2, SCROLL_MS);
+    check("scrolling", LCD_GLASS_Scrolling(), 1);
+    expect_shown("scroll start", LCD->RAM, text, 0);
+
+    // a step every n frames, twice through, back to the start,
+    // each is displayed by the next frame
+    for (step = 1; step <= 2 * len; step++) {
+        updates = lcd_model_updates;
+        frames(n - 1);
+        check("scroll early", lcd_model_updates, updates);
+        expect_shown("scroll displayed", lcd_model_display, text,
+                        (step - 1) % len);
+        frames(1);
+        check("scroll update", lcd_model_updates, updates + 1);
+        expect_shown("scroll step", LCD->RAM, text, step % len);
+    }
+    check("scroll done", LCD_GLASS_Scrolling(), 0);
+    check("scroll interrupt", LCD->FCR & LCD_FCR_SOFIE, 0);
+    updates = lcd_model_updates;
+    frames(10 * n);
+    check("scroll stopped", lcd_model_updates, updates);
+
+    // the same string does not restart, another keeps the place
+    LCD_GLASS_ScrollString((uint8_t *) text, 0, SCROLL_MS);
+    frames(3 * n);
+    updates = lcd_model_updates;
+    LCD_GLASS_ScrollString((uint8_t *) text, 0, SCROLL_MS);
+    check("scroll same", lcd_model_updates, updates);
+    expect_shown("scroll same", LCD->RAM, text, 3);
+    LCD_GLASS_ScrollString((uint8_t *) other, 0, SCROLL_MS);
+    expect_shown("scroll other", LCD->RAM, other, 3);
+    LCD_GLASS_ScrollString((uint8_t *) "XYZ", 0, SCROLL_MS);
+    expect_shown("scroll shorter", LCD->RAM, "XYZ", 0);
+
+    // stopped where it is
+    frames(n);
+    expect_shown("scroll stop", LCD->RAM, "XYZ", 1);
+    LCD_GLASS_ScrollStop();
+    updates = lcd_model_updates;
+    frames(10 * n);
+    check("scroll stop", lcd_model_updates, updates);
+    check("scroll stop", LCD_GLASS_Scrolling(), 0);
+
+    // a string too long for the ring is cut
+    for (i = 0; i < sizeof(longer) - 1; i++)
+        longer[i] = 'A' + i % 26;
+    longer[i] = 0;
+    LCD_GLASS_ScrollString((uint8_t *) longer, 1, SCROLL_MS);
+    updates = lcd_model_updates;
+    for (i = 0; i < 100 * n && LCD_GLASS_Scrolling(); i++)
+        frames(1);
+    check("scroll long", lcd_model_updates - updates, SCROLL_RING_LEN);
+}
+// }}}
+
+// {{{ benchmark
+static double seconds() {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * bench()
+ *
+ * Set characters from a string across the six positions,
+ * the string is not a multiple of six long so the same
+ * character is seldom already shown.
+ */
+static void bench() {
+    static uint8_t text[] = "The quick brown fox 0123456789 -+/% *";
+    unsigned int n = sizeof(text) - 1;
+    unsigned int c, position;
+    unsigned long i;
+    double t, t_ref, t_new;
+    int com;
+
+    t = seconds();
+    for (i = 0, c = 0, position = 1; i < BENCH_CHARS; i++) {
+        ref_set_char(&text[c], FALSE, FALSE, position);
+        if (++c == n)
+            c = 0;
+        if (++position > 6)
+            position = 1;
+    }
+    t_ref = seconds() - t;
+
+    t = seconds();
+    for (i = 0, c = 0, position = 1; i < BENCH_CHARS; i++) {
+        LCD_GLASS_SetChar(&text[c], FALSE, FALSE, position);
+        if (++c == n)
+            c = 0;
+        if (++position > 6)
+            position = 1;
+    }
+    t_new = seconds() - t;
+
+    // both end with the same characters
+    LCD_GLASS_Commit();
+    for (com = 0; com < 4; com++)
+        check("bench", LCD->RAM[2 * com], ref_fb_ram[com]);
+
+    printf("%-10s %10.1f ns/char\n", "switch",
+            t_ref * 1e9 / BENCH_CHARS);
+    printf("%-10s %10.1f ns/char\n", "tables",
+            t_new * 1e9 / BENCH_CHARS);
+}
+// }}}
+
+int main() {
+    tick_init(0);
+    LCD_GLASS_Init();
+
+    check_chars();
+    check_scroll();
+    bench();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,592 @@
+/*
+ * NAME
+ * ----
+ *
+ * regmodel.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * A model of the STM32L1xx peripheral registers for running the
+ * ST drivers on a Linux host, refer to regmodel.h.
+ *
+ * An access of the (PROT_NONE) register memory raises SIGSEGV.
+ * Its handler makes the memory accessible, runs the read side
+ * effects and sets the trap flag (TF) so that, once it returns,
+ * only the one instruction is run before SIGTRAP.  The SIGTRAP
+ * handler then runs the write side effects, records the access
+ * and makes the memory inaccessible again.
+ *
+ * The x86 page fault only tells whether it was a write, so the
+ * instruction is looked at to tell a plain store (mov) from a
+ * read-modify-write (or, and, add, ...) which also reads.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#include "regmodel.h"
+
+#if !defined(__x86_64__) || !defined(__linux__)
+#error "regmodel.c traps the register accesses on x86-64 Linux only"
+#endif
+
+#define TRAP_FLAG   0x100   // EFLAGS.TF
+#define PF_WRITE    0x2     // page fault error code, write
+
+#define BB_SIZE     (PERIPH_SIZE * 32)
+#define PERIPH_SIZE 0x30000
+
+#define MAX_HOOKS   64
+
+unsigned long regmodel_reads;
+unsigned long regmodel_writes;
+
+// {{{ memory
+static const struct {
+    uint32_t base;
+    uint32_t size;
+} regions[] = {
+    {PERIPH_BASE,    PERIPH_SIZE},  // APB1, APB2, AHB
+    {PERIPH_BB_BASE, BB_SIZE},      // their bit-band alias
+    {OB_BASE,        0x1000},       // option bytes
+    {0xE0000000,     0x100000},     // Cortex-M3 system, DBGMCU
+};
+#define NREGIONS (sizeof(regions) / sizeof(regions[0]))
+
+// the index of the region of 'addr', -1 if none
+static int region_of(uint32_t addr) {
+    unsigned int i;
+
+    for (i = 0; i < NREGIONS; i++) {
+        if (addr >= regions[i].base
+                && addr - regions[i].base < regions[i].size)
+            return i;
+    }
+
+    return -1;
+}
+
+// regions accessible now, a bit for each
+static unsigned int opened;
+
+/*
+ * open_regions()
+ *
+ * Make the peripherals, which the side effects use, and the
+ * region of 'addr' accessible.  Only those are changed as the
+ * time of mprotect() grows with the size, the bit-band alias
+ * is large.
+ */
+static void open_regions(uint32_t addr, int prot) {
+    unsigned int want = 1 << 0 | 1 << region_of(addr);
+    unsigned int i;
+
+    for (i = 0; i < NREGIONS; i++) {
+        if (want & 1 << i)
+            mprotect((void *) (uintptr_t) regions[i].base,
+                    regions[i].size, prot);
+    }
+    opened = want;
+}
+
+static void close_regions(void) {
+    unsigned int i;
+
+    for (i = 0; i < NREGIONS; i++) {
+        if (opened & 1 << i)
+            mprotect((void *) (uintptr_t) regions[i].base,
+                    regions[i].size, PROT_NONE);
+    }
+    opened = 0;
+}
+
+#define REG(addr) (*(volatile uint32_t *) (uintptr_t) (addr))
+
+static int is_bitband(uint32_t addr) {
+    return addr >= PERIPH_BB_BASE && addr - PERIPH_BB_BASE < BB_SIZE;
+}
+
+static uint32_t bitband_reg(uint32_t addr) {
+    return PERIPH_BASE + (((addr - PERIPH_BB_BASE) >> 5) & ~3);
+}
+
+static int bitband_bit(uint32_t addr) {
+    return ((addr - PERIPH_BB_BASE) >> 2) & 0x1f;
+}
+// }}}
+
+// {{{ side effects
+static struct {
+    uint32_t addr;
+    void (*read)(uint32_t);
+    void (*write)(uint32_t, uint32_t, uint32_t);
+} hooks[MAX_HOOKS];
+static int nhooks;
+
+static int hook_find(uint32_t addr, int add) {
+    int i;
+
+    for (i = 0; i < nhooks; i++) {
+        if (hooks[i].addr == addr)
+            return i;
+    }
+
+    if (! add)
+        return -1;
+
+    if (MAX_HOOKS == nhooks) {
+        fprintf(stderr, "regmodel: too many hooks\n");
+        exit(1);
+    }
+    hooks[nhooks].addr = addr;
+    hooks[nhooks].read = 0;
+    hooks[nhooks].write = 0;
+
+    return nhooks++;
+}
+
+void regmodel_on_read(volatile void *reg, void (*fn)(uint32_t addr)) {
+    hooks[hook_find((uintptr_t) reg & ~3, 1)].read = fn;
+}
+
+void regmodel_on_write(volatile void *reg,
+        void (*fn)(uint32_t addr, uint32_t old, uint32_t value)) {
+    hooks[hook_find((uintptr_t) reg & ~3, 1)].write = fn;
+}
+
+static void before_read(uint32_t addr) {
+    int i = hook_find(addr, 0);
+
+    if (i >= 0 && hooks[i].read)
+        hooks[i].read(addr);
+}
+
+static void after_write(uint32_t addr, uint32_t old, uint32_t value) {
+    int i = hook_find(addr, 0);
+
+    if (i >= 0 && hooks[i].write)
+        hooks[i].write(addr, old, value);
+}
+// }}}
+
+// {{{ models
+static void rcc_cr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    const uint32_t on = RCC_CR_HSION | RCC_CR_MSION | RCC_CR_HSEON | RCC_CR_PLLON;
+
+    // each ready flag is the bit above its enable
+    RCC->CR = (value & ~(on << 1)) | ((value & on) << 1);
+}
+
+static void rcc_cfgr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    RCC->CFGR = (value & ~RCC_CFGR_SWS) | ((value & RCC_CFGR_SW) << 2);
+}
+
+static void rcc_csr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    const uint32_t on = RCC_CSR_LSION | RCC_CSR_LSEON;
+
+    RCC->CSR = (value & ~(on << 1)) | ((value & on) << 1);
+}
+
+static void gpio_bsrr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    GPIO_TypeDef *gpio = (GPIO_TypeDef *) (uintptr_t)
+                            (addr - offsetof(GPIO_TypeDef, BSRRL));
+
+    // BSRRL sets, BSRRH resets, they read as 0
+    gpio->ODR = (gpio->ODR | (value & 0xffff)) & ~(value >> 16);
+    REG(addr) = 0;
+}
+
+static SPI_TypeDef *const spis[] = {SPI1, SPI2, SPI3};
+#define NSPIS (sizeof(spis) / sizeof(spis[0]))
+static uint16_t (*spi_exchange[NSPIS])(uint16_t);
+
+void regmodel_spi_device(SPI_TypeDef *spi, uint16_t (*exchange)(uint16_t)) {
+    unsigned int i;
+
+    for (i = 0; i < NSPIS; i++) {
+        if (spis[i] == spi)
+            spi_exchange[i] = exchange;
+    }
+}
+
+static void spi_dr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    SPI_TypeDef *spi = (SPI_TypeDef *) (uintptr_t)
+                            (addr - offsetof(SPI_TypeDef, DR));
+    uint16_t rx = value;
+    unsigned int i;
+
+    for (i = 0; i < NSPIS; i++) {
+        if (spis[i] == spi && spi_exchange[i])
+            rx = spi_exchange[i](value);
+    }
+
+    if (spi->SR & SPI_SR_RXNE)
+        spi->SR |= SPI_SR_OVR;
+    spi->DR = rx;
+    spi->SR |= SPI_SR_RXNE | SPI_SR_TXE;
+}
+
+static void spi_dr_read(uint32_t addr) {
+    SPI_TypeDef *spi = (SPI_TypeDef *) (uintptr_t)
+                            (addr - offsetof(SPI_TypeDef, DR));
+
+    spi->SR &= ~SPI_SR_RXNE;
+}
+
+static void lcd_cr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    if (value & LCD_CR_LCDEN)
+        LCD->SR |= LCD_SR_ENS | LCD_SR_RDY;
+    else
+        LCD->SR &= ~(LCD_SR_ENS | LCD_SR_RDY);
+}
+
+static void lcd_fcr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    LCD->SR |= LCD_SR_FCRSR;
+}
+
+static int lcd_udr_seen;
+
+static void lcd_sr_read(uint32_t addr) {
+    if (LCD->SR & LCD_SR_UDR) {
+        if (lcd_udr_seen) {
+            LCD->SR = (LCD->SR & ~LCD_SR_UDR) | LCD_SR_UDD;
+            lcd_udr_seen = 0;
+        } else {
+            lcd_udr_seen = 1;
+        }
+    }
+}
+
+static void lcd_clr_write(uint32_t addr, uint32_t old, uint32_t value) {
+    LCD->SR &= ~(value & (LCD_SR_SOF | LCD_SR_UDD));
+    LCD->CLR = 0;
+}
+// }}}
+
+// {{{ trace
+static void (*listener)(const regmodel_access *);
+static FILE *trace_file;
+static unsigned long seq;
+
+static const struct {
+    const char *name;
+    uint32_t base;
+    uint32_t size;
+} names[] = {
+    {"TIM2", TIM2_BASE, 0x400},     {"TIM3", TIM3_BASE, 0x400},
+    {"TIM4", TIM4_BASE, 0x400},     {"TIM6", TIM6_BASE, 0x400},
+    {"TIM7", TIM7_BASE, 0x400},     {"LCD", LCD_BASE, 0x400},
+    {"RTC", RTC_BASE, 0x400},       {"WWDG", WWDG_BASE, 0x400},
+    {"IWDG", IWDG_BASE, 0x400},     {"SPI2", SPI2_BASE, 0x400},
+    {"USART2", USART2_BASE, 0x400}, {"USART3", USART3_BASE, 0x400},
+    {"I2C1", I2C1_BASE, 0x400},     {"I2C2", I2C2_BASE, 0x400},
+    {"PWR", PWR_BASE, 0x400},       {"DAC", DAC_BASE, 0x400},
+    {"COMP", COMP_BASE, 0x4},       {"RI", RI_BASE, 0x58},
+    {"OPAMP", OPAMP_BASE, 0x3a4},   {"SYSCFG", SYSCFG_BASE, 0x400},
+    {"EXTI", EXTI_BASE, 0x400},     {"TIM9", TIM9_BASE, 0x400},
+    {"TIM10", TIM10_BASE, 0x400},   {"TIM11", TIM11_BASE, 0x400},
+    {"ADC1", ADC1_BASE, 0x300},     {"ADC", ADC_BASE, 0x100},
+    {"SPI1", SPI1_BASE, 0x400},     {"USART1", USART1_BASE, 0x400},
+    {"GPIOA", GPIOA_BASE, 0x400},   {"GPIOB", GPIOB_BASE, 0x400},
+    {"GPIOC", GPIOC_BASE, 0x400},   {"GPIOD", GPIOD_BASE, 0x400},
+    {"GPIOE", GPIOE_BASE, 0x400},   {"GPIOH", GPIOH_BASE, 0x400},
+    {"CRC", CRC_BASE, 0x400},       {"RCC", RCC_BASE, 0x400},
+    {"FLASH", FLASH_R_BASE, 0x400}, {"DMA1", DMA1_BASE, 0x400},
+    {"OB", OB_BASE, 0x1000},        {"SysTick", SysTick_BASE, 0x10},
+    {"NVIC", NVIC_BASE, 0xc00},     {"SCB", SCB_BASE, 0x90},
+    {"DBGMCU", DBGMCU_BASE, 0x400},
+};
+#define NNAMES (sizeof(names) / sizeof(names[0]))
+
+/*
+ * regmodel_name()
+ *
+ * The name of the peripheral at 'addr', and the offset of it,
+ * "?" and the address if it is not known.
+ */
+const char *regmodel_name(uint32_t addr, uint32_t *offset) {
+    unsigned int i;
+
+    for (i = 0; i < NNAMES; i++) {
+        if (addr >= names[i].base && addr - names[i].base < names[i].size) {
+            *offset = addr - names[i].base;
+            return names[i].name;
+        }
+    }
+
+    *offset = addr;
+
+    return "?";
+}
+
+void regmodel_listen(void (*fn)(const regmodel_access *)) {
+    listener = fn;
+}
+
+void regmodel_trace(FILE *f) {
+    trace_file = f;
+}
+
+static void record(uint32_t addr, uint32_t value, uint32_t old,
+                    int write, int bit, void *pc) {
+    regmodel_access a;
+    const char *name;
+    uint32_t offset;
+
+    a.seq = ++seq;
+    a.addr = addr;
+    a.value = value;
+    a.old = old;
+    a.write = write;
+    a.bit = bit;
+    a.pc = pc;
+
+    if (write)
+        regmodel_writes++;
+    else
+        regmodel_reads++;
+
+    if (listener)
+        listener(&a);
+
+    if (trace_file) {
+        name = regmodel_name(addr, &offset);
+        fprintf(trace_file, "%lu %c %s+0x%02x = 0x%08x", a.seq,
+                write ? 'W' : 'R', name, offset, value);
+        if (write)
+            fprintf(trace_file, " (was 0x%08x)", old);
+        if (bit >= 0)
+            fprintf(trace_file, " bit %d", bit);
+        fprintf(trace_file, " %p\n", pc);
+    }
+}
+// }}}
+
+// {{{ traps
+// the access being stepped
+static struct {
+    int active;
+    uint32_t addr;      // the register, not the bit-band alias
+    uint32_t alias;     // the bit-band alias, else 0
+    uint32_t old;
+    int write;
+    void *pc;
+} pending;
+
+/*
+ * is_store()
+ *
+ * True if the instruction at 'pc' only stores (mov, stos,
+ * SSE moves to memory) and does not read its destination.
+ */
+static int is_store(const uint8_t *pc) {
+    // legacy prefixes, then REX
+    while (0x66 == *pc || 0x67 == *pc || 0xf0 == *pc || 0xf2 == *pc
+            || 0xf3 == *pc || 0x2e == *pc || 0x36 == *pc || 0x3e == *pc
+            || 0x26 == *pc || 0x64 == *pc || 0x65 == *pc)
+        pc++;
+    if ((*pc & 0xf0) == 0x40)
+        pc++;
+
+    switch (*pc) {
+    case 0x88: case 0x89:   // mov r, r/m
+    case 0xc6: case 0xc7:   // mov imm, r/m
+    case 0xaa: case 0xab:   // stos
+        return 1;
+    case 0x0f:
+        return 0x11 == pc[1] || 0x29 == pc[1] || 0x7f == pc[1]
+            || 0xd6 == pc[1];
+    default:
+        return 0;
+    }
+}
+
+static void segv(int sig, siginfo_t *si, void *context) {
+    ucontext_t *uc = context;
+    uint32_t addr = (uintptr_t) si->si_addr;
+    int write;
+    int bit = -1;
+
+    if (pending.active || (uintptr_t) si->si_addr > 0xffffffff
+            || region_of(addr) < 0) {
+        // a real fault, crash on it
+        signal(SIGSEGV, SIG_DFL);
+        return;
+    }
+
+    open_regions(addr, PROT_READ | PROT_WRITE);
+
+    pending.active = 1;
+    pending.addr = addr & ~3;
+    pending.alias = 0;
+    pending.pc = (void *) uc->uc_mcontext.gregs[REG_RIP];
+    write = (uc->uc_mcontext.gregs[REG_ERR] & PF_WRITE) != 0;
+    pending.write = write;
+
+    if (is_bitband(addr)) {
+        pending.alias = addr & ~3;
+        pending.addr = bitband_reg(addr);
+        bit = bitband_bit(addr);
+    }
+
+    if (! write || ! is_store(pending.pc)) {
+        before_read(pending.addr);
+        if (pending.alias)
+            REG(pending.alias) = (REG(pending.addr) >> bit) & 1;
+        record(pending.addr, REG(pending.addr), 0, 0, bit, pending.pc);
+    }
+    pending.old = REG(pending.addr);
+
+    uc->uc_mcontext.gregs[REG_EFL] |= TRAP_FLAG;
+}
+
+static void trap(int sig, siginfo_t *si, void *context) {
+    ucontext_t *uc = context;
+    uint32_t value;
+    int bit = -1;
+
+    if (! pending.active) {
+        signal(SIGTRAP, SIG_DFL);
+        return;
+    }
+
+    uc->uc_mcontext.gregs[REG_EFL] &= ~TRAP_FLAG;
+
+    if (pending.write) {
+        if (pending.alias) {
+            bit = bitband_bit(pending.alias);
+            if (REG(pending.alias) & 1)
+                REG(pending.addr) |= 1u << bit;
+            else
+                REG(pending.addr) &= ~(1u << bit);
+            REG(pending.alias) = 0;
+        }
+        value = REG(pending.addr);
+        after_write(pending.addr, pending.old, value);
+        record(pending.addr, value, pending.old, 1, bit, pending.pc);
+    }
+
+    pending.active = 0;
+    close_regions();
+}
+// }}}
+
+/*
+ * regmodel_init()
+ *
+ * Map the register memory and catch the accesses of it,
+ * once at the start.
+ */
+void regmodel_init(void) {
+    struct sigaction sa;
+    unsigned int i;
+    void *p;
+
+    for (i = 0; i < NREGIONS; i++) {
+        p = mmap((void *) (uintptr_t) regions[i].base, regions[i].size,
+                PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                -1, 0);
+        if (p != (void *) (uintptr_t) regions[i].base) {
+            fprintf(stderr, "regmodel: unable to map 0x%08x\n",
+                    regions[i].base);
+            exit(1);
+        }
+    }
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_sigaction = segv;
+    sa.sa_flags = SA_SIGINFO;
+    sigaction(SIGSEGV, &sa, 0);
+    sa.sa_sigaction = trap;
+    sigaction(SIGTRAP, &sa, 0);
+
+    regmodel_reset();
+}
+
+uint32_t regmodel_peek(volatile void *reg) {
+    uint32_t value;
+
+    open_regions((uintptr_t) reg, PROT_READ);
+    value = REG((uintptr_t) reg & ~3);
+    close_regions();
+
+    return value;
+}
+
+void regmodel_poke(volatile void *reg, uint32_t value) {
+    open_regions((uintptr_t) reg, PROT_READ | PROT_WRITE);
+    REG((uintptr_t) reg & ~3) = value;
+    close_regions();
+}
+
+/*
+ * regmodel_reset()
+ *
+ * Clear all the registers to their reset values, remove all
+ * the side effects except the models, and the SPI devices.
+ */
+void regmodel_reset(void) {
+    unsigned int i;
+    GPIO_TypeDef *const gpios[] = {GPIOA, GPIOB, GPIOC, GPIOD, GPIOE, GPIOH};
+
+    for (i = 0; i < NREGIONS; i++) {
+        mprotect((void *) (uintptr_t) regions[i].base, regions[i].size,
+                PROT_READ | PROT_WRITE);
+        memset((void *) (uintptr_t) regions[i].base, 0, regions[i].size);
+    }
+    opened = (1 << NREGIONS) - 1;
+
+    // the reset values which are not zero, those used
+    RCC->CR = RCC_CR_MSION | RCC_CR_MSIRDY;
+    RCC->ICSCR = 0x0000b000;
+    GPIOA->MODER = 0xa8000000;
+    GPIOA->PUPDR = 0x64000000;
+    GPIOA->OSPEEDR = 0x00000000;
+    GPIOB->MODER = 0x00000280;
+    GPIOB->PUPDR = 0x00000100;
+    GPIOB->OSPEEDR = 0x000000c0;
+    for (i = 0; i < NSPIS; i++) {
+        spis[i]->SR = SPI_SR_TXE;
+        spis[i]->CRCPR = 0x0007;
+    }
+    REG(&SCB->CPUID) = 0x412fc231;
+
+    close_regions();
+
+    nhooks = 0;
+    regmodel_on_write(&RCC->CR, rcc_cr_write);
+    regmodel_on_write(&RCC->CFGR, rcc_cfgr_write);
+    regmodel_on_write(&RCC->CSR, rcc_csr_write);
+    for (i = 0; i < sizeof(gpios) / sizeof(gpios[0]); i++)
+        regmodel_on_write(&gpios[i]->BSRRL, gpio_bsrr_write);
+    for (i = 0; i < NSPIS; i++) {
+        regmodel_on_write(&spis[i]->DR, spi_dr_write);
+        regmodel_on_read(&spis[i]->DR, spi_dr_read);
+        spi_exchange[i] = 0;
+    }
+    regmodel_on_write(&LCD->CR, lcd_cr_write);
+    regmodel_on_write(&LCD->FCR, lcd_fcr_write);
+    regmodel_on_read(&LCD->SR, lcd_sr_read);
+    regmodel_on_write(&LCD->CLR, lcd_clr_write);
+    lcd_udr_seen = 0;
+
+    seq = 0;
+    regmodel_reads = 0;
+    regmodel_writes = 0;
+}
+
+// vim:foldmethod=marker
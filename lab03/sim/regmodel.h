@@ -0,0 +1,114 @@
+#ifndef REGMODEL_H
+#define REGMODEL_H
+
+#include <stdio.h>
+
+#include "stm32l1xx.h"
+
+/*
+ * NAME
+ * ----
+ *
+ * regmodel.h
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * A model of the STM32L1xx peripheral registers for running the
+ * ST standard peripheral drivers (stm32l1xx_gpio.c, _spi.c, _rcc.c,
+ * _lcd.c, ...) on a Linux host (x86-64), unchanged and built
+ * against the real CMSIS device header.
+ *
+ * The register blocks are memory mapped at their addresses on
+ * the chip, so SPI1, GPIOB, LCD, RCC and the rest point to
+ * them as they are.  That is the peripherals (0x40000000), their
+ * bit-band alias (0x42000000), the option bytes (0x1FF80000)
+ * and the Cortex-M3 system registers (0xE0000000, NVIC, SCB,
+ * SysTick).
+ *
+ * The memory is kept inaccessible so every access of the drivers
+ * traps, the instruction is stepped with the memory accessible
+ * and then it is made inaccessible again.  This is how each
+ * access is seen, counted and traced, and how the side effects
+ * of the hardware happen.  A write of a bit-band alias changes
+ * the bit of its register.  It costs a few microseconds per access.
+ *
+ * An access is recorded as a read, a write, or for a read-modify-
+ * write instruction (x86 'or' to memory) a read and then a write,
+ * like the separate load and store of the Cortex-M3.
+ *
+ * Side effects are functions called before a read of a register
+ * or after a write to it (regmodel_on_read(), regmodel_on_write()).
+ * They run with the peripheral registers (and those of the
+ * access) accessible, so they use them directly, without being
+ * traced.  regmodel_reset() sets the
+ * reset values and these models:
+ *
+ *  RCC    the ready flag of an oscillator follows its enable
+ *         (HSI, MSI, HSE, PLL, LSI, LSE), SWS follows SW
+ *  GPIO   a write of BSRRL/BSRRH sets/resets the bits of ODR
+ *  SPI    a write of DR sets RXNE (OVR if it was still set) and
+ *         the data to be received, from the function given to
+ *         regmodel_spi_device(), the data sent by default,
+ *         a read of DR clears RXNE
+ *  LCD    LCDEN sets ENS and RDY, a write of FCR sets FCRSF,
+ *         an update request (UDR) is done (UDD) after it has
+ *         been read once, CLR clears SOF and UDD
+ *
+ * The test sets or reads a register without a trace or side
+ * effects with regmodel_poke() and regmodel_peek().
+ *
+ * Each access is passed to the function given to regmodel_listen()
+ * and written to the file given to regmodel_trace(), as
+ *
+ *  seq R|W name+offset = value [(was old)] [bit n] pc
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  regmodel_init();
+ *  regmodel_reset();
+ *  regmodel_trace(stdout);
+ *
+ *  GPIO_SetBits(GPIOB, GPIO_Pin_6);
+ *  // 1 W GPIOB+0x18 = 0x00000040 (was 0x00000000) 0x4012ab
+ *
+ *  regmodel_peek(&GPIOB->ODR);  // 0x40
+ *
+ */
+
+typedef struct {
+    unsigned long seq;      // count of accesses, from 1
+    uint32_t addr;          // of the 32-bit word accessed
+    uint32_t value;         // read, or after the write
+    uint32_t old;           // before a write
+    char write;             // 0 read, 1 write
+    signed char bit;        // bit of a bit-band access, else -1
+    void *pc;               // instruction which accessed it
+} regmodel_access;
+
+extern unsigned long regmodel_reads;
+extern unsigned long regmodel_writes;
+
+void regmodel_init(void);
+
+void regmodel_reset(void);
+
+uint32_t regmodel_peek(volatile void *reg);
+
+void regmodel_poke(volatile void *reg, uint32_t value);
+
+void regmodel_on_read(volatile void *reg, void (*fn)(uint32_t addr));
+
+void regmodel_on_write(volatile void *reg,
+        void (*fn)(uint32_t addr, uint32_t old, uint32_t value));
+
+void regmodel_spi_device(SPI_TypeDef *spi, uint16_t (*exchange)(uint16_t));
+
+void regmodel_listen(void (*fn)(const regmodel_access *));
+
+void regmodel_trace(FILE *f);
+
+const char *regmodel_name(uint32_t addr, uint32_t *offset);
+
+#endif
@@ -0,0 +1,460 @@
+/*
+ * NAME
+ * ----
+ *
+ * regmodel_test.c - the ST drivers run against the register model
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./regmodel_test [-t]
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The standard peripheral drivers (GPIO, RCC, SPI, LCD) of
+ * ../../empty_project/Libraries are run, unchanged, against the
+ * register model (regmodel.c).  The registers are checked after
+ * each call, along with the number of register reads and writes
+ * it took, and the side effects of the model.
+ *
+ * GPIO_InitBatch() and GPIO_PinAFConfigMask() are compared with
+ * GPIO_Init() and GPIO_PinAFConfig() for each pin, for random
+ * tables of pins, the registers must be the same with fewer
+ * accesses.
+ *
+ * With -t each register access is displayed.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stm32l1xx.h"
+
+#include "regmodel.h"
+
+static unsigned long errors;
+static unsigned long checks;
+
+static unsigned long reads;
+static unsigned long writes;
+
+#define BATCH_TRIALS    100
+
+// {{{ checks
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected 0x%lx, got 0x%lx\n",
+                    name, expected, got);
+        errors++;
+    }
+}
+
+// start counting the accesses of a call
+static void count() {
+    reads = regmodel_reads;
+    writes = regmodel_writes;
+}
+
+static void check_count(const char *name, long r, long w) {
+    char s[64];
+
+    snprintf(s, sizeof(s), "%s reads", name);
+    check(s, regmodel_reads - reads, r);
+    snprintf(s, sizeof(s), "%s writes", name);
+    check(s, regmodel_writes - writes, w);
+}
+// }}}
+
+// {{{ trace
+// set from within the accesses, unseen by the compiler
+static volatile regmodel_access last;
+static volatile unsigned long seen;
+
+static void listen(const regmodel_access *a) {
+    last.seq = a->seq;
+    last.addr = a->addr;
+    last.value = a->value;
+    last.old = a->old;
+    last.write = a->write;
+    last.bit = a->bit;
+    last.pc = a->pc;
+    seen++;
+}
+
+static void check_trace() {
+    regmodel_reset();
+    regmodel_listen(listen);
+    seen = 0;
+
+    // a store is only a write
+    GPIOB->BSRRL = GPIO_Pin_7;
+    check("store seen", seen, 1);
+    check("store seq", last.seq, 1);
+    check("store addr", last.addr, GPIOB_BASE + 0x18);
+    check("store write", last.write, 1);
+    check("store bit", last.bit, -1);
+    check("store pc", last.pc != 0, 1);
+
+    // read-modify-write is both
+    GPIOB->OTYPER |= 0x5;
+    check("rmw seen", seen, 3);
+    check("rmw write", last.write, 1);
+    check("rmw value", last.value, 0x5);
+    check("rmw old", last.old, 0x0);
+
+    // a read
+    check("read", GPIOB->OTYPER, 0x5);
+    check("read seen", seen, 4);
+    check("read write", last.write, 0);
+
+    // bit-band, the register and the bit
+    *(__IO uint32_t *) (PERIPH_BB_BASE + (RCC_BASE - PERIPH_BASE) * 32) = 1;
+    check("bb addr", last.addr, RCC_BASE);
+    check("bb bit", last.bit, 0);
+    check("bb value", regmodel_peek(&RCC->CR) & 0x3, 0x3);
+
+    // peek and poke are not seen
+    regmodel_poke(&GPIOC->ODR, 0x1234);
+    check("poke", regmodel_peek(&GPIOC->ODR), 0x1234);
+    check("poke seen", seen, 5);
+
+    regmodel_listen(0);
+}
+// }}}
+
+// {{{ gpio
+static void check_gpio() {
+    GPIO_InitTypeDef gpio;
+
+    regmodel_reset();
+
+    RCC_AHBPeriphClockCmd(RCC_AHBPeriph_GPIOB, ENABLE);
+    check("clock", regmodel_peek(&RCC->AHBENR), RCC_AHBENR_GPIOBEN);
+
+    GPIO_StructInit(&gpio);
+    gpio.GPIO_Pin = GPIO_Pin_6 | GPIO_Pin_7;
+    gpio.GPIO_Mode = GPIO_Mode_OUT;
+    gpio.GPIO_OType = GPIO_OType_PP;
+    gpio.GPIO_PuPd = GPIO_PuPd_NOPULL;
+    gpio.GPIO_Speed = GPIO_Speed_40MHz;
+    count();
+    GPIO_Init(GPIOB, &gpio);
+    check("init moder", regmodel_peek(&GPIOB->MODER), 0x5280);
+    check("init speed", regmodel_peek(&GPIOB->OSPEEDR), 0xf0c0);
+    check("init pupd", regmodel_peek(&GPIOB->PUPDR), 0x0100);
+    // per pin, MODER, OSPEEDR, OTYPER and PUPDR are cleared then set
+    check_count("init", 16, 16);
+
+    count();
+    GPIO_SetBits(GPIOB, GPIO_Pin_6 | GPIO_Pin_7);
+    check_count("set", 0, 1);
+    check("set odr", regmodel_peek(&GPIOB->ODR), 0xc0);
+    check("set bsrr", regmodel_peek(&GPIOB->BSRRL), 0);
+
+    GPIO_ResetBits(GPIOB, GPIO_Pin_7);
+    check("reset odr", regmodel_peek(&GPIOB->ODR), 0x40);
+    check("read", GPIO_ReadOutputDataBit(GPIOB, GPIO_Pin_6), Bit_SET);
+
+    count();
+    GPIO_PinAFConfig(GPIOB, GPIO_PinSource9, GPIO_AF_LCD);
+    check_count("af", 2, 2);
+    check("af", regmodel_peek(&GPIOB->AFR[1]), GPIO_AF_LCD << 4);
+}
+// }}}
+
+// {{{ gpio batch
+static GPIO_TypeDef *const ports[] = {GPIOA, GPIOB, GPIOC};
+#define NPORTS (sizeof(ports) / sizeof(ports[0]))
+
+// MODER, OTYPER, OSPEEDR, PUPDR, AFR[0], AFR[1] of each port
+#define NREGS 6
+
+static void snapshot(uint32_t regs[NPORTS][NREGS]) {
+    unsigned int i;
+
+    for (i = 0; i < NPORTS; i++) {
+        regs[i][0] = regmodel_peek(&ports[i]->MODER);
+        regs[i][1] = regmodel_peek(&ports[i]->OTYPER);
+        regs[i][2] = regmodel_peek(&ports[i]->OSPEEDR);
+        regs[i][3] = regmodel_peek(&ports[i]->PUPDR);
+        regs[i][4] = regmodel_peek(&ports[i]->AFR[0]);
+        regs[i][5] = regmodel_peek(&ports[i]->AFR[1]);
+    }
+}
+
+static void restore(uint32_t regs[NPORTS][NREGS]) {
+    unsigned int i;
+
+    for (i = 0; i < NPORTS; i++) {
+        regmodel_poke(&ports[i]->MODER, regs[i][0]);
+        regmodel_poke(&ports[i]->OTYPER, regs[i][1]);
+        regmodel_poke(&ports[i]->OSPEEDR, regs[i][2]);
+        regmodel_poke(&ports[i]->PUPDR, regs[i][3]);
+        regmodel_poke(&ports[i]->AFR[0], regs[i][4]);
+        regmodel_poke(&ports[i]->AFR[1], regs[i][5]);
+    }
+}
+
+static void check_regs(const char *name,
+        uint32_t got[NPORTS][NREGS], uint32_t expected[NPORTS][NREGS]) {
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < NPORTS; i++) {
+        for (j = 0; j < NREGS; j++)
+            check(name, got[i][j], expected[i][j]);
+    }
+}
+
+static void random_regs(uint32_t regs[NPORTS][NREGS]) {
+    unsigned int i;
+    unsigned int j;
+
+    for (i = 0; i < NPORTS; i++) {
+        for (j = 0; j < NREGS; j++)
+            regs[i][j] = ((uint32_t) rand() << 16) ^ rand();
+        regs[i][1] &= 0xffff;
+    }
+}
+
+static void check_gpio_batch() {
+    GPIO_BatchTypeDef batch[4];
+    GPIO_InitTypeDef *init;
+    uint32_t start[NPORTS][NREGS];
+    uint32_t expected[NPORTS][NREGS];
+    uint32_t got[NPORTS][NREGS];
+    unsigned long ref_accesses = 0;
+    unsigned long accesses = 0;
+    unsigned int trial;
+    unsigned int n;
+    unsigned int i;
+    unsigned int pin;
+    uint16_t pins;
+    uint8_t af;
+
+    regmodel_reset();
+    srand(344);
+
+    for (trial = 0; trial < BATCH_TRIALS; trial++) {
+        n = 1 + rand() % 4;
+        for (i = 0; i < n; i++) {
+            batch[i].GPIOx = ports[rand() % NPORTS];
+            init = &batch[i].GPIO_Init;
+            init->GPIO_Pin = (rand() & 0xffff) | 1 << (rand() % 16);
+            init->GPIO_Mode = rand() % 4;
+            init->GPIO_Speed = rand() % 4;
+            init->GPIO_OType = rand() % 2;
+            init->GPIO_PuPd = rand() % 3;
+            batch[i].GPIO_AF = rand() % 16;
+        }
+        random_regs(start);
+
+        // GPIO_Init() and GPIO_PinAFConfig() for each pin
+        restore(start);
+        count();
+        for (i = 0; i < n; i++) {
+            GPIO_Init(batch[i].GPIOx, &batch[i].GPIO_Init);
+            if (GPIO_Mode_AF != batch[i].GPIO_Init.GPIO_Mode)
+                continue;
+            for (pin = 0; pin < 16; pin++) {
+                if (batch[i].GPIO_Init.GPIO_Pin & 1 << pin)
+                    GPIO_PinAFConfig(batch[i].GPIOx, pin, batch[i].GPIO_AF);
+            }
+        }
+        ref_accesses += regmodel_reads + regmodel_writes - reads - writes;
+        snapshot(expected);
+
+        restore(start);
+        count();
+        GPIO_InitBatch(batch, n);
+        accesses += regmodel_reads + regmodel_writes - reads - writes;
+        snapshot(got);
+        check_regs("batch", got, expected);
+
+        // each register at most once per entry
+        check("batch once", regmodel_writes - writes <= n * NREGS, 1);
+        check("batch rmw", regmodel_reads - reads, regmodel_writes - writes);
+
+        // the alternate functions alone
+        pins = rand() & 0xffff;
+        af = rand() % 16;
+        restore(start);
+        for (pin = 0; pin < 16; pin++) {
+            if (pins & 1 << pin)
+                GPIO_PinAFConfig(GPIOB, pin, af);
+        }
+        snapshot(expected);
+        restore(start);
+        count();
+        GPIO_PinAFConfigMask(GPIOB, pins, af);
+        snapshot(got);
+        check_regs("af mask", got, expected);
+        check("af mask writes", regmodel_writes - writes,
+                ((pins & 0xff) != 0) + ((pins >> 8) != 0));
+    }
+
+    printf("GPIO_Init/PinAFConfig %lu accesses, GPIO_InitBatch %lu\n",
+            ref_accesses, accesses);
+    check("fewer", accesses * 4 < ref_accesses, 1);
+}
+// }}}
+
+// {{{ rcc
+static void check_rcc() {
+    regmodel_reset();
+
+    // HSI on and ready, by bit-band
+    check("hsi off", RCC_GetFlagStatus(RCC_FLAG_HSIRDY), RESET);
+    count();
+    RCC_HSICmd(ENABLE);
+    check_count("hsi", 0, 1);
+    check("hsi on", RCC_GetFlagStatus(RCC_FLAG_HSIRDY), SET);
+
+    RCC_SYSCLKConfig(RCC_SYSCLKSource_HSI);
+    check("sysclk", RCC_GetSYSCLKSource(), 0x04);
+
+    // the LSE, through the CSR
+    RCC_LSEConfig(RCC_LSE_ON);
+    check("lse", RCC_GetFlagStatus(RCC_FLAG_LSERDY), SET);
+}
+// }}}
+
+// {{{ spi
+static uint16_t sent;
+
+static uint16_t device(uint16_t data) {
+    sent = data;
+
+    return data ^ 0xff;
+}
+
+static void check_spi() {
+    SPI_InitTypeDef spi;
+
+    regmodel_reset();
+    regmodel_spi_device(SPI1, device);
+
+    SPI_StructInit(&spi);
+    spi.SPI_Direction = SPI_Direction_2Lines_FullDuplex;
+    spi.SPI_Mode = SPI_Mode_Master;
+    spi.SPI_DataSize = SPI_DataSize_8b;
+    spi.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_32;
+    spi.SPI_NSS = SPI_NSS_Soft;
+    SPI_Init(SPI1, &spi);
+    SPI_Cmd(SPI1, ENABLE);
+    check("cr1", regmodel_peek(&SPI1->CR1),
+            SPI_CR1_MSTR | SPI_CR1_SSM | SPI_CR1_SSI | SPI_CR1_SPE
+            | SPI_BaudRatePrescaler_32);
+
+    check("txe", SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_TXE), SET);
+    check("no rxne", SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE), RESET);
+
+    count();
+    SPI_I2S_SendData(SPI1, 0x3c);
+    check_count("send", 0, 1);
+    check("sent", sent, 0x3c);
+    check("rxne", SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE), SET);
+
+    count();
+    check("receive", SPI_I2S_ReceiveData(SPI1), 0xc3);
+    check_count("receive", 1, 0);
+    check("rxne read", SPI_I2S_GetFlagStatus(SPI1, SPI_I2S_FLAG_RXNE), RESET);
+
+    // sent twice without a read
+    SPI_I2S_SendData(SPI1, 0x01);
+    SPI_I2S_SendData(SPI1, 0x02);
+    check("ovr", SPI_I2S_GetFlagStatus(SPI1, SPI_FLAG_OVR), SET);
+    check("ovr data", SPI_I2S_ReceiveData(SPI1), 0xfd);
+
+    // the default device echoes
+    regmodel_spi_device(SPI1, 0);
+    SPI_I2S_SendData(SPI1, 0x55);
+    check("echo", SPI_I2S_ReceiveData(SPI1), 0x55);
+}
+// }}}
+
+// {{{ lcd
+static unsigned long sr_reads;
+
+static void lcd_sr_read(uint32_t addr) {
+    sr_reads++;
+}
+
+static void check_lcd() {
+    LCD_InitTypeDef lcd;
+
+    regmodel_reset();
+
+    LCD_StructInit(&lcd);
+    lcd.LCD_Prescaler = LCD_Prescaler_1;
+    lcd.LCD_Divider = LCD_Divider_31;
+    lcd.LCD_Duty = LCD_Duty_1_4;
+    lcd.LCD_Bias = LCD_Bias_1_3;
+    lcd.LCD_VoltageSource = LCD_VoltageSource_Internal;
+    LCD_Init(&lcd);
+
+    LCD_WaitForSynchro();
+    check("fcrsf", LCD_GetFlagStatus(LCD_FLAG_FCRSF), SET);
+
+    LCD_Cmd(ENABLE);
+    check("ens", LCD_GetFlagStatus(LCD_FLAG_ENS), SET);
+    check("rdy", LCD_GetFlagStatus(LCD_FLAG_RDY), SET);
+
+    // an update, polled until done
+    LCD_Write(LCD_RAMRegister_0, 0x12345678);
+    check("ram", regmodel_peek(&LCD->RAM[0]), 0x12345678);
+    LCD_UpdateDisplayRequest();
+    check("udr", LCD_GetFlagStatus(LCD_FLAG_UDR), SET);
+    check("udd", LCD_GetFlagStatus(LCD_FLAG_UDD), SET);
+    check("udr done", LCD_GetFlagStatus(LCD_FLAG_UDR), RESET);
+    LCD_ClearFlag(LCD_FLAG_UDD);
+    check("udd clear", LCD_GetFlagStatus(LCD_FLAG_UDD), RESET);
+
+    // a side effect of the test replaces that of the model
+    regmodel_on_read(&LCD->SR, lcd_sr_read);
+    LCD_UpdateDisplayRequest();
+    while (LCD_GetFlagStatus(LCD_FLAG_UDR) && sr_reads < 10)
+        ;
+    check("hook", sr_reads, 10);
+
+    LCD_Cmd(DISABLE);
+    check("off", LCD_GetFlagStatus(LCD_FLAG_ENS), RESET);
+}
+// }}}
+
+int main(int argc, char *argv[]) {
+    regmodel_init();
+
+    if (argc > 1 && 0 == strcmp(argv[1], "-t"))
+        regmodel_trace(stdout);
+
+    check_trace();
+    check_gpio();
+    check_gpio_batch();
+    check_rcc();
+    check_spi();
+    check_lcd();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
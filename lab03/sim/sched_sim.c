@@ -0,0 +1,372 @@
+/*
+ * NAME
+ * ----
+ *
+ * sched_sim.c - latency and idle time of the scheduler
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./sched_sim
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The ARM scheduler (../ARM/sched.c) and time base
+ * (../ARM/tick.c) are run on a virtual clock, counted in
+ * microseconds, with tasks like those of ../ARM/main.c:
+ *
+ *  ui   - woken by button presses and finished bus operations
+ *  bus  - starts a 2 byte SPI transfer for each ui request and
+ *         every 100 ms to read the switches, woken again by the
+ *         (simulated) DMA interrupt when the transfer is done
+ *  lcd  - woken by the ui to refresh the display
+ *
+ * Each task run takes a fixed amount of virtual time.
+ * Interrupts (SysTick every 1 ms, DMA done and button presses)
+ * occur during the tasks or while the scheduler sleeps in
+ * tick_wait(), which is where the virtual clock jumps ahead
+ * to the next one.
+ *
+ * It reports, for each task, the latency from when it was
+ * woken to when it ran, and the percentage of the time that
+ * the processor was asleep.  The latency of any task must
+ * be no more than one run of each task (including itself,
+ * it may be woken while it runs).
+ *
+ * Some checks of the event queues are done first.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sched.h"
+
+// simulated time, microseconds
+#define RUN_US      (60 * 1000000ULL)
+#define TICK_US     1000
+#define XFER_US     260     // 2 bytes at 62.5 kb/s
+#define SWITCHES_MS 100
+
+#define NEVER       (~0ULL)
+
+// events sent to the ui task
+#define EV_PRESS    1
+#define EV_BUS_DONE 2
+
+static unsigned long errors;
+static unsigned long checks;
+
+typedef struct {
+    sched_task task;
+    const char *name;
+    unsigned int cost_us;       // virtual time of each run
+    unsigned long long woken;   // time it was woken, NEVER if not
+    unsigned long runs;
+    unsigned long long latency_sum;
+    unsigned long long latency_max;
+} sim_task;
+
+static sim_task ui_task  = {.name = "ui",  .cost_us = 40};
+static sim_task bus_task = {.name = "bus", .cost_us = 15};
+static sim_task lcd_task = {.name = "lcd", .cost_us = 1800};
+
+static sim_task *sim_tasks[] = {&ui_task, &bus_task, &lcd_task};
+#define NTASKS (sizeof(sim_tasks) / sizeof(sim_tasks[0]))
+
+static unsigned long long vnow;       // current time
+static unsigned long long idle_us;    // time spent in tick_wait()
+static unsigned long long next_tick;
+static unsigned long long next_press;
+static unsigned long long xfer_done;  // NEVER if none running
+
+static unsigned long presses;
+static unsigned long presses_handled;
+static unsigned long xfers;
+
+// {{{ simulated hardware
+/*
+ * interrupt()
+ *
+ * Run the next interrupt, at time 't', and note when
+ * any tasks were woken by it.
+ */
+static void interrupt(unsigned long long t) {
+    unsigned int i;
+
+    if (t == next_tick) {
+        next_tick += TICK_US;
+        tick();
+    } else if (t == xfer_done) {
+        xfer_done = NEVER;
+        sched_wake(&bus_task.task);
+    } else {
+        next_press = t + 200000 + rand() % 500000;
+        presses++;
+        sched_send(&ui_task.task, EV_PRESS);
+    }
+
+    if (t >= RUN_US)
+        sched_stop();
+
+    for (i = 0; i < NTASKS; i++) {
+        if (sim_tasks[i]->task.ready && NEVER == sim_tasks[i]->woken)
+            sim_tasks[i]->woken = t;
+    }
+}
+
+static unsigned long long next_interrupt() {
+    unsigned long long t = next_tick;
+
+    if (xfer_done < t)
+        t = xfer_done;
+    if (next_press < t)
+        t = next_press;
+
+    return t;
+}
+
+/*
+ * busy()
+ *
+ * The processor is busy running a task for 'us', the
+ * interrupts in that time happen before it returns.
+ */
+static void busy(unsigned int us) {
+    unsigned long long end = vnow + us;
+    unsigned long long t;
+
+    while ((t = next_interrupt()) <= end) {
+        vnow = t;
+        interrupt(t);
+    }
+    vnow = end;
+}
+
+/*
+ * tick_wait()
+ *
+ * Replaces the WFI version in timebase.c, skip ahead to
+ * the next interrupt.
+ */
+void tick_wait() {
+    unsigned long long t = next_interrupt();
+
+    idle_us += t - vnow;
+    vnow = t;
+    interrupt(t);
+}
+// }}}
+
+// {{{ tasks
+// wake and send from a task, noting when
+static void wake(sim_task *s) {
+    if (NEVER == s->woken)
+        s->woken = vnow;
+    sched_wake(&s->task);
+}
+
+static void send(sim_task *s, uint8_t event) {
+    if (NEVER == s->woken)
+        s->woken = vnow;
+    sched_send(&s->task, event);
+}
+
+static void ran(sched_task *t) {
+    sim_task *s = (sim_task *) t;
+    unsigned long long latency;
+
+    latency = vnow - s->woken;
+    s->woken = NEVER;
+    s->runs++;
+    s->latency_sum += latency;
+    if (latency > s->latency_max)
+        s->latency_max = latency;
+
+    busy(s->cost_us);
+}
+
+static int ui_request = 0;
+
+static void ui(sched_task *t) {
+    int event;
+
+    ran(t);
+
+    while ((event = sched_get(t)) != SCHED_NONE) {
+        if (EV_PRESS == event) {
+            presses_handled++;
+            ui_request = 1;
+            wake(&bus_task);
+        }
+    }
+    wake(&lcd_task);
+}
+
+static void bus(sched_task *t) {
+    static int busy_xfer = 0;
+    static int busy_ui = 0;
+
+    ran(t);
+
+    if (busy_xfer) {
+        if (xfer_done != NEVER)
+            return;
+        busy_xfer = 0;
+        if (busy_ui) {
+            busy_ui = 0;
+            send(&ui_task, EV_BUS_DONE);
+        }
+    }
+
+    if (ui_request) {
+        ui_request = 0;
+        busy_ui = 1;
+    } else if (! t->timer.active) {
+        sched_wake_after(t, SWITCHES_MS);
+    } else {
+        return;
+    }
+
+    busy_xfer = 1;
+    xfer_done = vnow + XFER_US;
+    xfers++;
+}
+
+static void lcd(sched_task *t) {
+    ran(t);
+}
+// }}}
+
+// {{{ checks
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %ld, got %ld\n", name, expected, got);
+        errors++;
+    }
+}
+
+static int order[8];
+static int norder;
+
+static void first(sched_task *t)  { order[norder++] = 1; }
+static void second(sched_task *t) { order[norder++] = 2; }
+
+static void check_queues() {
+    sched_task a;
+    sched_task b;
+    int i;
+
+    sched_init();
+    tick_init(0);
+
+    sched_add(&a, first);
+    sched_add(&b, second);
+
+    // nothing woken, nothing runs
+    check("none", sched_run_once(), 0);
+
+    // run in the order added, each once
+    sched_wake(&b);
+    sched_wake(&a);
+    sched_wake(&a);
+    check("run n", sched_run_once(), 2);
+    check("run order", order[0] * 10 + order[1], 12);
+    check("run once", sched_run_once(), 0);
+
+    // events in order, full queue drops
+    for (i = 0; i < SCHED_QUEUE_LEN + 2; i++)
+        check("send", sched_send(&a, i), i < SCHED_QUEUE_LEN - 1);
+    for (i = 0; i < SCHED_QUEUE_LEN - 1; i++)
+        check("get", sched_get(&a), i);
+    check("get empty", sched_get(&a), SCHED_NONE);
+    check("send wakes", a.ready, 1);
+
+    // timed wake, replaced by a later one, cancelled
+    sched_run_once();
+    sched_wake_after(&a, 5);
+    sched_wake_after(&a, 10);
+    for (i = 0; i < 9; i++)
+        tick();
+    check("after early", a.ready, 0);
+    tick();
+    check("after", a.ready, 1);
+    sched_run_once();
+    sched_wake_after(&b, 5);
+    sched_cancel(&b);
+    for (i = 0; i < 10; i++)
+        tick();
+    check("cancel", b.ready, 0);
+}
+// }}}
+
+int main() {
+    unsigned long long bound;
+    unsigned int i;
+    unsigned int j;
+    sim_task *s;
+
+    check_queues();
+
+    // a new list for the simulation
+    sched_init();
+    tick_init(0);
+    for (i = 0; i < NTASKS; i++)
+        sim_tasks[i]->woken = NEVER;
+    sched_add(&ui_task.task, ui);
+    sched_add(&bus_task.task, bus);
+    sched_add(&lcd_task.task, lcd);
+
+    srand(344);
+    vnow = 0;
+    next_tick = TICK_US;
+    next_press = 100000;
+    xfer_done = NEVER;
+
+    sched_wake(&ui_task.task);
+    sched_wake(&bus_task.task);
+    ui_task.woken = 0;
+    bus_task.woken = 0;
+
+    sched_run();
+
+    printf("%-5s %8s %12s %12s\n", "task", "runs", "avg us", "max us");
+    for (i = 0; i < NTASKS; i++) {
+        s = sim_tasks[i];
+        printf("%-5s %8lu %12.1f %12llu\n", s->name, s->runs,
+                s->runs ? (double) s->latency_sum / s->runs : 0.0,
+                s->latency_max);
+
+        // at most one run of each task
+        bound = 0;
+        for (j = 0; j < NTASKS; j++)
+            bound += sim_tasks[j]->cost_us;
+        check(s->name, s->latency_max <= bound, 1);
+    }
+    printf("idle  %.2f%% of %.0f s, %lu presses, %lu transfers\n",
+            100.0 * idle_us / vnow, vnow / 1e6, presses, xfers);
+
+    check("presses", presses_handled, presses);
+    check("idle", 100 * idle_us / vnow >= 90, 1);
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,76 @@
+/*
+ * NAME
+ * ----
+ *
+ * spi_dma_model.c
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * Host replacement for ../ARM/spi_dma.c.
+ *
+ * It implements the same interface (../ARM/spi_dma.h) but
+ * instead of programming the DMA each transaction is run
+ * immediately through a CPLD model (cpld_model.h).
+ * So the ARM code above it (cpld_bus.c) can be used unchanged.
+ *
+ * The model to use must be assigned to 'spi_dma_model' first.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include "spi_dma.h"
+#include "cpld_model.h"
+
+cpld_model *spi_dma_model;
+
+// number of transactions (NSS assertions)
+unsigned long spi_dma_xfers;
+
+void configure_SPI_DMA() {
+    spi_dma_xfers = 0;
+}
+
+int SPI_DMA_submit(SPI_DMA_xfer *xfer, const uint8_t *tx, uint8_t *rx,
+                    uint16_t n, void (*callback)(SPI_DMA_xfer *)) {
+    uint16_t i;
+    uint8_t miso;
+
+    if (0 == n)
+        return 0;
+
+    xfer->tx = tx;
+    xfer->rx = rx;
+    xfer->n = n;
+    xfer->callback = callback;
+
+    cpld_model_nss(spi_dma_model, 0);  // enable
+
+    for (i = 0; i < n; i++) {
+        miso = cpld_model_xfer(spi_dma_model, tx[i]);
+        if (rx)
+            rx[i] = miso;
+    }
+
+    cpld_model_nss(spi_dma_model, 1);  // disable
+
+    spi_dma_xfers++;
+
+    xfer->done = 1;
+    if (callback)
+        callback(xfer);
+
+    return 1;
+}
+
+void SPI_DMA_wait(SPI_DMA_xfer *xfer) {
+    while (! xfer->done);
+}
+
+unsigned int SPI_DMA_busy() {
+    return 0;
+}
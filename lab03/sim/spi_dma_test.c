@@ -0,0 +1,517 @@
+/*
+ * NAME
+ * ----
+ *
+ * spi_dma_test.c - the SPI DMA engine run against the register model
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./spi_dma_test [-t]
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The SPI1 transfer engine (../ARM/spi_dma.c) is built with the
+ * real device header and run, with the ST drivers, against the
+ * register model (regmodel.c).  The test adds a model of DMA1
+ * channels 2 (receive) and 3 (transmit).
+ *
+ * When the transmit channel is enabled the model runs the whole
+ * transaction.  Each byte at CMAR of channel 3 is exchanged with
+ * the device and the byte received is stored at CMAR of channel 2,
+ * then the transfer complete flags are set.  The interrupt,
+ * DMA1_Channel2_IRQHandler(), is called by the test while it is
+ * enabled (NVIC and TCIE), pending and not masked by PRIMASK
+ * (cmfunc_model.h), as the NVIC would.
+ *
+ * It checks
+ *
+ *  - the DMA clock, the SPI1 DMA requests (CR2) and the NVIC
+ *    enable of configure_SPI_DMA()
+ *
+ *  - CCR, CNDTR, CPAR and CMAR of both channels as each
+ *    transaction starts
+ *
+ *  - the order of the writes, NSS (PB5, GPIOB BSRR) low, the
+ *    receive channel and then the transmit channel enabled, and
+ *    at the end both disabled before NSS is high again
+ *
+ *  - the bytes of each transaction, exchanged with NSS low
+ *
+ *  - the queue, transactions submitted while another runs and
+ *    from a callback, and a full queue which must leave the
+ *    transaction as it was
+ *
+ *  - that PRIMASK is as it was after each submit
+ *
+ * The DMA addresses are 32 bits, so it is linked at a fixed
+ * address (-no-pie) where the buffers are below 4G.
+ *
+ * With -t each register access is displayed.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stm32l1xx.h"
+
+#include "regmodel.h"
+#include "spi_dma.h"
+
+// the device inverts some bits of each byte
+#define DEVICE_XOR  0xa5
+
+#define MAX_BYTES   64
+#define MAX_STARTS  32
+
+uint32_t cmfunc_primask;
+
+void DMA1_Channel2_IRQHandler();
+
+static unsigned long errors;
+static unsigned long checks;
+
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected 0x%lx, got 0x%lx\n",
+                    name, expected, got);
+        errors++;
+    }
+}
+
+static void check_str(const char *name, const char *got,
+                        const char *expected) {
+    checks++;
+    if (strcmp(got, expected)) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %s, got %s\n",
+                    name, expected, got);
+        errors++;
+    }
+}
+
+static uint32_t addr(const volatile void *p) {
+    return (uintptr_t) p;
+}
+
+// {{{ events
+/*
+ * The writes which must be in order, from the trace
+ *
+ *  N n     NSS low, high
+ *  R r     receive channel (2) enabled, disabled
+ *  T t     transmit channel (3) enabled, disabled
+ */
+static char events[256];
+static unsigned int nevents;
+
+static void event(char c) {
+    if (nevents < sizeof(events) - 1)
+        events[nevents++] = c;
+    events[nevents] = '\0';
+}
+
+static void clear_events() {
+    nevents = 0;
+    events[0] = '\0';
+}
+
+static void listen(const regmodel_access *a) {
+    uint32_t changed = a->value ^ a->old;
+
+    if (! a->write)
+        return;
+
+    if (a->addr == addr(&GPIOB->BSRRL)) {
+        if (a->value & (GPIO_Pin_5 << 16))
+            event('N');
+        if (a->value & GPIO_Pin_5)
+            event('n');
+    } else if (a->addr == addr(&DMA1_Channel2->CCR)) {
+        if (changed & DMA_CCR1_EN)
+            event((a->value & DMA_CCR1_EN) ? 'R' : 'r');
+    } else if (a->addr == addr(&DMA1_Channel3->CCR)) {
+        if (changed & DMA_CCR1_EN)
+            event((a->value & DMA_CCR1_EN) ? 'T' : 't');
+    }
+}
+// }}}
+
+// {{{ dma model
+typedef struct {
+    uint32_t ccr;
+    uint32_t cndtr;
+    uint32_t cpar;
+    uint32_t cmar;
+} channel;
+
+// the channels as each transaction started
+static struct {
+    channel rx;
+    channel tx;
+} started[MAX_STARTS];
+static unsigned int nstarted;
+
+// the bytes on the wire, MOSI
+static uint8_t wire[MAX_BYTES * MAX_STARTS];
+static unsigned int nwire;
+
+static void snapshot(channel *c, DMA_Channel_TypeDef *ch) {
+    c->ccr = ch->CCR;
+    c->cndtr = ch->CNDTR;
+    c->cpar = ch->CPAR;
+    c->cmar = ch->CMAR;
+}
+
+/*
+ * The transmit channel enabled, the transfer starts as TXE is set,
+ * and here it is run to its end.  Called with the peripherals
+ * accessible.
+ */
+static void dma_ccr3_write(uint32_t a, uint32_t old, uint32_t value) {
+    DMA_Channel_TypeDef *rx = DMA1_Channel2;
+    DMA_Channel_TypeDef *tx = DMA1_Channel3;
+    const uint8_t *src;
+    uint8_t *dst;
+    uint32_t i;
+
+    if (! (value & DMA_CCR1_EN) || (old & DMA_CCR1_EN))
+        return;
+
+    if (nstarted < MAX_STARTS) {
+        snapshot(&started[nstarted].rx, rx);
+        snapshot(&started[nstarted].tx, tx);
+    }
+    nstarted++;
+
+    check("rx enabled", rx->CCR & DMA_CCR1_EN, DMA_CCR1_EN);
+    check("dma requests", SPI1->CR2 & (SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN),
+            SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+    check("nss low", GPIOB->ODR & GPIO_Pin_5, 0);
+    check("cndtr", tx->CNDTR, rx->CNDTR);
+
+    src = (const uint8_t *) (uintptr_t) tx->CMAR;
+    dst = (uint8_t *) (uintptr_t) rx->CMAR;
+    for (i = 0; i < tx->CNDTR; i++) {
+        if (nwire < sizeof(wire))
+            wire[nwire++] = *src;
+        *dst = *src ^ DEVICE_XOR;
+        if (tx->CCR & DMA_CCR1_MINC)
+            src++;
+        if (rx->CCR & DMA_CCR1_MINC)
+            dst++;
+    }
+
+    tx->CNDTR = 0;
+    rx->CNDTR = 0;
+    DMA1->ISR |= DMA_ISR_GIF2 | DMA_ISR_TCIF2 | DMA_ISR_GIF3 | DMA_ISR_TCIF3;
+}
+
+// a global flag (CGIFx) clears all of its channel, the others their own
+static void dma_ifcr_write(uint32_t a, uint32_t old, uint32_t value) {
+    uint32_t clear = value;
+    int ch;
+
+    for (ch = 0; ch < 7; ch++) {
+        if (value & 1u << (4 * ch))
+            clear |= 0xfu << (4 * ch);
+    }
+
+    DMA1->ISR &= ~clear;
+    DMA1->IFCR = 0;
+}
+
+static int irq_pending() {
+    return (regmodel_peek(&NVIC->ISER[0]) & 1u << DMA1_Channel2_IRQn)
+        && (regmodel_peek(&DMA1_Channel2->CCR) & DMA_CCR1_TCIE)
+        && (regmodel_peek(&DMA1->ISR) & DMA_ISR_TCIF2);
+}
+
+// the interrupt, as long as it is pending and unmasked
+static void run_irq() {
+    int n = 0;
+
+    if (cmfunc_primask)
+        return;
+
+    while (irq_pending() && n++ < MAX_STARTS)
+        DMA1_Channel2_IRQHandler();
+
+    check("irq cleared", irq_pending(), 0);
+}
+// }}}
+
+// {{{ setup
+static void setup() {
+    regmodel_reset();
+    regmodel_on_write(&DMA1_Channel3->CCR, dma_ccr3_write);
+    regmodel_on_write(&DMA1->IFCR, dma_ifcr_write);
+    regmodel_listen(listen);
+
+    cmfunc_primask = 0;
+    nstarted = 0;
+    nwire = 0;
+
+    configure_SPI_DMA();
+
+    clear_events();
+}
+
+static void fill(uint8_t *buf, unsigned int n, unsigned int seed) {
+    unsigned int i;
+
+    for (i = 0; i < n; i++)
+        buf[i] = seed * 37 + i * 11;
+}
+
+/*
+ * The channels of start 'k' for a transaction of 'n' bytes
+ * from 'tx' to 'rx' (0, discarded).
+ */
+static void check_start(unsigned int k, const uint8_t *tx, const uint8_t *rx,
+                        uint16_t n) {
+    const uint32_t rx_ccr = DMA_CCR1_EN | DMA_CCR1_TCIE | DMA_CCR1_PL;
+    const uint32_t tx_ccr = DMA_CCR1_EN | DMA_CCR1_DIR | DMA_CCR1_MINC
+                            | DMA_CCR1_PL_1;
+
+    if (k >= nstarted || k >= MAX_STARTS) {
+        check("started", nstarted > k, 1);
+        return;
+    }
+
+    // RX, SPI1->DR -> rx, byte sizes, very high priority
+    check("rx ccr", started[k].rx.ccr, rx ? (rx_ccr | DMA_CCR1_MINC) : rx_ccr);
+    check("rx cndtr", started[k].rx.cndtr, n);
+    check("rx cpar", started[k].rx.cpar, addr(&SPI1->DR));
+    if (rx)
+        check("rx cmar", started[k].rx.cmar, addr(rx));
+    else
+        check("rx discard", started[k].rx.cmar != 0, 1);
+
+    // TX, tx -> SPI1->DR, high priority, no interrupt
+    check("tx ccr", started[k].tx.ccr, tx_ccr);
+    check("tx cndtr", started[k].tx.cndtr, n);
+    check("tx cpar", started[k].tx.cpar, addr(&SPI1->DR));
+    check("tx cmar", started[k].tx.cmar, addr(tx));
+}
+// }}}
+
+// {{{ configure
+static void check_configure() {
+    setup();
+
+    check("dma clock", regmodel_peek(&RCC->AHBENR) & RCC_AHBENR_DMA1EN,
+            RCC_AHBENR_DMA1EN);
+    check("cr2", regmodel_peek(&SPI1->CR2) & (SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN),
+            SPI_CR2_TXDMAEN | SPI_CR2_RXDMAEN);
+    check("nvic", (regmodel_peek(&NVIC->ISER[0]) >> DMA1_Channel2_IRQn) & 1, 1);
+    check("tcie", regmodel_peek(&DMA1_Channel2->CCR), DMA_CCR1_TCIE);
+    check("tx ccr", regmodel_peek(&DMA1_Channel3->CCR), 0);
+    check("nss high", regmodel_peek(&GPIOB->ODR) & GPIO_Pin_5, GPIO_Pin_5);
+    check("idle", SPI_DMA_busy(), 0);
+}
+// }}}
+
+// {{{ one
+static uint8_t tx_buf[MAX_STARTS][MAX_BYTES];
+static uint8_t rx_buf[MAX_STARTS][MAX_BYTES];
+
+static void check_one() {
+    SPI_DMA_xfer xfer;
+    unsigned int i;
+
+    setup();
+    fill(tx_buf[0], 5, 1);
+    memset(rx_buf[0], 0, sizeof(rx_buf[0]));
+
+    check("submit", SPI_DMA_submit(&xfer, tx_buf[0], rx_buf[0], 5, 0), 1);
+    check("primask", cmfunc_primask, 0);
+    check("not done", xfer.done, 0);
+    check("busy", SPI_DMA_busy(), 1);
+    check_start(0, tx_buf[0], rx_buf[0], 5);
+
+    run_irq();
+    check("done", xfer.done, 1);
+    check("not busy", SPI_DMA_busy(), 0);
+    check_str("order", events, "NRTrtn");
+    check("nss", regmodel_peek(&GPIOB->ODR) & GPIO_Pin_5, GPIO_Pin_5);
+
+    check("bytes", nwire, 5);
+    for (i = 0; i < 5; i++) {
+        check("mosi", wire[i], tx_buf[0][i]);
+        check("miso", rx_buf[0][i], tx_buf[0][i] ^ DEVICE_XOR);
+    }
+
+    // the received bytes discarded
+    clear_events();
+    check("discard", SPI_DMA_submit(&xfer, tx_buf[0], 0, 2, 0), 1);
+    check_start(1, tx_buf[0], 0, 2);
+    run_irq();
+    check("discard done", xfer.done, 1);
+    check_str("discard order", events, "NRTrtn");
+
+    // nothing to send
+    check("empty", SPI_DMA_submit(&xfer, tx_buf[0], rx_buf[0], 0, 0), 0);
+    check("empty started", nstarted, 2);
+}
+// }}}
+
+// {{{ queue
+static SPI_DMA_xfer xfers[MAX_STARTS];
+static SPI_DMA_xfer chained;
+
+static int order[MAX_STARTS];
+static unsigned int norder;
+
+static void done(SPI_DMA_xfer *xfer) {
+    if (norder < MAX_STARTS)
+        order[norder++] = xfer - xfers;
+}
+
+// from the interrupt, submits another
+static void done_chain(SPI_DMA_xfer *xfer) {
+    uint32_t primask = cmfunc_primask;
+
+    done(xfer);
+
+    fill(tx_buf[9], 3, 9);
+    check("chain", SPI_DMA_submit(&chained, tx_buf[9], rx_buf[9], 3, 0), 1);
+    check("chain primask", cmfunc_primask, primask);
+}
+
+static void check_queue() {
+    unsigned int i;
+
+    setup();
+    norder = 0;
+
+    for (i = 0; i < 3; i++) {
+        fill(tx_buf[i], i + 2, i);
+        check("queue submit", SPI_DMA_submit(&xfers[i], tx_buf[i], rx_buf[i],
+                    i + 2, (0 == i) ? done_chain : done), 1);
+    }
+    // only the first runs until the interrupt
+    check("queue started", nstarted, 1);
+    check("queue done", xfers[0].done, 0);
+
+    // with the interrupts masked, as from a handler, they stay masked
+    cmfunc_primask = 1;
+    fill(tx_buf[3], 4, 3);
+    check("masked submit", SPI_DMA_submit(&xfers[3], tx_buf[3], rx_buf[3], 4,
+                done), 1);
+    check("masked primask", cmfunc_primask, 1);
+    run_irq();
+    check("masked", xfers[0].done, 0);
+    cmfunc_primask = 0;
+
+    run_irq();
+    check("queue not busy", SPI_DMA_busy(), 0);
+    check("queue all started", nstarted, 5);
+    for (i = 0; i < 4; i++) {
+        check("queue all done", xfers[i].done, 1);
+        check_start(i, tx_buf[i], rx_buf[i], (3 == i) ? 4 : i + 2);
+        check("queue miso", rx_buf[i][1], tx_buf[i][1] ^ DEVICE_XOR);
+    }
+    check("chained done", chained.done, 1);
+    check_start(4, tx_buf[9], rx_buf[9], 3);
+
+    check("callbacks", norder, 4);
+    for (i = 0; i < norder; i++)
+        check("callback order", order[i], i);
+
+    check_str("queue order", events, "NRTrtnNRTrtnNRTrtnNRTrtnNRTrtn");
+
+    // the callback of the last one submits to the empty queue,
+    // it is started once, by SPI_DMA_submit()
+    setup();
+    norder = 0;
+    fill(tx_buf[0], 2, 0);
+    check("last submit", SPI_DMA_submit(&xfers[0], tx_buf[0], rx_buf[0], 2,
+                done_chain), 1);
+    run_irq();
+    check("last started", nstarted, 2);
+    check("last not busy", SPI_DMA_busy(), 0);
+    check("last chained done", chained.done, 1);
+    check_start(1, tx_buf[9], rx_buf[9], 3);
+    check_str("last order", events, "NRTrtnNRTrtn");
+}
+// }}}
+
+// {{{ full
+static void check_full() {
+    SPI_DMA_xfer extra;
+    unsigned int i;
+
+    setup();
+
+    // one is always left empty
+    for (i = 0; i < SPI_DMA_QUEUE_LEN - 1; i++) {
+        fill(tx_buf[i], 2, i);
+        check("fill", SPI_DMA_submit(&xfers[i], tx_buf[i], rx_buf[i], 2, 0), 1);
+    }
+
+    extra.tx = tx_buf[20];
+    extra.rx = rx_buf[20];
+    extra.n = 7;
+    extra.callback = 0;
+    extra.done = 1;
+
+    check("full", SPI_DMA_submit(&extra, tx_buf[0], rx_buf[0], 2, done), 0);
+    check("full primask", cmfunc_primask, 0);
+    check("full done", extra.done, 1);
+    check("full tx", extra.tx == tx_buf[20], 1);
+    check("full rx", extra.rx == rx_buf[20], 1);
+    check("full n", extra.n, 7);
+    check("full callback", extra.callback == 0, 1);
+
+    run_irq();
+    check("full started", nstarted, SPI_DMA_QUEUE_LEN - 1);
+    for (i = 0; i < SPI_DMA_QUEUE_LEN - 1; i++)
+        check("full all done", xfers[i].done, 1);
+
+    // and there is room again
+    check("room", SPI_DMA_submit(&extra, tx_buf[0], rx_buf[0], 2, 0), 1);
+    check("room not done", extra.done, 0);
+    run_irq();
+    check("room done", extra.done, 1);
+}
+// }}}
+
+int main(int argc, char *argv[]) {
+    regmodel_init();
+
+    if (argc > 1 && 0 == strcmp(argv[1], "-t"))
+        regmodel_trace(stdout);
+
+    // the DMA addresses are 32 bits
+    check("low buffers", (uintptr_t) tx_buf >> 31 >> 1, 0);
+
+    check_configure();
+    check_one();
+    check_queue();
+    check_full();
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker
@@ -0,0 +1,226 @@
+/*
+ * NAME
+ * ----
+ *
+ * timebase_test.c - test of the millisecond time base and timers
+ *
+ * SYNOPSIS
+ * --------
+ *
+ *  ./timebase_test
+ *
+ * DESCRIPTION
+ * -----------
+ *
+ * The ARM time keeping code (../ARM/tick.c) is run against
+ * a simulated SysTick.  tick_wait(), which sleeps until the
+ * next interrupt on the board, instead calls tick() here so
+ * each wait is exactly one millisecond.
+ *
+ * now() and delay_ms() are checked for their timing and the
+ * one-shot timers for when and in what order they expire,
+ * stopping, restarting from a callback and the wrap of the
+ * 32-bit time.
+ *
+ * The exit status is non-zero if any check failed.
+ *
+ * AUTHOR
+ * ------
+ *
+ * Jeremiah Mahler <jmmahler@gmail.com>
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "tick.h"
+
+#define NTIMERS 16
+
+static unsigned long errors;
+static unsigned long checks;
+
+// record of the timer callbacks
+static tick_timer timers[NTIMERS];
+static uint32_t fired_at[NTIMERS];
+static int fired_order[64];
+static int nfired;
+
+// {{{ simulated hardware
+/*
+ * tick_wait()
+ *
+ * Replaces the WFI version in timebase.c, the next
+ * interrupt is always the SysTick.
+ */
+void tick_wait() {
+    tick();
+}
+
+static void run(uint32_t ms) {
+    while (ms--)
+        tick();
+}
+// }}}
+
+// {{{ checks
+static void check(const char *name, long got, long expected) {
+    checks++;
+    if (got != expected) {
+        if (errors < 10)
+            fprintf(stderr, "%s: expected %ld, got %ld\n", name, expected, got);
+        errors++;
+    }
+}
+
+static void reset(uint32_t start) {
+    int i;
+
+    tick_init(start);
+    nfired = 0;
+    for (i = 0; i < NTIMERS; i++)
+        fired_at[i] = 0;
+}
+
+// callbacks
+static void record(tick_timer *t) {
+    int i = t - timers;
+
+    fired_at[i] = now();
+    if (nfired < 64)
+        fired_order[nfired++] = i;
+}
+
+// restarts itself every 10 ms, 5 times
+static void periodic(tick_timer *t) {
+    record(t);
+    if (nfired < 5)
+        timer_start(t, 10, periodic);
+}
+
+// stops timer 1 which expires at the same time
+static void stop_other(tick_timer *t) {
+    record(t);
+    timer_stop(&timers[1]);
+}
+// }}}
+
+int main() {
+    uint32_t start;
+    uint32_t ms;
+    int i;
+
+    // now() counts the ticks
+    reset(0);
+    check("start", now(), 0);
+    run(123);
+    check("now", now(), 123);
+
+    // delay_ms() waits for at least 'ms', at most one more
+    for (ms = 0; ms < 50; ms++) {
+        start = now();
+        delay_ms(ms);
+        check("delay_ms min", now() - start >= ms, 1);
+        check("delay_ms max", now() - start <= ms + 1, 1);
+    }
+
+    // a single timer
+    reset(1000);
+    timer_start(&timers[0], 25, record);
+    run(24);
+    check("single early", fired_at[0], 0);
+    check("single active", timers[0].active, 1);
+    run(1);
+    check("single", fired_at[0], 1025);
+    check("single inactive", timers[0].active, 0);
+    run(100);
+    check("single once", nfired, 1);
+
+    // a zero timer expires on the next tick
+    reset(0);
+    timer_start(&timers[0], 0, record);
+    run(1);
+    check("zero", fired_at[0], 1);
+
+    // timers expire in order, those at the same time in
+    // the order they were started
+    reset(0);
+    timer_start(&timers[0], 30, record);
+    timer_start(&timers[1], 10, record);
+    timer_start(&timers[2], 20, record);
+    timer_start(&timers[3], 10, record);
+    run(50);
+    check("order n", nfired, 4);
+    check("order 0", fired_order[0], 1);
+    check("order 1", fired_order[1], 3);
+    check("order 2", fired_order[2], 2);
+    check("order 3", fired_order[3], 0);
+    check("order at", fired_at[3], 10);
+
+    // stop and restart
+    reset(0);
+    timer_start(&timers[0], 10, record);
+    timer_start(&timers[1], 20, record);
+    run(5);
+    timer_stop(&timers[0]);
+    timer_stop(&timers[0]);  // stopping twice is harmless
+    timer_start(&timers[1], 40, record);  // restart while active
+    run(30);
+    check("stopped", nfired, 0);
+    run(15);
+    check("restarted n", nfired, 1);
+    check("restarted at", fired_at[1], 45);
+
+    // periodic, restarting from the callback
+    reset(0);
+    timer_start(&timers[0], 10, periodic);
+    run(100);
+    check("periodic n", nfired, 5);
+    check("periodic last", fired_at[0], 50);
+
+    // a callback stopping a timer which would expire on the same tick
+    reset(0);
+    timer_start(&timers[0], 10, stop_other);
+    timer_start(&timers[1], 10, record);
+    run(20);
+    check("stop other n", nfired, 1);
+
+    // the 32-bit time wraps
+    reset(0xFFFFFFF0);
+    timer_start(&timers[0], 0x20, record);
+    timer_start(&timers[1], 0x08, record);
+    start = now();
+    delay_ms(0x18);
+    check("wrap delay", now() - start >= 0x18, 1);
+    check("wrap early", nfired, 1);
+    check("wrap first", fired_order[0], 1);
+    run(0x10);
+    check("wrap n", nfired, 2);
+    check("wrap at", fired_at[0], 0x10);
+
+    // random timers expire at their time and in order
+    srand(344);
+    reset(0xFFFF0000);
+    for (i = 0; i < NTIMERS; i++)
+        timer_start(&timers[i], 1 + rand() % 199, record);
+    run(200);
+    check("random n", nfired, NTIMERS);
+    for (i = 1; i < nfired; i++) {
+        check("random order", (int32_t) (fired_at[fired_order[i]]
+                    - fired_at[fired_order[i - 1]]) >= 0, 1);
+    }
+    for (i = 0; i < NTIMERS; i++)
+        check("random at", timers[i].expires, fired_at[i]);
+
+    if (errors) {
+        printf("FAIL: %lu of %lu checks\n", errors, checks);
+        return 1;
+    }
+
+    printf("PASS: %lu checks\n", checks);
+
+    return 0;
+}
+
+// vim:foldmethod=marker